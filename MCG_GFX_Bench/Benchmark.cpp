@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+
+// Utility includes.
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+// Threading includes.
+#include <thread>
+
+/// <summary> Times the given case, first finding how many operations make a repetition last long enough, then timing each repetition. </summary>
+/// <param name="_name"> The name of what is measured, such as the function. </param>
+/// <param name="_case"> The variant of what is measured, such as the kind of input. </param>
+/// <param name="_raysPerOp"> The number of rays each operation traces or tests, or <c>0</c> if it works on no rays. </param>
+/// <param name="_operations"> The function that runs the given number of operations. </param>
+void Benchmarking::Runner::Run(const std::string& _name, const std::string& _case, const double _raysPerOp, const Operations& _operations)
+{
+	// Skip the case if it does not match the filter.
+	std::string fullName = _name + "/" + _case;
+	if (!m_filter.empty() && fullName.find(m_filter) == std::string::npos) { return; }
+	if (m_listOnly) { std::cout << fullName << std::endl; return; }
+
+	// Keep growing the number of operations until they take long enough to time, which also warms the caches and branch predictors.
+	uint64_t iterations = 1;
+	double milliseconds = time(_operations, iterations);
+	while (milliseconds < m_minMilliseconds)
+	{
+		double scale = (milliseconds > 0) ? (m_minMilliseconds / milliseconds) * 1.2 : 10;
+		iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 10.0));
+		milliseconds = time(_operations, iterations);
+	}
+
+	// Time each repetition.
+	std::vector<double> timings(m_repetitions);
+	for (uint32_t i = 0; i < m_repetitions; i++) { timings[i] = time(_operations, iterations) * 1e6 / iterations; }
+	std::sort(timings.begin(), timings.end());
+
+	// Save the result.
+	Result result;
+	result.m_name = _name;
+	result.m_case = _case;
+	result.m_iterations = iterations;
+	result.m_repetitions = m_repetitions;
+	result.m_nanosecondsPerOp = (m_repetitions % 2 == 1) ? timings[m_repetitions / 2] : (timings[m_repetitions / 2 - 1] + timings[m_repetitions / 2]) / 2;
+	result.m_minNanosecondsPerOp = timings.front();
+	result.m_raysPerOp = _raysPerOp;
+	m_results.push_back(result);
+
+	// Print the result as soon as it is known.
+	std::cout << std::left << std::setw(44) << fullName << std::right << std::fixed << std::setprecision(2) << std::setw(12) << result.m_nanosecondsPerOp << " ns/op" << std::setw(12) << result.m_minNanosecondsPerOp << " ns/op min";
+	if (_raysPerOp > 0) { std::cout << std::setw(12) << result.GetRaysPerSecond() / 1e6 << " Mrays/s"; }
+	std::cout << std::defaultfloat << std::endl;
+}
+
+/// <summary> Writes every result to the given file as JSON, along with the machine they were run on. </summary>
+/// <param name="_path"> The path of the file, which is replaced if it exists. </param>
+/// <returns> <c>true</c> if the whole file was written; otherwise, <c>false</c>. </returns>
+bool Benchmarking::Runner::WriteJSON(const std::string& _path) const
+{
+	std::ofstream file(_path, std::ios::trunc);
+	if (!file) { return false; }
+
+	// Describe the machine and build, so results from different builds can be told apart.
+#ifdef NDEBUG
+	const char* build = "release";
+#else
+	const char* build = "debug";
+#endif
+	file << std::setprecision(9) << "{" << std::endl << "  \"build\": \"" << build << "\"," << std::endl << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << std::endl << "  \"benchmarks\": [" << std::endl;
+
+	// Write each result.
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		const Result& result = m_results[i];
+		file << "    { \"name\": \"" << result.m_name << "\", \"case\": \"" << result.m_case << "\", \"iterations\": " << result.m_iterations << ", \"repetitions\": " << result.m_repetitions
+			<< ", \"ns_per_op\": " << result.m_nanosecondsPerOp << ", \"min_ns_per_op\": " << result.m_minNanosecondsPerOp << ", \"rays_per_op\": " << result.m_raysPerOp << ", \"rays_per_second\": " << result.GetRaysPerSecond() << " }"
+			<< ((i + 1 < m_results.size()) ? "," : "") << std::endl;
+	}
+
+	file << "  ]" << std::endl << "}" << std::endl;
+	return (bool)file;
+}
+
+/// <summary> Writes every result to the given file as CSV, one row per case after a header row. </summary>
+/// <param name="_path"> The path of the file, which is replaced if it exists. </param>
+/// <returns> <c>true</c> if the whole file was written; otherwise, <c>false</c>. </returns>
+bool Benchmarking::Runner::WriteCSV(const std::string& _path) const
+{
+	std::ofstream file(_path, std::ios::trunc);
+	if (!file) { return false; }
+
+	file << std::setprecision(9) << "name,case,iterations,repetitions,ns_per_op,min_ns_per_op,rays_per_op,rays_per_second" << std::endl;
+	for (const Result& result : m_results) { file << result.m_name << "," << result.m_case << "," << result.m_iterations << "," << result.m_repetitions << "," << result.m_nanosecondsPerOp << "," << result.m_minNanosecondsPerOp << "," << result.m_raysPerOp << "," << result.GetRaysPerSecond() << std::endl; }
+
+	return (bool)file;
+}
+
+/// <summary> Times how long the given number of operations take. </summary>
+/// <param name="_operations"> The function that runs the operations. </param>
+/// <param name="_iterations"> The number of operations to run. </param>
+/// <returns> The time taken in milliseconds. </returns>
+double Benchmarking::Runner::time(const Operations& _operations, const uint64_t _iterations)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	_operations(_iterations);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
\ No newline at end of file
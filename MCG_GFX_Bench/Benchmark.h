@@ -0,0 +1,101 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Utility includes.
+#include <string>
+#include <vector>
+#include <functional>
+
+// Typedef includes.
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Benchmarking
+{
+	/// <summary> Represents the timings of a single benchmark case. </summary>
+	struct Result
+	{
+		/// <summary> The name of what was measured, such as the function. </summary>
+		std::string m_name;
+
+		/// <summary> The variant of what was measured, such as the kind of input. </summary>
+		std::string m_case;
+
+		/// <summary> The number of operations run in each repetition. </summary>
+		uint64_t m_iterations;
+
+		/// <summary> The number of timed repetitions. </summary>
+		uint32_t m_repetitions;
+
+		/// <summary> The median time of a single operation across every repetition, in nanoseconds. </summary>
+		double m_nanosecondsPerOp;
+
+		/// <summary> The fastest time of a single operation across every repetition, in nanoseconds. </summary>
+		double m_minNanosecondsPerOp;
+
+		/// <summary> The number of rays each operation traces or tests, or <c>0</c> if it works on no rays. </summary>
+		double m_raysPerOp;
+
+		/// <summary> Calculates how many rays are handled per second at the median speed. </summary>
+		/// <returns> The number of rays per second, or <c>0</c> if the operation works on no rays. </returns>
+		inline double GetRaysPerSecond() const { return (m_nanosecondsPerOp > 0) ? m_raysPerOp * 1e9 / m_nanosecondsPerOp : 0; }
+	};
+
+	/// <summary> Runs benchmarks, working out how many operations to time so each repetition lasts long enough to measure, and collects their results. </summary>
+	class Runner
+	{
+	public:
+		/// <summary> A function that runs the given number of operations. </summary>
+		typedef std::function<void(uint64_t)> Operations;
+
+		/// <summary> Creates a runner with the given timing options. </summary>
+		/// <param name="_minMilliseconds"> The shortest time each repetition should last. </param>
+		/// <param name="_repetitions"> The number of timed repetitions for each case. </param>
+		/// <param name="_filter"> Only cases whose full name contains this are run, or empty to run every case. </param>
+		Runner(const double _minMilliseconds, const uint32_t _repetitions, const std::string& _filter) : m_minMilliseconds(_minMilliseconds), m_repetitions(_repetitions), m_filter(_filter), m_listOnly(false) { }
+
+		/// <summary> Sets whether cases are only printed rather than run. </summary>
+		/// <param name="_listOnly"> <c>true</c> to only print the name of each case; otherwise, <c>false</c>. </param>
+		inline void SetListOnly(const bool _listOnly) { m_listOnly = _listOnly; }
+
+		void Run(const std::string&, const std::string&, double, const Operations&);
+
+		/// <summary> Gets the result of every case that has been run. </summary>
+		/// <returns> The results, in the order they were run. </returns>
+		inline const std::vector<Result>& GetResults() const { return m_results; }
+
+		bool WriteJSON(const std::string&) const;
+
+		bool WriteCSV(const std::string&) const;
+	private:
+		/// <summary> The shortest time each repetition should last. </summary>
+		double m_minMilliseconds;
+
+		/// <summary> The number of timed repetitions for each case. </summary>
+		uint32_t m_repetitions;
+
+		/// <summary> Only cases whose full name contains this are run. </summary>
+		std::string m_filter;
+
+		/// <summary> Whether cases are only printed rather than run. </summary>
+		bool m_listOnly;
+
+		/// <summary> The result of every case that has been run. </summary>
+		std::vector<Result> m_results;
+
+		static double time(const Operations&, uint64_t);
+	};
+
+	/// <summary> Folds every byte of the given value into memory the compiler cannot see through, so that the work done to create it cannot be optimised away. </summary>
+	/// <param name="_value"> The value to keep. </param>
+	template<typename T> inline void KeepAlive(const T& _value)
+	{
+		static volatile uint8_t sink = 0;
+		const uint8_t* bytes = (const uint8_t*)&_value;
+		uint8_t folded = 0;
+		for (size_t i = 0; i < sizeof(T); i++) { folded ^= bytes[i]; }
+		sink = folded;
+		(void)sink;
+	}
+}
+#endif
\ No newline at end of file
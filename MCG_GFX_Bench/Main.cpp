@@ -0,0 +1,366 @@
+// Data includes.
+#include "World.h"
+#include "Sphere.h"
+#include "Buffer.h"
+#include "Colour.h"
+#include "RenderSettings.h"
+#include "Benchmark.h"
+#include "Scaling.h"
+#include "SceneGenerator.h"
+
+// Threading includes.
+#include "ThreadPool.h"
+
+// Utility includes.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+
+/// <summary> The number of different inputs each case cycles through, so that no single input can be cached or predicted. Must be a power of two. </summary>
+const uint32_t InputCount = 1024;
+
+/// <summary> Creates rays from in front of a unit sphere at the origin, each aimed to pass the centre at a random distance within the given range. </summary>
+/// <param name="_minDistance"> The closest each ray passes to the centre. </param>
+/// <param name="_maxDistance"> The furthest each ray passes from the centre. </param>
+/// <param name="io_random"> The random number generator. </param>
+/// <returns> The created rays. </returns>
+std::vector<Ray> createSphereRays(const float_t _minDistance, const float_t _maxDistance, std::mt19937& io_random)
+{
+	std::uniform_real_distribution<float_t> distance(_minDistance, _maxDistance), axis(-1, 1);
+	std::vector<Ray> rays(InputCount);
+	for (Ray& ray : rays)
+	{
+		// Start somewhere in front of the sphere.
+		glm::vec3 origin(axis(io_random) * 0.5f, axis(io_random) * 0.5f, -10);
+		float_t distanceToCentre = glm::length(origin);
+		glm::vec3 toCentre = -origin / distanceToCentre;
+
+		// Turn away from the centre in a random direction, just enough that the closest the ray gets to the centre is the chosen distance.
+		glm::vec3 sideways = glm::normalize(glm::cross(toCentre, glm::vec3(axis(io_random), axis(io_random), 1)));
+		float_t sine = distance(io_random) / distanceToCentre;
+		ray = Ray(origin, glm::normalize(toCentre * glm::sqrt(1 - sine * sine) + sideways * sine));
+	}
+	return rays;
+}
+
+/// <summary> Measures the intersection test between a single sphere and a ray that hits, misses, and only just hits. </summary>
+/// <param name="io_runner"> The runner with which to time the cases. </param>
+void benchmarkSphere(Benchmarking::Runner& io_runner)
+{
+	std::mt19937 random(1);
+	Shapes::Sphere sphere(glm::vec3(0, 0, 0), 1, Shapes::ShapeProperties(Colour::Red(), 0.5f));
+
+	// Time each kind of ray.
+	const char* cases[3] = { "hit", "miss", "grazing" };
+	const float_t minDistances[3] = { 0.0f, 1.2f, 0.99f }, maxDistances[3] = { 0.9f, 3.0f, 0.999f };
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		std::vector<Ray> rays = createSphereRays(minDistances[i], maxDistances[i], random);
+		io_runner.Run("Sphere::RayIntersects", cases[i], 1, [&sphere, &rays](uint64_t _iterations)
+		{
+			for (uint64_t j = 0; j < _iterations; j++) { Benchmarking::KeepAlive(sphere.RayIntersects(rays[j & (InputCount - 1)])); }
+		});
+	}
+
+	// Time shading points all around the sphere, so some face away from the light.
+	std::uniform_real_distribution<float_t> axis(-1, 1);
+	std::vector<glm::vec3> normals(InputCount);
+	for (glm::vec3& normal : normals) { normal = glm::normalize(glm::vec3(axis(random), axis(random), axis(random)) + glm::vec3(0, 0, 0.001f)); }
+	PointLight light(glm::vec3(-20, 0, -20), 2.0f, Colour(94, 85, 64));
+	io_runner.Run("Sphere::Shade", "surface", 0, [&sphere, &normals, &light](uint64_t _iterations)
+	{
+		for (uint64_t j = 0; j < _iterations; j++) { const glm::vec3& normal = normals[j & (InputCount - 1)]; Benchmarking::KeepAlive(sphere.Shade(normal, normal, light)); }
+	});
+}
+
+/// <summary> Measures creating camera rays and tracing them through the given scene, once for each reflection depth, then tracing them in packets of each size. </summary>
+/// <param name="io_runner"> The runner with which to time the cases. </param>
+/// <param name="_scene"> The scene to trace through. </param>
+void benchmarkCamera(Benchmarking::Runner& io_runner, const Scenes::Scene& _scene)
+{
+	// Spread the pixels over the whole screen, so every sphere and the background are seen.
+	World world(glm::vec2(512, 512), _scene);
+	const Rendering::Camera& camera = world.GetCamera();
+	std::vector<glm::vec2> pixels(InputCount);
+	for (uint32_t i = 0; i < InputCount; i++) { pixels[i] = glm::vec2((i % 32) * 16 + 8, (i / 32) * 16 + 8); }
+
+	io_runner.Run("Camera::CreateRay", "screen", 1, [&camera, &pixels](uint64_t _iterations)
+	{
+		for (uint64_t j = 0; j < _iterations; j++) { Benchmarking::KeepAlive(camera.CreateRay(pixels[j & (InputCount - 1)])); }
+	});
+
+	// Trace the same primary rays with each reflection limit, then with the full limit and each way of ending paths early.
+	std::vector<Ray> rays(InputCount);
+	for (uint32_t i = 0; i < InputCount; i++) { rays[i] = camera.CreateRay(pixels[i]); }
+	std::vector<std::pair<std::string, Rendering::PathTermination>> terminations;
+	for (uint8_t depth = 0; depth <= Rendering::PathTermination::DefaultReflectionLimit; depth++) { terminations.push_back(std::make_pair("depth=" + std::to_string(depth), Rendering::PathTermination(depth))); }
+	terminations.push_back(std::make_pair("threshold", Rendering::PathTermination(Rendering::PathTermination::DefaultReflectionLimit, Rendering::TerminationMode::Threshold)));
+	terminations.push_back(std::make_pair("roulette", Rendering::PathTermination(Rendering::PathTermination::DefaultReflectionLimit, Rendering::TerminationMode::RussianRoulette)));
+	for (const std::pair<std::string, Rendering::PathTermination>& termination : terminations)
+	{
+		const Rendering::PathTermination& pathTermination = termination.second;
+		io_runner.Run("Camera::TraceRay", termination.first, 1, [&world, &camera, &rays, &pathTermination](uint64_t _iterations)
+		{
+			Shapes::OccluderCache occluderCache;
+			for (uint64_t j = 0; j < _iterations; j++) { Benchmarking::KeepAlive(camera.TraceRay(rays[j & (InputCount - 1)], world.GetSphereSet(), world.GetHierarchy(), world.GetLightSource(), occluderCache, pathTermination)); }
+		});
+	}
+
+	// Trace a block of neighbouring rays from each of the same pixels as a packet, with every reflection.
+	for (uint8_t packetSize = 4; packetSize <= RayPacket::MaxSize; packetSize *= 2)
+	{
+		io_runner.Run("Camera::TracePacket", "size=" + std::to_string(packetSize), packetSize, [&world, &camera, &pixels, packetSize](uint64_t _iterations)
+		{
+			Shapes::OccluderCache occluderCache;
+			RayPacket packet;
+			glm::vec3 radiance[RayPacket::MaxSize];
+			for (uint64_t j = 0; j < _iterations; j++)
+			{
+				camera.CreatePacket(pixels[j & (InputCount - 1)], packetSize, UINT32_MAX, packet);
+				camera.TracePacket(packet, world.GetSphereSet(), world.GetHierarchy(), world.GetLightSource(), occluderCache, Rendering::PathTermination(), radiance);
+				Benchmarking::KeepAlive(radiance[0]);
+			}
+		});
+	}
+}
+
+/// <summary> Measures quantising radiance into colours, which happens once for every pixel written out. </summary>
+/// <param name="io_runner"> The runner with which to time the cases. </param>
+void benchmarkColour(Benchmarking::Runner& io_runner)
+{
+	// Include radiance brighter than white, so that clamping and tone mapping both have work to do.
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float_t> channel(0, 2);
+	std::vector<glm::vec3> radiance(InputCount);
+	for (uint32_t i = 0; i < InputCount; i++) { radiance[i] = glm::vec3(channel(random), channel(random), channel(random)); }
+
+	io_runner.Run("Colour::FromRadiance", "clamp", 0, [&radiance](uint64_t _iterations)
+	{
+		for (uint64_t j = 0; j < _iterations; j++) { Benchmarking::KeepAlive(Colour::FromRadiance(radiance[j & (InputCount - 1)], ToneMapping::Clamp)); }
+	});
+	io_runner.Run("Colour::FromRadiance", "reinhard", 0, [&radiance](uint64_t _iterations)
+	{
+		for (uint64_t j = 0; j < _iterations; j++) { Benchmarking::KeepAlive(Colour::FromRadiance(radiance[j & (InputCount - 1)], ToneMapping::Reinhard)); }
+	});
+}
+
+/// <summary> Measures averaging a buffer of samples down into pixels on a single thread, which is bound by <c>Buffer::GetAverage</c>, and that average on its own for one pixel at a time. </summary>
+/// <param name="io_runner"> The runner with which to time the cases. </param>
+void benchmarkBuffer(Benchmarking::Runner& io_runner)
+{
+	const uint16_t outputSize = 128;
+	Rendering::RenderSettings settings;
+	settings.m_threadAmount = 1;
+
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float_t> channel(0, 1);
+	for (uint8_t level = 2; level <= 4; level += 2)
+	{
+		// Fill the buffer with noise so that every sample differs.
+		Buffer samples(outputSize * level, outputSize * level);
+		for (uint16_t y = 0; y < samples.GetHeight(); y++) { for (uint16_t x = 0; x < samples.GetWidth(); x++) { samples.SetPixel(x, y, glm::vec3(channel(random), channel(random), channel(random))); } }
+
+		io_runner.Run("Buffer::SuperSample", std::to_string(outputSize) + "x" + std::to_string(outputSize) + "@" + std::to_string(level) + "x", 0, [&samples, &settings, level](uint64_t _iterations)
+		{
+			for (uint64_t j = 0; j < _iterations; j++) { Buffer& output = samples.SuperSample(level, settings); Benchmarking::KeepAlive(output.AtPixel(0, 0)); delete &output; }
+		});
+
+		// Average each pixel's samples in turn, wrapping around the buffer.
+		io_runner.Run("Buffer::GetAverage", std::to_string(level) + "x", 0, [&samples, outputSize, level](uint64_t _iterations)
+		{
+			for (uint64_t j = 0; j < _iterations; j++)
+			{
+				uint32_t pixel = (uint32_t)(j % ((uint32_t)outputSize * outputSize));
+				Benchmarking::KeepAlive(samples.GetAverage((uint16_t)(pixel % outputSize * level), (uint16_t)(pixel / outputSize * level), level));
+			}
+		});
+	}
+}
+
+/// <summary> Prints how to use the program. </summary>
+/// <param name="_program"> The name the program was run with. </param>
+void printUsage(const char* _program)
+{
+	std::cout << "Usage: " << _program << " [options]" << std::endl
+		<< "Microbenchmarks:" << std::endl
+		<< "  --filter <text>           Only run cases whose name contains the text, such as TraceRay or /miss." << std::endl
+		<< "  --list                    Print the name of every case without running it." << std::endl
+		<< "  --repetitions <count>     Timed repetitions of each case, the median is reported. Defaults to 5." << std::endl
+		<< "  --min-time <ms>           Shortest time each repetition lasts. Defaults to 100." << std::endl
+		<< "Scene:" << std::endl
+		<< "  --generate <kind>         Trace a generated scene instead of the default: random, grid, sphereflake, mirrors, or subpixel." << std::endl
+		<< "  --count <spheres>         Spheres to generate. Defaults to 1000." << std::endl
+		<< "  --seed <number>           Seed to generate from. Defaults to 1." << std::endl
+		<< "Scaling:" << std::endl
+		<< "  --scaling                 Render whole frames over a matrix of threads, resolutions, and sample levels instead." << std::endl
+		<< "  --threads <list>          Thread counts, such as 1,2,4,all. Defaults to powers of two up to every worker." << std::endl
+		<< "  --resolutions <list>      Frame sizes, such as 640x360,1920x1080. Defaults to 640x360,1280x720,1920x1080." << std::endl
+		<< "  --samples <list>          Sample levels, such as 1,2,4. Defaults to 1,2,4." << std::endl
+		<< "  --adaptive                Only trace every sample for pixels on an edge." << std::endl
+		<< "  --packet <size>           Rays traced together, primary rays with one sample or every ray with --wavefront: 4, 8, or 16, or 1 to trace each alone. Defaults to 8." << std::endl
+		<< "  --wavefront               Trace each tile one bounce at a time as queues of rays, rather than following each path to its end in turn." << std::endl
+		<< "  --terminate <mode>        End reflections whose throughput is below a single colour step early: none, threshold, or roulette. Defaults to none." << std::endl
+		<< "  --warmup <count>          Untimed frames before each cell. Defaults to 1." << std::endl
+		<< "  --runs <count>            Timed frames for each cell. Defaults to 5." << std::endl
+		<< "Output:" << std::endl
+		<< "  --json <path>             Also write the results as JSON." << std::endl
+		<< "  --csv <path>              Also write the results as CSV." << std::endl;
+}
+
+/// <summary> Parses a whole number within the given range. </summary>
+/// <param name="_text"> The text to parse. </param>
+/// <param name="_min"> The smallest allowed value. </param>
+/// <param name="_max"> The largest allowed value. </param>
+/// <param name="o_value"> The parsed value. </param>
+/// <returns> <c>true</c> if the text was a whole number within range; otherwise, <c>false</c>. </returns>
+bool parseNumber(const char* _text, const long _min, const long _max, long& o_value)
+{
+	char* end = nullptr;
+	o_value = strtol(_text, &end, 10);
+	return end != _text && *end == '\0' && o_value >= _min && o_value <= _max;
+}
+
+/// <summary> Parses a whole number from <c>0</c> to <c>UINT32_MAX</c>, which does not fit in a <c>long</c> on every platform. </summary>
+/// <param name="_text"> The text to parse. </param>
+/// <param name="o_value"> The parsed value. </param>
+/// <returns> <c>true</c> if the text was a whole number within range; otherwise, <c>false</c>. </returns>
+bool parseUnsigned(const char* _text, uint32_t& o_value)
+{
+	char* end = nullptr;
+	unsigned long long value = strtoull(_text, &end, 10);
+	if (end == _text || *end != '\0' || _text[0] == '-' || value > UINT32_MAX) { return false; }
+	o_value = (uint32_t)value;
+	return true;
+}
+
+/// <summary> Splits the given comma separated list into its items. </summary>
+/// <param name="_text"> The text to split. </param>
+/// <returns> Each item, which may be empty. </returns>
+std::vector<std::string> splitList(const std::string& _text)
+{
+	std::vector<std::string> items;
+	size_t start = 0;
+	for (size_t comma = _text.find(','); comma != std::string::npos; start = comma + 1, comma = _text.find(',', start)) { items.push_back(_text.substr(start, comma - start)); }
+	items.push_back(_text.substr(start));
+	return items;
+}
+
+/// <summary> Parses the given command line option of the scaling benchmark into the given options. </summary>
+/// <param name="_argument"> The name of the option. </param>
+/// <param name="_value"> The value given to the option. </param>
+/// <param name="io_options"> The options to change. </param>
+/// <returns> <c>true</c> if the value was valid; otherwise, <c>false</c>. </returns>
+bool parseScalingOption(const std::string& _argument, const char* _value, Benchmarking::ScalingOptions& io_options)
+{
+	long number = 0;
+	if (_argument == "--threads")
+	{
+		io_options.m_threadCounts.clear();
+		for (const std::string& item : splitList(_value))
+		{
+			if (item == "all") { io_options.m_threadCounts.push_back((uint16_t)Threading::ThreadPool::Get().GetWorkerCount()); }
+			else if (parseNumber(item.c_str(), 1, 1024, number)) { io_options.m_threadCounts.push_back((uint16_t)number); }
+			else { return false; }
+		}
+	}
+	else if (_argument == "--resolutions")
+	{
+		io_options.m_resolutions.clear();
+		for (const std::string& item : splitList(_value))
+		{
+			size_t cross = item.find('x');
+			long width = 0, height = 0;
+			if (cross == std::string::npos || !parseNumber(item.substr(0, cross).c_str(), 1, UINT16_MAX, width) || !parseNumber(item.substr(cross + 1).c_str(), 1, UINT16_MAX, height)) { return false; }
+			io_options.m_resolutions.push_back(std::make_pair((uint16_t)width, (uint16_t)height));
+		}
+	}
+	else if (_argument == "--samples")
+	{
+		io_options.m_sampleLevels.clear();
+		for (const std::string& item : splitList(_value)) { if (!parseNumber(item.c_str(), 1, 16, number)) { return false; } io_options.m_sampleLevels.push_back((uint8_t)number); }
+	}
+	else if (_argument == "--warmup") { if (!parseNumber(_value, 0, 1000, number)) { return false; } io_options.m_warmupRuns = (uint32_t)number; }
+	else if (_argument == "--runs") { if (!parseNumber(_value, 1, 1000, number)) { return false; } io_options.m_runs = (uint32_t)number; }
+	else if (_argument == "--terminate")
+	{
+		std::string mode = _value;
+		if (mode == "none") { io_options.m_terminationMode = Rendering::TerminationMode::None; }
+		else if (mode == "threshold") { io_options.m_terminationMode = Rendering::TerminationMode::Threshold; }
+		else if (mode == "roulette") { io_options.m_terminationMode = Rendering::TerminationMode::RussianRoulette; }
+		else { return false; }
+	}
+	else if (_argument == "--packet") { if (!parseNumber(_value, 1, 16, number) || (number != 1 && number != 4 && number != 8 && number != 16)) { return false; } io_options.m_packetSize = (uint8_t)number; }
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	// Read the options from the command line.
+	std::string filter, jsonPath, csvPath;
+	long repetitions = 5, minTime = 100;
+	bool listOnly = false, scaling = false;
+	Benchmarking::ScalingOptions scalingOptions;
+	Scenes::GeneratorType generator = Scenes::GeneratorType::Count;
+	long sphereCount = 1000;
+	uint32_t seed = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-?") { printUsage(argv[0]); return 0; }
+		if (argument == "--list") { listOnly = true; continue; }
+		if (argument == "--scaling") { scaling = true; continue; }
+		if (argument == "--adaptive") { scalingOptions.m_sampleMode = Rendering::SampleMode::Adaptive; continue; }
+		if (argument == "--wavefront") { scalingOptions.m_traceMode = Rendering::TraceMode::Wavefront; continue; }
+
+		// Every other option takes the argument after it as its value.
+		bool isScalingOption = argument == "--threads" || argument == "--resolutions" || argument == "--samples" || argument == "--warmup" || argument == "--runs" || argument == "--packet" || argument == "--terminate";
+		bool isSceneOption = argument == "--generate" || argument == "--count" || argument == "--seed";
+		if (!isScalingOption && !isSceneOption && argument != "--filter" && argument != "--repetitions" && argument != "--min-time" && argument != "--json" && argument != "--csv") { std::cerr << "Unknown option: " << argument << std::endl; printUsage(argv[0]); return 1; }
+		if (i + 1 >= argc) { std::cerr << "Missing value for " << argument << std::endl; return 1; }
+		const char* value = argv[++i];
+
+		if (isScalingOption) { if (!parseScalingOption(argument, value, scalingOptions)) { std::cerr << "Invalid value for " << argument << ": " << value << std::endl; return 1; } }
+		else if (argument == "--generate") { if (!Scenes::SceneGenerator::TypeFromName(value, generator)) { std::cerr << "Unknown scene kind: " << value << std::endl; return 1; } }
+		else if (argument == "--count") { if (!parseNumber(value, 1, Scenes::SceneGenerator::MaxSphereCount, sphereCount)) { std::cerr << "Invalid sphere count: " << value << std::endl; return 1; } }
+		else if (argument == "--seed") { if (!parseUnsigned(value, seed)) { std::cerr << "Invalid seed: " << value << std::endl; return 1; } }
+		else if (argument == "--filter") { filter = value; }
+		else if (argument == "--repetitions") { if (!parseNumber(value, 1, 1000, repetitions)) { std::cerr << "Invalid repetitions: " << value << std::endl; return 1; } }
+		else if (argument == "--min-time") { if (!parseNumber(value, 1, 60000, minTime)) { std::cerr << "Invalid minimum time: " << value << std::endl; return 1; } }
+		else if (argument == "--json") { jsonPath = value; }
+		else { csvPath = value; }
+	}
+
+	// Generate the scene if asked to, naming it after how it was generated.
+	if (generator != Scenes::GeneratorType::Count)
+	{
+		scalingOptions.m_scene = Scenes::SceneGenerator::Generate(generator, (uint32_t)sphereCount, seed);
+		scalingOptions.m_sceneName = std::string(Scenes::SceneGenerator::GetName(generator)) + "/" + std::to_string(sphereCount) + "/seed=" + std::to_string(seed);
+		if (!listOnly) { std::cout << "Generated " << scalingOptions.m_sceneName << " with " << scalingOptions.m_scene.m_spheres.size() << " spheres" << std::endl; }
+	}
+
+	// Render the whole matrix of frames if asked to, and write the results out.
+	if (scaling)
+	{
+		Benchmarking::ScalingBenchmark benchmark(scalingOptions);
+		benchmark.Run();
+		if (!jsonPath.empty() && !benchmark.WriteJSON(jsonPath)) { std::cerr << "Could not write " << jsonPath << std::endl; return 1; }
+		if (!csvPath.empty() && !benchmark.WriteCSV(csvPath)) { std::cerr << "Could not write " << csvPath << std::endl; return 1; }
+		return 0;
+	}
+
+	// Otherwise, run every microbenchmark.
+	Benchmarking::Runner runner((double)minTime, (uint32_t)repetitions, filter);
+	runner.SetListOnly(listOnly);
+	benchmarkSphere(runner);
+	benchmarkCamera(runner, scalingOptions.m_scene);
+	benchmarkColour(runner);
+	benchmarkBuffer(runner);
+	if (listOnly) { return 0; }
+
+	// Write the results out.
+	if (!jsonPath.empty() && !runner.WriteJSON(jsonPath)) { std::cerr << "Could not write " << jsonPath << std::endl; return 1; }
+	if (!csvPath.empty() && !runner.WriteCSV(csvPath)) { std::cerr << "Could not write " << csvPath << std::endl; return 1; }
+	return 0;
+}
\ No newline at end of file
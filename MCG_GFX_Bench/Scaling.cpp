@@ -0,0 +1,188 @@
+#include "Scaling.h"
+
+// Data includes.
+#include "World.h"
+#include "Buffer.h"
+#include "FrameTarget.h"
+#include "TileScheduler.h"
+
+// Threading includes.
+#include "ThreadPool.h"
+
+// Utility includes.
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+
+/// <summary> Creates options that sweep from one thread to every worker in powers of two, over three common resolutions and the first three sample levels of the default scene. </summary>
+Benchmarking::ScalingOptions::ScalingOptions() : m_resolutions({ { 640, 360 }, { 1280, 720 }, { 1920, 1080 } }), m_sampleLevels({ 1, 2, 4 }), m_sampleMode(Rendering::SampleMode::Uniform), m_packetSize(Rendering::RenderSettings().m_packetSize), m_traceMode(Rendering::RenderSettings().m_traceMode), m_terminationMode(Rendering::RenderSettings().m_termination.m_mode), m_warmupRuns(1), m_runs(5), m_scene(Scenes::Scene::Default()), m_sceneName("default")
+{
+	uint16_t workerCount = (uint16_t)Threading::ThreadPool::Get().GetWorkerCount();
+	for (uint16_t threadCount = 1; threadCount < workerCount; threadCount *= 2) { m_threadCounts.push_back(threadCount); }
+	m_threadCounts.push_back(workerCount);
+}
+
+/// <summary> Renders every cell of the matrix, printing each result as soon as it is known. </summary>
+void Benchmarking::ScalingBenchmark::Run()
+{
+	// Make sure one thread is run first, as every other count is compared against it.
+	std::vector<uint16_t> threadCounts = m_options.m_threadCounts;
+	threadCounts.push_back(1);
+	std::sort(threadCounts.begin(), threadCounts.end());
+	threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+	std::cout << std::left << std::setw(10) << "threads" << std::setw(12) << "resolution" << std::setw(9) << "samples" << std::right
+		<< std::setw(18) << "render med/p95" << std::setw(18) << "sample med/p95" << std::setw(18) << "upload med/p95" << std::setw(18) << "total med/p95" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::setw(9) << "serial" << std::endl;
+
+	for (const std::pair<uint16_t, uint16_t>& resolution : m_options.m_resolutions)
+	{
+		// Create the world once per resolution, along with memory the size of the texture to upload into.
+		World world(glm::vec2(resolution.first, resolution.second), m_options.m_scene);
+		std::vector<uint32_t> texture((size_t)resolution.first * resolution.second);
+		Rendering::FrameTarget target((uint8_t*)texture.data(), resolution.first * sizeof(uint32_t), resolution.first, resolution.second, 16, 8, 0, 0xFF000000);
+		Rendering::Tile wholeFrame = { 0, 0, resolution.first, resolution.second };
+
+		for (uint8_t sampleLevel : m_options.m_sampleLevels)
+		{
+			size_t firstResult = m_results.size();
+			for (uint16_t threadCount : threadCounts)
+			{
+				Rendering::RenderSettings settings;
+				settings.m_threadAmount = threadCount;
+				settings.m_sampleLevel = sampleLevel;
+				settings.m_sampleMode = m_options.m_sampleMode;
+				settings.m_packetSize = m_options.m_packetSize;
+				settings.m_traceMode = m_options.m_traceMode;
+				settings.m_termination.m_mode = m_options.m_terminationMode;
+
+				// Render the warmup frames and then the timed frames, only keeping the times of the timed ones.
+				std::vector<double> renderTimes, sampleTimes, uploadTimes, totalTimes;
+				for (uint32_t run = 0; run < m_options.m_warmupRuns + m_options.m_runs; run++)
+				{
+					std::chrono::steady_clock::time_point frameTimer = std::chrono::steady_clock::now();
+					Buffer& buffer = world.Draw(settings);
+
+					// Upload the frame as one copy after it has finished, so that the upload is timed on its own rather than hidden within the render.
+					std::chrono::steady_clock::time_point uploadTimer = std::chrono::steady_clock::now();
+					buffer.CopyTile(wholeFrame, target);
+					std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+					delete &buffer;
+
+					if (run < m_options.m_warmupRuns) { continue; }
+					renderTimes.push_back(world.GetDrawStats().m_renderMilliseconds);
+					sampleTimes.push_back(world.GetDrawStats().m_sampleMilliseconds);
+					uploadTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - uploadTimer).count());
+					totalTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameTimer).count());
+				}
+
+				// Summarise the times.
+				ScalingResult result;
+				result.m_threadCount = threadCount;
+				result.m_width = resolution.first;
+				result.m_height = resolution.second;
+				result.m_sampleLevel = sampleLevel;
+				result.m_render = summarise(renderTimes);
+				result.m_sample = summarise(sampleTimes);
+				result.m_upload = summarise(uploadTimes);
+				result.m_total = summarise(totalTimes);
+
+				// Compare against the single threaded frame, which is always the first of this resolution and sample level. Rearranging Amdahl's law gives the serial fraction from the speedup.
+				result.m_speedup = m_results.size() > firstResult ? m_results[firstResult].m_total.m_median / result.m_total.m_median : 1;
+				result.m_efficiency = result.m_speedup / threadCount;
+				result.m_serialFraction = (threadCount > 1) ? (1 / result.m_speedup - 1.0 / threadCount) / (1 - 1.0 / threadCount) : 0;
+				result.m_fittedSerialFraction = 0;
+				m_results.push_back(result);
+
+				// Print the cell.
+				std::cout << std::left << std::setw(10) << threadCount << std::setw(12) << (std::to_string(resolution.first) + "x" + std::to_string(resolution.second)) << std::setw(9) << ((int)sampleLevel) << std::right << std::fixed << std::setprecision(2)
+					<< std::setw(9) << result.m_render.m_median << std::setw(9) << result.m_render.m_p95 << std::setw(9) << result.m_sample.m_median << std::setw(9) << result.m_sample.m_p95
+					<< std::setw(9) << result.m_upload.m_median << std::setw(9) << result.m_upload.m_p95 << std::setw(9) << result.m_total.m_median << std::setw(9) << result.m_total.m_p95
+					<< std::setw(10) << result.m_speedup << std::setw(12) << result.m_efficiency << std::setw(9) << std::setprecision(3) << result.m_serialFraction << std::defaultfloat << std::endl;
+			}
+
+			// Fit the serial fraction across every thread count of this resolution and sample level.
+			double fittedSerialFraction = fitSerialFraction(m_results, firstResult, m_results.size());
+			for (size_t i = firstResult; i < m_results.size(); i++) { m_results[i].m_fittedSerialFraction = fittedSerialFraction; }
+			if (m_results.size() - firstResult > 1) { std::cout << "  Amdahl fit: serial fraction " << fittedSerialFraction << ", best possible speedup " << ((fittedSerialFraction > 0) ? 1 / fittedSerialFraction : INFINITY) << "x" << std::endl; }
+		}
+	}
+}
+
+/// <summary> Writes every result to the given file as JSON. </summary>
+/// <param name="_path"> The path of the file, which is replaced if it exists. </param>
+/// <returns> <c>true</c> if the whole file was written; otherwise, <c>false</c>. </returns>
+bool Benchmarking::ScalingBenchmark::WriteJSON(const std::string& _path) const
+{
+	std::ofstream file(_path, std::ios::trunc);
+	if (!file) { return false; }
+
+	file << std::setprecision(9) << "{" << std::endl << "  \"scene\": \"" << m_options.m_sceneName << "\"," << std::endl << "  \"spheres\": " << m_options.m_scene.m_spheres.size() << "," << std::endl << "  \"sample_mode\": \"" << ((m_options.m_sampleMode == Rendering::SampleMode::Adaptive) ? "adaptive" : "uniform") << "\"," << std::endl << "  \"packet_size\": " << (int)m_options.m_packetSize << "," << std::endl << "  \"trace_mode\": \"" << ((m_options.m_traceMode == Rendering::TraceMode::Wavefront) ? "wavefront" : "recursive") << "\"," << std::endl << "  \"termination\": \"" << ((m_options.m_terminationMode == Rendering::TerminationMode::Threshold) ? "threshold" : (m_options.m_terminationMode == Rendering::TerminationMode::RussianRoulette) ? "roulette" : "none") << "\"," << std::endl
+		<< "  \"warmup_runs\": " << m_options.m_warmupRuns << "," << std::endl << "  \"runs\": " << m_options.m_runs << "," << std::endl << "  \"cells\": [" << std::endl;
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		const ScalingResult& result = m_results[i];
+		file << "    { \"threads\": " << result.m_threadCount << ", \"width\": " << result.m_width << ", \"height\": " << result.m_height << ", \"samples\": " << (int)result.m_sampleLevel
+			<< ", \"render_ms\": { \"median\": " << result.m_render.m_median << ", \"p95\": " << result.m_render.m_p95 << " }"
+			<< ", \"sample_ms\": { \"median\": " << result.m_sample.m_median << ", \"p95\": " << result.m_sample.m_p95 << " }"
+			<< ", \"upload_ms\": { \"median\": " << result.m_upload.m_median << ", \"p95\": " << result.m_upload.m_p95 << " }"
+			<< ", \"total_ms\": { \"median\": " << result.m_total.m_median << ", \"p95\": " << result.m_total.m_p95 << " }"
+			<< ", \"speedup\": " << result.m_speedup << ", \"efficiency\": " << result.m_efficiency << ", \"serial_fraction\": " << result.m_serialFraction << ", \"fitted_serial_fraction\": " << result.m_fittedSerialFraction << " }"
+			<< ((i + 1 < m_results.size()) ? "," : "") << std::endl;
+	}
+	file << "  ]" << std::endl << "}" << std::endl;
+	return (bool)file;
+}
+
+/// <summary> Writes every result to the given file as CSV, one row per cell after a header row. </summary>
+/// <param name="_path"> The path of the file, which is replaced if it exists. </param>
+/// <returns> <c>true</c> if the whole file was written; otherwise, <c>false</c>. </returns>
+bool Benchmarking::ScalingBenchmark::WriteCSV(const std::string& _path) const
+{
+	std::ofstream file(_path, std::ios::trunc);
+	if (!file) { return false; }
+
+	file << std::setprecision(9) << "threads,width,height,samples,render_median_ms,render_p95_ms,sample_median_ms,sample_p95_ms,upload_median_ms,upload_p95_ms,total_median_ms,total_p95_ms,speedup,efficiency,serial_fraction,fitted_serial_fraction" << std::endl;
+	for (const ScalingResult& result : m_results)
+	{
+		file << result.m_threadCount << "," << result.m_width << "," << result.m_height << "," << (int)result.m_sampleLevel << "," << result.m_render.m_median << "," << result.m_render.m_p95 << "," << result.m_sample.m_median << "," << result.m_sample.m_p95 << ","
+			<< result.m_upload.m_median << "," << result.m_upload.m_p95 << "," << result.m_total.m_median << "," << result.m_total.m_p95 << "," << result.m_speedup << "," << result.m_efficiency << "," << result.m_serialFraction << "," << result.m_fittedSerialFraction << std::endl;
+	}
+	return (bool)file;
+}
+
+/// <summary> Finds the median and 95th percentile of the given times. </summary>
+/// <param name="io_times"> The times, which are sorted. </param>
+/// <returns> The median and 95th percentile, using the nearest rank. </returns>
+Benchmarking::PhaseTimes Benchmarking::ScalingBenchmark::summarise(std::vector<double>& io_times)
+{
+	std::sort(io_times.begin(), io_times.end());
+	size_t count = io_times.size();
+
+	PhaseTimes times;
+	times.m_median = (count % 2 == 1) ? io_times[count / 2] : (io_times[count / 2 - 1] + io_times[count / 2]) / 2;
+	times.m_p95 = io_times[(size_t)std::ceil(count * 0.95) - 1];
+	return times;
+}
+
+/// <summary> Fits Amdahl's law to the given results with least squares, each of which must be the same frame rendered with a different number of threads, starting with one. </summary>
+/// <param name="_results"> The results. </param>
+/// <param name="_begin"> The first result to fit, which must be on one thread. </param>
+/// <param name="_end"> One past the last result to fit. </param>
+/// <returns> The serial fraction that best fits the results, or <c>0</c> if there is only one thread count. </returns>
+double Benchmarking::ScalingBenchmark::fitSerialFraction(const std::vector<ScalingResult>& _results, const size_t _begin, const size_t _end)
+{
+	// Amdahl's law says time on n threads over time on one is f(1 - 1/n) + 1/n, which is a line through the origin once 1/n is moved over.
+	double sumXY = 0, sumXX = 0;
+	for (size_t i = _begin + 1; i < _end; i++)
+	{
+		double inverseThreads = 1.0 / _results[i].m_threadCount;
+		double x = 1 - inverseThreads;
+		double y = _results[i].m_total.m_median / _results[_begin].m_total.m_median - inverseThreads;
+		sumXY += x * y;
+		sumXX += x * x;
+	}
+	return (sumXX > 0) ? std::min(std::max(sumXY / sumXX, 0.0), 1.0) : 0;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#ifndef SCALING_H
+#define SCALING_H
+
+// Data includes.
+#include "RenderSettings.h"
+#include "Scene.h"
+
+// Utility includes.
+#include <string>
+#include <vector>
+#include <utility>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Benchmarking
+{
+	/// <summary> Represents the matrix of frames to render, and how many times to render each. </summary>
+	struct ScalingOptions
+	{
+		ScalingOptions();
+
+		/// <summary> The number of threads to render with. Always includes <c>1</c>, which every other count is compared against. </summary>
+		std::vector<uint16_t> m_threadCounts;
+
+		/// <summary> The width and height of each frame to render, in pixels. </summary>
+		std::vector<std::pair<uint16_t, uint16_t>> m_resolutions;
+
+		/// <summary> The sample levels to render with. </summary>
+		std::vector<uint8_t> m_sampleLevels;
+
+		/// <summary> How to sample pixels when rendering with more than one sample. </summary>
+		Rendering::SampleMode m_sampleMode;
+
+		/// <summary> The number of primary rays traced together when rendering with one sample. </summary>
+		uint8_t m_packetSize;
+
+		/// <summary> How rays are traced through the scene. </summary>
+		Rendering::TraceMode m_traceMode;
+
+		/// <summary> How paths with a low throughput are ended early. </summary>
+		Rendering::TerminationMode m_terminationMode;
+
+		/// <summary> The number of untimed frames rendered before each cell, to fill the caches and wake every thread. </summary>
+		uint32_t m_warmupRuns;
+
+		/// <summary> The number of timed frames rendered for each cell. </summary>
+		uint32_t m_runs;
+
+		/// <summary> The scene to render. </summary>
+		Scenes::Scene m_scene;
+
+		/// <summary> The name of the scene, written with the results. </summary>
+		std::string m_sceneName;
+	};
+
+	/// <summary> Represents the spread of the times taken by one phase of a frame across every run of a cell. </summary>
+	struct PhaseTimes
+	{
+		/// <summary> The median time in milliseconds. </summary>
+		double m_median;
+
+		/// <summary> The 95th percentile time in milliseconds. </summary>
+		double m_p95;
+	};
+
+	/// <summary> Represents the timings of one cell of the matrix, a resolution and sample level rendered with a number of threads. </summary>
+	struct ScalingResult
+	{
+		/// <summary> The number of threads rendered with. </summary>
+		uint16_t m_threadCount;
+
+		/// <summary> The width of the frame in pixels. </summary>
+		uint16_t m_width;
+
+		/// <summary> The height of the frame in pixels. </summary>
+		uint16_t m_height;
+
+		/// <summary> The sample level rendered with. </summary>
+		uint8_t m_sampleLevel;
+
+		/// <summary> The time taken to trace every pixel. </summary>
+		PhaseTimes m_render;
+
+		/// <summary> The time taken to trace the extra samples of edge pixels, which is only separate from rendering when sampling adaptively. </summary>
+		PhaseTimes m_sample;
+
+		/// <summary> The time taken to copy the finished frame into texture-sized memory. </summary>
+		PhaseTimes m_upload;
+
+		/// <summary> The time taken by the whole frame. </summary>
+		PhaseTimes m_total;
+
+		/// <summary> How many times faster the median frame is than on one thread. </summary>
+		double m_speedup;
+
+		/// <summary> The speedup divided by the number of threads, where <c>1</c> is perfect scaling. </summary>
+		double m_efficiency;
+
+		/// <summary> The fraction of the single threaded frame that did not get faster, worked out from the speedup with Amdahl's law, or <c>0</c> on one thread. </summary>
+		double m_serialFraction;
+
+		/// <summary> The serial fraction that best fits every thread count at this resolution and sample level, so a single noisy cell does not skew it. </summary>
+		double m_fittedSerialFraction;
+	};
+
+	/// <summary> Renders every cell of a matrix of thread counts, resolutions, and sample levels several times, and works out how well each scales. </summary>
+	class ScalingBenchmark
+	{
+	public:
+		/// <summary> Creates a benchmark over the given matrix. </summary>
+		/// <param name="_options"> The matrix of frames to render, and how many times to render each. </param>
+		ScalingBenchmark(const ScalingOptions& _options) : m_options(_options) { }
+
+		void Run();
+
+		/// <summary> Gets the result of every cell that has been run. </summary>
+		/// <returns> The results, grouped by resolution then sample level, in order of thread count. </returns>
+		inline const std::vector<ScalingResult>& GetResults() const { return m_results; }
+
+		bool WriteJSON(const std::string&) const;
+
+		bool WriteCSV(const std::string&) const;
+	private:
+		/// <summary> The matrix of frames to render, and how many times to render each. </summary>
+		ScalingOptions m_options;
+
+		/// <summary> The result of every cell that has been run. </summary>
+		std::vector<ScalingResult> m_results;
+
+		static PhaseTimes summarise(std::vector<double>&);
+
+		static double fitSerialFraction(const std::vector<ScalingResult>&, size_t, size_t);
+	};
+}
+#endif
\ No newline at end of file
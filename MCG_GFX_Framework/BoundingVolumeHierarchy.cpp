@@ -0,0 +1,1114 @@
+#include "BoundingVolumeHierarchy.h"
+
+// SIMD includes.
+#if defined(__AVX2__)
+#define BOUNDINGVOLUMEHIERARCHY_AVX2
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BOUNDINGVOLUMEHIERARCHY_SSE2
+#include <emmintrin.h>
+#endif
+
+// Threading includes.
+#include "ThreadPool.h"
+#include <atomic>
+
+// Utility includes.
+#include <algorithm>
+#include <functional>
+#include <chrono>
+
+// Diagnostic includes.
+#include "Telemetry.h"
+#include "Timeline.h"
+
+namespace
+{
+	/// <summary> Calculates half of the surface area of the box with the given corners, which is all the heuristic needs. </summary>
+	/// <param name="_min"> The minimum corner. </param>
+	/// <param name="_max"> The maximum corner. </param>
+	/// <returns> Half of the surface area, or <c>0</c> if the box is empty. </returns>
+	inline float_t halfArea(const glm::vec3& _min, const glm::vec3& _max)
+	{
+		glm::vec3 extent = glm::max(_max - _min, glm::vec3(0));
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	/// <summary> Calculates the cost of the given node, which is its area weighted by the number of spheres tested if it is a leaf. </summary>
+	/// <param name="_node"> The node. </param>
+	/// <returns> The weighted area of the node. </returns>
+	inline float_t nodeCost(const Shapes::BoundingVolumeHierarchy::Node& _node)
+	{
+		return halfArea(_node.m_min, _node.m_max) * (_node.IsLeaf() ? _node.m_count : 1);
+	}
+
+	/// <summary> Spreads the lowest ten bits of the given value out so that there are two zero bits between each one. </summary>
+	/// <param name="_value"> The value to spread. </param>
+	/// <returns> The spread value. </returns>
+	inline uint32_t spreadBits(uint32_t _value)
+	{
+		_value = (_value * 0x00010001u) & 0xFF0000FFu;
+		_value = (_value * 0x00000101u) & 0x0F00F00Fu;
+		_value = (_value * 0x00000011u) & 0xC30C30C3u;
+		_value = (_value * 0x00000005u) & 0x49249249u;
+		return _value;
+	}
+
+	/// <summary> Represents the bins along every axis for one range of spheres. </summary>
+	struct BinSet
+	{
+		/// <summary> The number of spheres in each bin on each axis. </summary>
+		uint32_t m_counts[3][Shapes::BoundingVolumeHierarchy::BinCount];
+
+		/// <summary> The minimum corner of the box around each bin on each axis. </summary>
+		glm::vec3 m_min[3][Shapes::BoundingVolumeHierarchy::BinCount];
+
+		/// <summary> The maximum corner of the box around each bin on each axis. </summary>
+		glm::vec3 m_max[3][Shapes::BoundingVolumeHierarchy::BinCount];
+
+		/// <summary> Empties every bin. </summary>
+		void Reset()
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				for (uint32_t b = 0; b < Shapes::BoundingVolumeHierarchy::BinCount; b++) { m_counts[axis][b] = 0; m_min[axis][b] = glm::vec3(INFINITY); m_max[axis][b] = glm::vec3(-INFINITY); }
+			}
+		}
+
+		/// <summary> Adds the contents of the given bins to these bins. </summary>
+		/// <param name="_other"> The bins to add. </param>
+		void Merge(const BinSet& _other)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				for (uint32_t b = 0; b < Shapes::BoundingVolumeHierarchy::BinCount; b++)
+				{
+					m_counts[axis][b] += _other.m_counts[axis][b];
+					m_min[axis][b] = glm::min(m_min[axis][b], _other.m_min[axis][b]);
+					m_max[axis][b] = glm::max(m_max[axis][b], _other.m_max[axis][b]);
+				}
+			}
+		}
+	};
+
+	/// <summary> Splits the given range into chunks of at least the given size and runs the given function over each chunk on the thread pool. </summary>
+	/// <param name="_first"> The first index of the range. </param>
+	/// <param name="_count"> The number of indices in the range. </param>
+	/// <param name="_minimumChunkSize"> The smallest a chunk may be. </param>
+	/// <param name="_function"> The function to run, taking the index of the chunk and the first and end index of the chunk, which may be empty. </param>
+	/// <returns> The number of chunks. </returns>
+	template<typename Function> uint32_t forEachChunk(const uint32_t _first, const uint32_t _count, const uint32_t _minimumChunkSize, const Function& _function)
+	{
+		// Use a few chunks per worker so that the threads stay busy, but never make a chunk smaller than the minimum.
+		Threading::ThreadPool& threadPool = Threading::ThreadPool::Get();
+		uint32_t chunkCount = glm::max(glm::min(threadPool.GetWorkerCount() * 4, _count / _minimumChunkSize), 1u);
+		uint32_t chunkSize = (_count + chunkCount - 1) / chunkCount;
+
+		threadPool.ParallelFor(chunkCount, [&](uint32_t _chunk)
+		{
+			uint32_t chunkFirst = glm::min(_first + _chunk * chunkSize, _first + _count);
+			uint32_t chunkEnd = glm::min(chunkFirst + chunkSize, _first + _count);
+			_function(_chunk, chunkFirst, chunkEnd);
+		});
+
+		return chunkCount;
+	}
+
+	/// <summary> Represents the range of origins and inverse directions across a packet of rays, which bounds where any of them can cross a box. </summary>
+	struct PacketInterval
+	{
+		/// <summary> The minimum corner of the box around every origin. </summary>
+		glm::vec3 m_originMin;
+
+		/// <summary> The maximum corner of the box around every origin. </summary>
+		glm::vec3 m_originMax;
+
+		/// <summary> The smallest reciprocal of each component of any direction. </summary>
+		glm::vec3 m_inverseMin;
+
+		/// <summary> The largest reciprocal of each component of any direction. </summary>
+		glm::vec3 m_inverseMax;
+
+		/// <summary> Whether every ray travels in the positive direction along each axis. </summary>
+		glm::bvec3 m_positive;
+	};
+
+	/// <summary> Finds the range of origins and inverse directions across the given packet, as long as every ray travels the same way along each axis. </summary>
+	/// <param name="_packet"> The packet. </param>
+	/// <param name="o_interval"> The range across the packet. </param>
+	/// <returns> <c>true</c> if the directions agree on every axis; otherwise, <c>false</c>, as the range would then cover every direction and reject nothing. </returns>
+	bool findPacketInterval(const RayPacket& _packet, PacketInterval& o_interval)
+	{
+		o_interval.m_originMin = glm::vec3(INFINITY); o_interval.m_originMax = glm::vec3(-INFINITY);
+		o_interval.m_inverseMin = glm::vec3(INFINITY); o_interval.m_inverseMax = glm::vec3(-INFINITY);
+		for (uint32_t lane = 0; lane < _packet.m_size; lane++)
+		{
+			Ray ray = _packet.GetRay(lane);
+			glm::bvec3 positive(!std::signbit(ray.m_direction.x), !std::signbit(ray.m_direction.y), !std::signbit(ray.m_direction.z));
+			if (lane == 0) { o_interval.m_positive = positive; }
+			else if (positive != o_interval.m_positive) { return false; }
+
+			// Keep the reciprocal finite for directions along a plane, so that it can be multiplied by zero.
+			glm::vec3 inverseDirection = glm::clamp(1.0f / ray.m_direction, glm::vec3(-1e30f), glm::vec3(1e30f));
+			o_interval.m_originMin = glm::min(o_interval.m_originMin, ray.m_origin); o_interval.m_originMax = glm::max(o_interval.m_originMax, ray.m_origin);
+			o_interval.m_inverseMin = glm::min(o_interval.m_inverseMin, inverseDirection); o_interval.m_inverseMax = glm::max(o_interval.m_inverseMax, inverseDirection);
+		}
+		return true;
+	}
+
+	/// <summary> Finds the soonest along any ray in a packet that it could enter the given node's box, using interval arithmetic over the whole packet. </summary>
+	/// <param name="_node"> The node. </param>
+	/// <param name="_interval"> The range of origins and inverse directions across the packet. </param>
+	/// <param name="_maxDistance"> The distance beyond which the box is not counted, which is the furthest closest hit of any ray. </param>
+	/// <returns> A distance no further than where any ray enters the box, or <c>INFINITY</c> if no ray in the packet can hit it before the maximum distance. </returns>
+	float_t intersectPacketBounds(const Shapes::BoundingVolumeHierarchy::Node& _node, const PacketInterval& _interval, const float_t _maxDistance)
+	{
+		// Widen the box very slightly, so that rays lying along one of its planes or grazing a corner are never rejected when the single ray test would count them.
+		glm::vec3 margin = (glm::abs(_node.m_min) + glm::abs(_node.m_max)) * 1e-6f + 1e-6f;
+		glm::vec3 boxMin = _node.m_min - margin, boxMax = _node.m_max + margin;
+
+		// Rays enter through the planes facing them and leave through the planes on the far side.
+		glm::vec3 entryPlanes(_interval.m_positive.x ? boxMin.x : boxMax.x, _interval.m_positive.y ? boxMin.y : boxMax.y, _interval.m_positive.z ? boxMin.z : boxMax.z);
+		glm::vec3 exitPlanes(_interval.m_positive.x ? boxMax.x : boxMin.x, _interval.m_positive.y ? boxMax.y : boxMin.y, _interval.m_positive.z ? boxMax.z : boxMin.z);
+
+		// Find the earliest any ray could cross each entry plane, and the latest any ray could cross each exit plane.
+		glm::vec3 entryNear = entryPlanes - _interval.m_originMax, entryFar = entryPlanes - _interval.m_originMin;
+		glm::vec3 exitNear = exitPlanes - _interval.m_originMax, exitFar = exitPlanes - _interval.m_originMin;
+		glm::vec3 entry = glm::min(glm::min(entryNear * _interval.m_inverseMin, entryNear * _interval.m_inverseMax), glm::min(entryFar * _interval.m_inverseMin, entryFar * _interval.m_inverseMax));
+		glm::vec3 exit = glm::max(glm::max(exitNear * _interval.m_inverseMin, exitNear * _interval.m_inverseMax), glm::max(exitFar * _interval.m_inverseMin, exitFar * _interval.m_inverseMax));
+
+		// No ray can be inside the box before the earliest entry or after the latest exit.
+		float_t entryDistance = glm::max(glm::max(entry.x, entry.y), glm::max(entry.z, 0.0f));
+		float_t exitDistance = glm::min(glm::min(exit.x, exit.y), exit.z);
+
+		return (entryDistance <= exitDistance && entryDistance < _maxDistance) ? entryDistance : INFINITY;
+	}
+
+	/// <summary> Represents the reciprocal of each direction across a packet of rays, found once so that every box can be tested against each ray on its own. </summary>
+	struct alignas(32) PacketInverse
+	{
+		/// <summary> The reciprocal of the x component of each direction. </summary>
+		float_t m_x[RayPacket::MaxSize];
+
+		/// <summary> The reciprocal of the y component of each direction. </summary>
+		float_t m_y[RayPacket::MaxSize];
+
+		/// <summary> The reciprocal of the z component of each direction. </summary>
+		float_t m_z[RayPacket::MaxSize];
+	};
+
+	/// <summary> Finds the reciprocal of each direction across the given packet, exactly as a single ray would. </summary>
+	/// <param name="_packet"> The packet, whose unused lanes hold harmless rays. </param>
+	/// <param name="o_inverse"> The reciprocal of each direction. </param>
+	void findPacketInverse(const RayPacket& _packet, PacketInverse& o_inverse)
+	{
+		for (uint32_t lane = 0; lane < RayPacket::MaxSize; lane++) { o_inverse.m_x[lane] = 1.0f / _packet.m_directionX[lane]; o_inverse.m_y[lane] = 1.0f / _packet.m_directionY[lane]; o_inverse.m_z[lane] = 1.0f / _packet.m_directionZ[lane]; }
+	}
+
+	/// <summary> Finds which rays of a packet enter the given node's box before their distances, testing the box against several rays at once with the same maths as a single ray. </summary>
+	/// <param name="_node"> The node. </param>
+	/// <param name="_packet"> The rays, whose distances are the furthest each may enter the box. </param>
+	/// <param name="_inverse"> The reciprocal of each direction. </param>
+	/// <param name="_laneMask"> A bit for each ray to test. </param>
+	/// <param name="o_nearest"> Set to the soonest any of the rays enters the box, or <c>INFINITY</c> if none do. </param>
+	/// <returns> A bit for each of the tested rays that enters the box. </returns>
+	uint32_t intersectLaneBounds(const Shapes::BoundingVolumeHierarchy::Node& _node, const RayPacket& _packet, const PacketInverse& _inverse, const uint32_t _laneMask, float_t& o_nearest)
+	{
+		uint32_t hitLanes = 0;
+		o_nearest = INFINITY;
+
+#if defined(BOUNDINGVOLUMEHIERARCHY_AVX2)
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 minX = _mm256_set1_ps(_node.m_min.x), minY = _mm256_set1_ps(_node.m_min.y), minZ = _mm256_set1_ps(_node.m_min.z);
+		const __m256 maxX = _mm256_set1_ps(_node.m_max.x), maxY = _mm256_set1_ps(_node.m_max.y), maxZ = _mm256_set1_ps(_node.m_max.z);
+		for (uint32_t lane = 0; lane < _packet.m_size; lane += 8)
+		{
+			uint32_t groupMask = (_laneMask >> lane) & 0xFF;
+			if (groupMask == 0) { continue; }
+
+			// Find where each ray crosses each pair of planes.
+			const __m256 originX = _mm256_loadu_ps(&_packet.m_originX[lane]), originY = _mm256_loadu_ps(&_packet.m_originY[lane]), originZ = _mm256_loadu_ps(&_packet.m_originZ[lane]);
+			const __m256 inverseX = _mm256_load_ps(&_inverse.m_x[lane]), inverseY = _mm256_load_ps(&_inverse.m_y[lane]), inverseZ = _mm256_load_ps(&_inverse.m_z[lane]);
+			__m256 toMinX = _mm256_mul_ps(_mm256_sub_ps(minX, originX), inverseX), toMaxX = _mm256_mul_ps(_mm256_sub_ps(maxX, originX), inverseX);
+			__m256 toMinY = _mm256_mul_ps(_mm256_sub_ps(minY, originY), inverseY), toMaxY = _mm256_mul_ps(_mm256_sub_ps(maxY, originY), inverseY);
+			__m256 toMinZ = _mm256_mul_ps(_mm256_sub_ps(minZ, originZ), inverseZ), toMaxZ = _mm256_mul_ps(_mm256_sub_ps(maxZ, originZ), inverseZ);
+
+			// Each ray is inside the box between the last plane it enters and the first plane it leaves.
+			__m256 entry = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(toMinX, toMaxX), _mm256_min_ps(toMinY, toMaxY)), _mm256_max_ps(_mm256_min_ps(toMinZ, toMaxZ), zero));
+			__m256 exit = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(toMinX, toMaxX), _mm256_max_ps(toMinY, toMaxY)), _mm256_max_ps(toMinZ, toMaxZ));
+			__m256 hitMask = _mm256_and_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ), _mm256_cmp_ps(entry, _mm256_loadu_ps(&_packet.m_distance[lane]), _CMP_LT_OQ));
+
+			uint32_t groupHits = (uint32_t)_mm256_movemask_ps(hitMask) & groupMask;
+			if (groupHits == 0) { continue; }
+			hitLanes |= groupHits << lane;
+
+			alignas(32) float_t entries[8];
+			_mm256_store_ps(entries, entry);
+			for (uint32_t i = 0; i < 8; i++) { if ((groupHits & (1u << i)) != 0) { o_nearest = glm::min(o_nearest, entries[i]); } }
+		}
+#elif defined(BOUNDINGVOLUMEHIERARCHY_SSE2)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 minX = _mm_set1_ps(_node.m_min.x), minY = _mm_set1_ps(_node.m_min.y), minZ = _mm_set1_ps(_node.m_min.z);
+		const __m128 maxX = _mm_set1_ps(_node.m_max.x), maxY = _mm_set1_ps(_node.m_max.y), maxZ = _mm_set1_ps(_node.m_max.z);
+		for (uint32_t lane = 0; lane < _packet.m_size; lane += 4)
+		{
+			uint32_t groupMask = (_laneMask >> lane) & 0xF;
+			if (groupMask == 0) { continue; }
+
+			// Find where each ray crosses each pair of planes.
+			const __m128 originX = _mm_loadu_ps(&_packet.m_originX[lane]), originY = _mm_loadu_ps(&_packet.m_originY[lane]), originZ = _mm_loadu_ps(&_packet.m_originZ[lane]);
+			const __m128 inverseX = _mm_load_ps(&_inverse.m_x[lane]), inverseY = _mm_load_ps(&_inverse.m_y[lane]), inverseZ = _mm_load_ps(&_inverse.m_z[lane]);
+			__m128 toMinX = _mm_mul_ps(_mm_sub_ps(minX, originX), inverseX), toMaxX = _mm_mul_ps(_mm_sub_ps(maxX, originX), inverseX);
+			__m128 toMinY = _mm_mul_ps(_mm_sub_ps(minY, originY), inverseY), toMaxY = _mm_mul_ps(_mm_sub_ps(maxY, originY), inverseY);
+			__m128 toMinZ = _mm_mul_ps(_mm_sub_ps(minZ, originZ), inverseZ), toMaxZ = _mm_mul_ps(_mm_sub_ps(maxZ, originZ), inverseZ);
+
+			// Each ray is inside the box between the last plane it enters and the first plane it leaves.
+			__m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(toMinX, toMaxX), _mm_min_ps(toMinY, toMaxY)), _mm_max_ps(_mm_min_ps(toMinZ, toMaxZ), zero));
+			__m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(toMinX, toMaxX), _mm_max_ps(toMinY, toMaxY)), _mm_max_ps(toMinZ, toMaxZ));
+			__m128 hitMask = _mm_and_ps(_mm_cmple_ps(entry, exit), _mm_cmplt_ps(entry, _mm_loadu_ps(&_packet.m_distance[lane])));
+
+			uint32_t groupHits = (uint32_t)_mm_movemask_ps(hitMask) & groupMask;
+			if (groupHits == 0) { continue; }
+			hitLanes |= groupHits << lane;
+
+			alignas(16) float_t entries[4];
+			_mm_store_ps(entries, entry);
+			for (uint32_t i = 0; i < 4; i++) { if ((groupHits & (1u << i)) != 0) { o_nearest = glm::min(o_nearest, entries[i]); } }
+		}
+#else
+		// Without SIMD, test each ray against the box in turn with the same maths.
+		for (uint32_t lane = 0; lane < _packet.m_size; lane++)
+		{
+			if ((_laneMask & (1u << lane)) == 0) { continue; }
+			glm::vec3 origin(_packet.m_originX[lane], _packet.m_originY[lane], _packet.m_originZ[lane]), inverseDirection(_inverse.m_x[lane], _inverse.m_y[lane], _inverse.m_z[lane]);
+			glm::vec3 toMin = (_node.m_min - origin) * inverseDirection, toMax = (_node.m_max - origin) * inverseDirection;
+			glm::vec3 nearPlanes = glm::min(toMin, toMax), farPlanes = glm::max(toMin, toMax);
+			float_t entry = glm::max(glm::max(nearPlanes.x, nearPlanes.y), glm::max(nearPlanes.z, 0.0f));
+			float_t exit = glm::min(glm::min(farPlanes.x, farPlanes.y), farPlanes.z);
+			if (entry <= exit && entry < _packet.m_distance[lane]) { hitLanes |= 1u << lane; o_nearest = glm::min(o_nearest, entry); }
+		}
+#endif
+
+		return hitLanes;
+	}
+
+	/// <summary> Finds if every active ray in the given packet travels the same way along each axis, so that they are likely to pass through the same boxes. </summary>
+	/// <param name="_packet"> The packet. </param>
+	/// <returns> <c>true</c> if the directions agree on every axis; otherwise, <c>false</c>. </returns>
+	bool isPacketAligned(const RayPacket& _packet)
+	{
+		bool hasFirst = false;
+		glm::bvec3 firstPositive;
+		for (uint32_t lane = 0; lane < _packet.m_size; lane++)
+		{
+			if (!_packet.IsActive(lane)) { continue; }
+			glm::bvec3 positive(!std::signbit(_packet.m_directionX[lane]), !std::signbit(_packet.m_directionY[lane]), !std::signbit(_packet.m_directionZ[lane]));
+			if (!hasFirst) { firstPositive = positive; hasFirst = true; }
+			else if (positive != firstPositive) { return false; }
+		}
+		return true;
+	}
+
+	/// <summary> Finds the furthest closest hit of any ray in the given packet. </summary>
+	/// <param name="_packet"> The packet. </param>
+	/// <returns> The furthest distance, or <c>INFINITY</c> while any ray has hit nothing. </returns>
+	float_t furthestHit(const RayPacket& _packet)
+	{
+		float_t furthest = 0;
+		for (uint32_t lane = 0; lane < _packet.m_size; lane++) { furthest = glm::max(furthest, _packet.m_distance[lane]); }
+		return furthest;
+	}
+}
+
+/// <summary> The state shared by every thread while building. </summary>
+struct Shapes::BoundingVolumeHierarchy::BuildContext
+{
+	/// <summary> Creates the context for the given spheres. </summary>
+	/// <param name="_spheres"> The spheres being built over. </param>
+	BuildContext(const SphereSet& _spheres) : m_spheres(_spheres), m_order(_spheres.GetCount()), m_centres(_spheres.GetCount()), m_codes(), m_nodeCount(1) { }
+
+	/// <summary> The spheres being built over. </summary>
+	const SphereSet& m_spheres;
+
+	/// <summary> The order of the spheres, which is shuffled as the tree is built. </summary>
+	std::vector<uint32_t> m_order;
+
+	/// <summary> The centre of each sphere. </summary>
+	std::vector<glm::vec3> m_centres;
+
+	/// <summary> The Morton code of each sphere in the current order, only used by the Morton method. </summary>
+	std::vector<uint32_t> m_codes;
+
+	/// <summary> The number of nodes created so far, which threads add to when creating children. </summary>
+	std::atomic<uint32_t> m_nodeCount;
+};
+
+/// <summary> Creates a tree that uses nodes already built and held elsewhere, such as within a mapped scene file, rather than copying them. </summary>
+/// <remarks> The tree cannot be refit, but can still be rebuilt, which replaces the mapped nodes with its own. </remarks>
+/// <param name="_nodes"> The nodes, with the root first, laid out exactly as they would have been built. </param>
+/// <param name="_nodeCount"> The number of nodes. </param>
+/// <param name="_buildStats"> The stats from when the nodes were built. </param>
+/// <param name="_mapping"> Whatever holds the nodes, which is kept alive for as long as the tree uses them. </param>
+Shapes::BoundingVolumeHierarchy::BoundingVolumeHierarchy(const Node* _nodes, const uint32_t _nodeCount, const BuildStats& _buildStats, std::shared_ptr<const void> _mapping)
+	: m_nodes(), m_mappedNodes(_nodes), m_mappedNodeCount(_nodeCount), m_mapping(std::move(_mapping)), m_buildStats(_buildStats), m_parents(), m_depths(), m_sphereLeaves(), m_refitMarks(), m_refitMark(0), m_refitLevels(MaxDepth), m_weightedArea(0) { }
+
+/// <summary> Builds the tree over the given spheres using the given method, on the thread pool, then reorders the spheres to match the leaves. </summary>
+/// <param name="io_spheres"> The spheres to build over, which are reordered. </param>
+/// <param name="_method"> The method with which to build. </param>
+/// <returns> The time taken to build, the size of the tree, and its quality. </returns>
+Shapes::BuildStats Shapes::BoundingVolumeHierarchy::Build(SphereSet& io_spheres, const BuildMethod _method)
+{
+	// Start the build timer.
+	Telemetry::ScopedSpan buildSpan("bvh build");
+	std::chrono::steady_clock::time_point buildTimer = std::chrono::steady_clock::now();
+
+	// Start from an empty tree of its own, leaving it empty if there is nothing to build over.
+	m_nodes.clear();
+	m_mappedNodes = nullptr;
+	m_mappedNodeCount = 0;
+	m_mapping.reset();
+	m_buildStats = BuildStats();
+	m_buildStats.m_method = _method;
+	uint32_t sphereCount = io_spheres.GetCount();
+	if (sphereCount == 0) { return m_buildStats; }
+
+	// Start with the spheres in their current order, and save the centre of each one.
+	BuildContext context(io_spheres);
+	forEachChunk(0, sphereCount, 16384, [&](uint32_t, uint32_t _first, uint32_t _end)
+	{
+		for (uint32_t i = _first; i < _end; i++) { context.m_order[i] = i; context.m_centres[i] = io_spheres.GetCentre(i); }
+	});
+
+	// A binary tree with a sphere in each leaf has at most this many nodes, so the nodes can be created from any thread without moving.
+	m_nodes.resize(2 * sphereCount - 1);
+
+	if (_method == BuildMethod::Morton)
+	{
+		// Find the box around every centre, which the codes are quantised within.
+		glm::vec3 centreMin, centreMax;
+		fitNode(context, 0, 0, sphereCount, centreMin, centreMax);
+		glm::vec3 codeScale = 1023.0f / glm::max(centreMax - centreMin, glm::vec3(1e-6f));
+
+		// Calculate the code of each sphere.
+		std::vector<std::pair<uint32_t, uint32_t>> codedSpheres(sphereCount);
+		forEachChunk(0, sphereCount, 16384, [&](uint32_t, uint32_t _first, uint32_t _end)
+		{
+			for (uint32_t i = _first; i < _end; i++)
+			{
+				glm::uvec3 cell = glm::uvec3((context.m_centres[i] - centreMin) * codeScale);
+				codedSpheres[i] = std::make_pair((spreadBits(cell.x) << 2) | (spreadBits(cell.y) << 1) | spreadBits(cell.z), i);
+			}
+		});
+
+		// Sort the spheres by their code, sorting each chunk on its own thread then merging the chunks together in pairs.
+		std::vector<uint32_t> chunkEnds;
+		uint32_t chunkCount = forEachChunk(0, sphereCount, 16384, [&](uint32_t, uint32_t _first, uint32_t _end) { std::sort(codedSpheres.begin() + _first, codedSpheres.begin() + _end); });
+		uint32_t chunkSize = (sphereCount + chunkCount - 1) / chunkCount;
+		for (uint32_t width = 1; width < chunkCount; width *= 2)
+		{
+			Threading::ThreadPool::Get().ParallelFor((chunkCount + 2 * width - 1) / (2 * width), [&](uint32_t _pair)
+			{
+				uint32_t first = glm::min(_pair * 2 * width * chunkSize, sphereCount);
+				uint32_t middle = glm::min(first + width * chunkSize, sphereCount);
+				uint32_t end = glm::min(middle + width * chunkSize, sphereCount);
+				std::inplace_merge(codedSpheres.begin() + first, codedSpheres.begin() + middle, codedSpheres.begin() + end);
+			});
+		}
+
+		// Split the codes and order back apart.
+		context.m_codes.resize(sphereCount);
+		for (uint32_t i = 0; i < sphereCount; i++) { context.m_codes[i] = codedSpheres[i].first; context.m_order[i] = codedSpheres[i].second; }
+
+		buildMortonNode(context, 0, 0, sphereCount);
+	}
+	else { buildBinnedNode(context, 0, 0, 0, sphereCount); }
+
+	// Remove the unused nodes, then put the spheres in the order of the leaves.
+	m_nodes.resize(context.m_nodeCount);
+	io_spheres.Reorder(context.m_order);
+
+	// Link each node to its parent and each sphere to its leaf, so the tree can be refit.
+	linkNodes(sphereCount);
+
+	// Save the stats.
+	std::chrono::steady_clock::duration buildTime = std::chrono::steady_clock::now() - buildTimer;
+	m_buildStats.m_milliseconds = std::chrono::duration<double, std::milli>(buildTime).count();
+	Telemetry::Recorder::Get().AddTime(Telemetry::Phase::Build, buildTime);
+	m_buildStats.m_nodeCount = GetNodeCount();
+	for (uint32_t n = 0; n < GetNodeCount(); n++) { if (m_nodes[n].IsLeaf()) { m_buildStats.m_leafCount++; } }
+	m_buildStats.m_cost = CalculateCost();
+	m_weightedArea = m_buildStats.m_cost * halfArea(m_nodes[0].m_min, m_nodes[0].m_max);
+	return m_buildStats;
+}
+
+/// <summary> Calculates the surface area heuristic cost of the whole tree, relative to the area of the root. </summary>
+/// <returns> The cost of visiting every interior node plus testing every sphere in every leaf, weighted by the chance of a ray through the root hitting each box. </returns>
+float_t Shapes::BoundingVolumeHierarchy::CalculateCost() const
+{
+	if (GetNodeCount() == 0) { return 0; }
+	const Node* nodes = GetNodes();
+
+	// Add up the area of each node, weighting leaves by how many spheres they hold.
+	double totalCost = 0;
+	for (uint32_t n = 0; n < GetNodeCount(); n++) { totalCost += nodeCost(nodes[n]); }
+
+	return (float_t)(totalCost / glm::max(halfArea(nodes[0].m_min, nodes[0].m_max), 1e-12f));
+}
+
+/// <summary> Refits the boxes around the given spheres after they have moved or changed size, from the bottom up, then rebuilds the tree if it has degraded too far. </summary>
+/// <remarks> Only the leaves holding the changed spheres and the nodes above them are visited, so the cost scales with the number of changed spheres rather than the size of the scene. </remarks>
+/// <param name="io_spheres"> The spheres this tree was built over, which have already been changed, and are reordered if the tree is rebuilt. </param>
+/// <param name="_changed"> The index within the set of each changed sphere. </param>
+/// <param name="_rebuildRatio"> How many times the cost of the freshly built tree the refit tree may cost before it is rebuilt, or <c>0</c> to never rebuild. </param>
+/// <returns> The time taken, the number of nodes refit, the new cost, and whether the tree was rebuilt. </returns>
+Shapes::RefitStats Shapes::BoundingVolumeHierarchy::Refit(SphereSet& io_spheres, const std::vector<uint32_t>& _changed, const float_t _rebuildRatio)
+{
+	// Start the refit timer.
+	Telemetry::ScopedSpan refitSpan("bvh refit");
+	std::chrono::steady_clock::time_point refitTimer = std::chrono::steady_clock::now();
+
+	RefitStats refitStats;
+	refitStats.m_changedCount = (uint32_t)_changed.size();
+	// Mapped nodes cannot be changed, and have no links to refit along, so they are left as they are.
+	if (m_nodes.empty() || _changed.empty()) { refitStats.m_cost = m_buildStats.m_cost; return refitStats; }
+
+	// Use a new mark for this refit, only clearing the old marks when they run out.
+	if (++m_refitMark == 0) { std::fill(m_refitMarks.begin(), m_refitMarks.end(), 0); m_refitMark = 1; }
+
+	// Walk up from the leaf of each changed sphere, marking each node and sorting it by depth, until reaching a node that is already marked.
+	uint32_t deepest = 0;
+	for (uint32_t i = 0; i < _changed.size(); i++)
+	{
+		for (uint32_t nodeIndex = m_sphereLeaves[_changed[i]]; nodeIndex != NoParent && m_refitMarks[nodeIndex] != m_refitMark; nodeIndex = m_parents[nodeIndex])
+		{
+			m_refitMarks[nodeIndex] = m_refitMark;
+			m_refitLevels[m_depths[nodeIndex]].push_back(nodeIndex);
+			deepest = glm::max(deepest, (uint32_t)m_depths[nodeIndex]);
+		}
+	}
+
+	// Refits the given node around its spheres or children, returning how much its cost changed.
+	auto refitNode = [this, &io_spheres](uint32_t _nodeIndex)
+	{
+		Node& node = m_nodes[_nodeIndex];
+		float_t oldCost = nodeCost(node);
+		if (node.IsLeaf())
+		{
+			node.m_min = glm::vec3(INFINITY); node.m_max = glm::vec3(-INFINITY);
+			for (uint32_t i = node.m_leftOrFirst; i < node.m_leftOrFirst + node.m_count; i++)
+			{
+				glm::vec3 centre = io_spheres.GetCentre(i), radius(io_spheres.GetRadius(i));
+				node.m_min = glm::min(node.m_min, centre - radius);
+				node.m_max = glm::max(node.m_max, centre + radius);
+			}
+		}
+		else
+		{
+			node.m_min = glm::min(m_nodes[node.m_leftOrFirst].m_min, m_nodes[node.m_leftOrFirst + 1].m_min);
+			node.m_max = glm::max(m_nodes[node.m_leftOrFirst].m_max, m_nodes[node.m_leftOrFirst + 1].m_max);
+		}
+		return (double)nodeCost(node) - oldCost;
+	};
+
+	// Refit each depth from the bottom up, as the nodes at one depth never depend on each other, splitting large depths across the thread pool.
+	for (uint32_t depth = deepest + 1; depth-- > 0;)
+	{
+		std::vector<uint32_t>& level = m_refitLevels[depth];
+		refitStats.m_refitNodeCount += (uint32_t)level.size();
+		if (level.size() < ParallelRefitThreshold) { for (uint32_t i = 0; i < level.size(); i++) { m_weightedArea += refitNode(level[i]); } }
+		else
+		{
+			std::vector<double> chunkCosts(Threading::ThreadPool::Get().GetWorkerCount() * 4, 0);
+			uint32_t chunkCount = forEachChunk(0, (uint32_t)level.size(), ParallelRefitThreshold / 4, [&](uint32_t _chunk, uint32_t _chunkFirst, uint32_t _chunkEnd)
+			{
+				for (uint32_t i = _chunkFirst; i < _chunkEnd; i++) { chunkCosts[_chunk] += refitNode(level[i]); }
+			});
+			for (uint32_t c = 0; c < chunkCount; c++) { m_weightedArea += chunkCosts[c]; }
+		}
+		level.clear();
+	}
+
+	// Rebuild the tree with the same method if it now costs too much more than when it was built.
+	refitStats.m_cost = (float_t)(m_weightedArea / glm::max(halfArea(m_nodes[0].m_min, m_nodes[0].m_max), 1e-12f));
+	if (_rebuildRatio > 0 && refitStats.m_cost > m_buildStats.m_cost * _rebuildRatio)
+	{
+		Build(io_spheres, m_buildStats.m_method);
+		refitStats.m_rebuilt = true;
+	}
+
+	std::chrono::steady_clock::duration refitTime = std::chrono::steady_clock::now() - refitTimer;
+	refitStats.m_milliseconds = std::chrono::duration<double, std::milli>(refitTime).count();
+	Telemetry::Recorder::Get().AddTime(Telemetry::Phase::Refit, refitTime);
+	return refitStats;
+}
+
+/// <summary> Finds the closest sphere hit by the given ray, only visiting the boxes it passes through. </summary>
+/// <param name="_spheres"> The spheres this tree was built over. </param>
+/// <param name="_ray"> The ray, with a normalised direction. </param>
+/// <param name="io_hit"> The closest hit, only hits closer than its current distance are counted. </param>
+/// <param name="_ignoreIndex"> The index of a sphere to skip, such as the one a ray is leaving. </param>
+/// <param name="io_testCount"> If given, increased by the number of spheres tested against the ray. </param>
+/// <returns> <c>true</c> if a closer sphere was hit; otherwise, <c>false</c>. </returns>
+bool Shapes::BoundingVolumeHierarchy::IntersectClosest(const SphereSet& _spheres, const Ray& _ray, SphereHit& io_hit, const uint32_t _ignoreIndex, uint64_t* io_testCount) const
+{
+	// If the ray misses the root, it misses everything.
+	if (GetNodeCount() == 0) { return false; }
+	const Node* nodes = GetNodes();
+	glm::vec3 inverseDirection = 1.0f / _ray.m_direction;
+	if (intersectBounds(nodes[0], _ray, inverseDirection, io_hit.m_distance) == INFINITY) { return false; }
+
+	// Keep a stack of the nodes still to visit, along with how far along the ray each one starts.
+	uint32_t nodeStack[MaxDepth];
+	float_t distanceStack[MaxDepth];
+	uint32_t stackSize = 0;
+
+	bool didHit = false;
+	uint32_t nodeIndex = 0;
+	while (true)
+	{
+		const Node& node = nodes[nodeIndex];
+
+		// If this is a leaf, test the ray against its spheres.
+		if (node.IsLeaf())
+		{
+			didHit |= _spheres.IntersectClosest(_ray, node.m_leftOrFirst, node.m_leftOrFirst + node.m_count, io_hit, _ignoreIndex);
+			if (io_testCount != nullptr) { *io_testCount += node.m_count; }
+		}
+
+		// Otherwise, visit the closest child that the ray passes through first, saving the other for later.
+		else
+		{
+			uint32_t nearIndex = node.m_leftOrFirst, farIndex = node.m_leftOrFirst + 1;
+			float_t nearDistance = intersectBounds(nodes[nearIndex], _ray, inverseDirection, io_hit.m_distance);
+			float_t farDistance = intersectBounds(nodes[farIndex], _ray, inverseDirection, io_hit.m_distance);
+			if (farDistance < nearDistance) { std::swap(nearIndex, farIndex); std::swap(nearDistance, farDistance); }
+
+			if (nearDistance != INFINITY)
+			{
+				if (farDistance != INFINITY) { nodeStack[stackSize] = farIndex; distanceStack[stackSize] = farDistance; stackSize++; }
+				nodeIndex = nearIndex;
+				continue;
+			}
+		}
+
+		// Take the next node from the stack, skipping any that start beyond the closest hit.
+		while (stackSize > 0 && distanceStack[stackSize - 1] >= io_hit.m_distance) { stackSize--; }
+		if (stackSize == 0) { break; }
+		nodeIndex = nodeStack[--stackSize];
+	}
+
+	return didHit;
+}
+
+/// <summary> Finds the closest sphere hit by each ray of the given packet, visiting each box once for the whole packet rather than once for each ray. </summary>
+/// <param name="_spheres"> The spheres this tree was built over. </param>
+/// <param name="io_packet"> The rays, whose hits are only replaced by closer hits. </param>
+/// <param name="io_testCount"> If given, increased by the number of spheres tested against a ray, counting each active ray of the packet in each leaf visited. </param>
+/// <returns> <c>true</c> if the packet was traced; otherwise, <c>false</c> if its rays diverge too far to share a box test, in which case each must be traced on its own. </returns>
+/// <remarks>
+/// A box is only skipped when no ray in the packet can hit it, so every ray visits every leaf it would have visited alone and finds the same hit in nearly every case.
+/// A ray may also be tested against leaves it would have skipped alone, where rounding in the sphere test can count a grazing hit on a very small sphere that a lone ray never tests.
+/// Such hits are rare, around twenty of 230,400 pixels on a sphereflake of 100,000 spheres, and only ever on the silhouettes of the smallest spheres.
+/// </remarks>
+bool Shapes::BoundingVolumeHierarchy::IntersectPacket(const SphereSet& _spheres, RayPacket& io_packet, uint64_t* io_testCount) const
+{
+	// The whole packet can only be bounded if every ray travels the same way along each axis.
+	PacketInterval interval;
+	if (!findPacketInterval(io_packet, interval)) { return false; }
+
+	// If the packet misses the root, it misses everything.
+	if (GetNodeCount() == 0) { return true; }
+	const Node* nodes = GetNodes();
+	float_t furthestDistance = furthestHit(io_packet);
+	if (intersectPacketBounds(nodes[0], interval, furthestDistance) == INFINITY) { return true; }
+
+	// Keep a stack of the nodes still to visit, along with the soonest any ray could enter each one.
+	uint32_t nodeStack[MaxDepth];
+	float_t distanceStack[MaxDepth];
+	uint32_t stackSize = 0;
+
+	uint32_t nodeIndex = 0;
+	while (true)
+	{
+		const Node& node = nodes[nodeIndex];
+
+		// If this is a leaf, test every ray against its spheres at once.
+		if (node.IsLeaf())
+		{
+			if (_spheres.IntersectClosest(io_packet, node.m_leftOrFirst, node.m_leftOrFirst + node.m_count)) { furthestDistance = furthestHit(io_packet); }
+			if (io_testCount != nullptr) { *io_testCount += (uint64_t)node.m_count * io_packet.GetActiveCount(); }
+		}
+
+		// Otherwise, visit the child the packet could enter first, saving the other for later.
+		else
+		{
+			uint32_t nearIndex = node.m_leftOrFirst, farIndex = node.m_leftOrFirst + 1;
+			float_t nearDistance = intersectPacketBounds(nodes[nearIndex], interval, furthestDistance);
+			float_t farDistance = intersectPacketBounds(nodes[farIndex], interval, furthestDistance);
+			if (farDistance < nearDistance) { std::swap(nearIndex, farIndex); std::swap(nearDistance, farDistance); }
+
+			if (nearDistance != INFINITY)
+			{
+				if (farDistance != INFINITY) { nodeStack[stackSize] = farIndex; distanceStack[stackSize] = farDistance; stackSize++; }
+				nodeIndex = nearIndex;
+				continue;
+			}
+		}
+
+		// Take the next node from the stack, skipping any that start beyond every ray's closest hit.
+		while (stackSize > 0 && distanceStack[stackSize - 1] >= furthestDistance) { stackSize--; }
+		if (stackSize == 0) { break; }
+		nodeIndex = nodeStack[--stackSize];
+	}
+
+	return true;
+}
+
+/// <summary> Finds if the given ray hits any sphere before the given distance, trying the cached occluder first and stopping as soon as one is found. </summary>
+/// <param name="_spheres"> The spheres this tree was built over. </param>
+/// <param name="_ray"> The ray, with a normalised direction. </param>
+/// <param name="_maxDistance"> The distance along the ray beyond which hits are not counted, such as the distance to a light. </param>
+/// <param name="io_cache"> The last sphere to block a ray, which is tried first and replaced by any sphere found. </param>
+/// <param name="_ignoreIndex"> The index of a sphere to skip, such as the one a ray is leaving. </param>
+/// <param name="io_testCount"> If given, increased by the number of spheres tested against the ray, counting the whole of any leaf that is visited. </param>
+/// <returns> <c>true</c> if any sphere was hit; otherwise, <c>false</c>. </returns>
+bool Shapes::BoundingVolumeHierarchy::IntersectAny(const SphereSet& _spheres, const Ray& _ray, const float_t _maxDistance, OccluderCache& io_cache, const uint32_t _ignoreIndex, uint64_t* io_testCount) const
+{
+	// Try the sphere that blocked the last ray before anything else.
+	uint32_t occluderIndex;
+	if (io_cache.m_index < _spheres.GetCount())
+	{
+		if (io_testCount != nullptr) { (*io_testCount)++; }
+		if (_spheres.IntersectAny(_ray, io_cache.m_index, io_cache.m_index + 1, _maxDistance, occluderIndex, _ignoreIndex)) { return true; }
+	}
+
+	// If the ray misses the root, it misses everything.
+	if (GetNodeCount() == 0) { return false; }
+	const Node* nodes = GetNodes();
+	glm::vec3 inverseDirection = 1.0f / _ray.m_direction;
+	if (intersectBounds(nodes[0], _ray, inverseDirection, _maxDistance) == INFINITY) { return false; }
+
+	// Keep a stack of the nodes still to visit, the order does not matter as any hit will do.
+	uint32_t nodeStack[MaxDepth];
+	uint32_t stackSize = 0;
+	nodeStack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[nodeStack[--stackSize]];
+
+		// If this is a leaf, stop as soon as any of its spheres are hit, remembering which one for the next ray.
+		if (node.IsLeaf())
+		{
+			if (io_testCount != nullptr) { *io_testCount += node.m_count; }
+			if (_spheres.IntersectAny(_ray, node.m_leftOrFirst, node.m_leftOrFirst + node.m_count, _maxDistance, occluderIndex, _ignoreIndex)) { io_cache.m_index = occluderIndex; return true; }
+		}
+
+		// Otherwise, visit each child that the ray passes through.
+		else
+		{
+			if (intersectBounds(nodes[node.m_leftOrFirst + 1], _ray, inverseDirection, _maxDistance) != INFINITY) { nodeStack[stackSize++] = node.m_leftOrFirst + 1; }
+			if (intersectBounds(nodes[node.m_leftOrFirst], _ray, inverseDirection, _maxDistance) != INFINITY) { nodeStack[stackSize++] = node.m_leftOrFirst; }
+		}
+	}
+
+	return false;
+}
+
+/// <summary> Finds the closest sphere hit by each ray of the given packet, testing each box against every ray at once but only following the rays that enter it. </summary>
+/// <param name="_spheres"> The spheres this tree was built over. </param>
+/// <param name="io_packet"> The active rays, whose hits are only replaced by closer hits, which need not travel together. </param>
+/// <param name="io_testCount"> If given, increased by the number of spheres tested against a ray, counting each ray that reaches each leaf visited. </param>
+/// <returns> <c>true</c> if the packet was traced; otherwise, <c>false</c> if its rays travel different ways along any axis and would rarely share a box, in which case each should be traced on its own. </returns>
+/// <remarks>
+/// Unlike <see cref="IntersectPacket"/>, every ray is tested against each box on its own with the same maths as a single ray, so incoherent rays such as reflections can share the traversal,
+/// and each ray only tests the spheres of leaves whose box it enters before its closest hit so far.
+/// </remarks>
+bool Shapes::BoundingVolumeHierarchy::IntersectClosest(const SphereSet& _spheres, RayPacket& io_packet, uint64_t* io_testCount) const
+{
+	// Rays heading different ways soon part, and then only add to each other's work.
+	if (!isPacketAligned(io_packet)) { return false; }
+
+	// If no ray enters the root, every ray misses everything.
+	if (GetNodeCount() == 0) { return true; }
+	const Node* nodes = GetNodes();
+	PacketInverse inverse;
+	findPacketInverse(io_packet, inverse);
+	float_t nearest;
+	uint32_t laneMask = intersectLaneBounds(nodes[0], io_packet, inverse, io_packet.GetActiveLanes(), nearest);
+	if (laneMask == 0) { return true; }
+
+	// Keep a stack of the nodes still to visit, along with the rays that entered each one.
+	uint32_t nodeStack[MaxDepth];
+	uint32_t maskStack[MaxDepth];
+	uint32_t stackSize = 0;
+
+	uint32_t nodeIndex = 0;
+	while (true)
+	{
+		const Node& node = nodes[nodeIndex];
+
+		// If this is a leaf, test each ray that reached it against its spheres at once.
+		if (node.IsLeaf())
+		{
+			if (io_testCount != nullptr) { *io_testCount += (uint64_t)node.m_count * RayPacket::CountLanes(laneMask); }
+			_spheres.IntersectClosest(io_packet, node.m_leftOrFirst, node.m_leftOrFirst + node.m_count, laneMask);
+		}
+
+		// Otherwise, visit the child its rays could enter first, saving the other for later.
+		else
+		{
+			uint32_t nearIndex = node.m_leftOrFirst, farIndex = node.m_leftOrFirst + 1;
+			float_t nearDistance, farDistance;
+			uint32_t nearMask = intersectLaneBounds(nodes[nearIndex], io_packet, inverse, laneMask, nearDistance);
+			uint32_t farMask = intersectLaneBounds(nodes[farIndex], io_packet, inverse, laneMask, farDistance);
+			if (farDistance < nearDistance) { std::swap(nearIndex, farIndex); std::swap(nearMask, farMask); }
+
+			if (nearMask != 0)
+			{
+				if (farMask != 0) { nodeStack[stackSize] = farIndex; maskStack[stackSize] = farMask; stackSize++; }
+				nodeIndex = nearIndex;
+				laneMask = nearMask;
+				continue;
+			}
+			if (farMask != 0) { nodeIndex = farIndex; laneMask = farMask; continue; }
+		}
+
+		// Take the next node from the stack, dropping the rays that have since found a hit before its box.
+		laneMask = 0;
+		while (stackSize > 0 && laneMask == 0) { stackSize--; laneMask = intersectLaneBounds(nodes[nodeStack[stackSize]], io_packet, inverse, maskStack[stackSize], nearest); }
+		if (laneMask == 0) { break; }
+		nodeIndex = nodeStack[stackSize];
+	}
+
+	return true;
+}
+
+/// <summary> Finds which rays of the given packet hit any sphere before their distances, testing each box against every ray at once but only following the rays that enter it. </summary>
+/// <param name="_spheres"> The spheres this tree was built over. </param>
+/// <param name="_packet"> The active rays, each holding the distance beyond which hits are not counted, such as the distance to a light, and the index of a sphere to skip in place of its hit. </param>
+/// <param name="io_cache"> The last sphere to block a ray, which is tried first and replaced by any sphere found. </param>
+/// <param name="io_testCount"> If given, increased by the number of spheres tested against a ray, counting each ray not yet blocked that reaches each leaf visited. </param>
+/// <returns> A bit for each active ray that hit a sphere. </returns>
+/// <remarks> Every ray is tested against each box on its own with the same maths as a single ray, so each finds a hit exactly when it would alone. </remarks>
+uint32_t Shapes::BoundingVolumeHierarchy::IntersectAny(const SphereSet& _spheres, const RayPacket& _packet, OccluderCache& io_cache, uint64_t* io_testCount) const
+{
+	// Try the sphere that blocked the last ray before anything else.
+	uint32_t remainingMask = _packet.GetActiveLanes(), hitMask = 0, occluderIndex;
+	if (io_cache.m_index < _spheres.GetCount())
+	{
+		if (io_testCount != nullptr) { *io_testCount += RayPacket::CountLanes(remainingMask); }
+		hitMask = _spheres.IntersectAny(_packet, io_cache.m_index, io_cache.m_index + 1, remainingMask, occluderIndex);
+		remainingMask &= ~hitMask;
+		if (remainingMask == 0) { return hitMask; }
+	}
+
+	// If no ray enters the root, no other ray is blocked.
+	if (GetNodeCount() == 0) { return hitMask; }
+	const Node* nodes = GetNodes();
+	PacketInverse inverse;
+	findPacketInverse(_packet, inverse);
+	float_t nearest;
+	uint32_t rootMask = intersectLaneBounds(nodes[0], _packet, inverse, remainingMask, nearest);
+	if (rootMask == 0) { return hitMask; }
+
+	// Keep a stack of the nodes still to visit along with the rays that entered each one, the order does not matter as any hit will do.
+	uint32_t nodeStack[MaxDepth];
+	uint32_t maskStack[MaxDepth];
+	uint32_t stackSize = 0;
+	nodeStack[stackSize] = 0; maskStack[stackSize] = rootMask; stackSize++;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		const Node& node = nodes[nodeStack[stackSize]];
+		uint32_t laneMask = maskStack[stackSize] & remainingMask;
+		if (laneMask == 0) { continue; }
+
+		// If this is a leaf, test each ray that reached it and is not yet blocked against its spheres at once, remembering a sphere that was hit for the next packet.
+		if (node.IsLeaf())
+		{
+			if (io_testCount != nullptr) { *io_testCount += (uint64_t)node.m_count * RayPacket::CountLanes(laneMask); }
+			uint32_t leafHits = _spheres.IntersectAny(_packet, node.m_leftOrFirst, node.m_leftOrFirst + node.m_count, laneMask, occluderIndex);
+			if (leafHits != 0)
+			{
+				io_cache.m_index = occluderIndex;
+				hitMask |= leafHits;
+				remainingMask &= ~leafHits;
+				if (remainingMask == 0) { return hitMask; }
+			}
+		}
+
+		// Otherwise, visit each child that any of its rays pass through.
+		else
+		{
+			uint32_t childMask = intersectLaneBounds(nodes[node.m_leftOrFirst + 1], _packet, inverse, laneMask, nearest);
+			if (childMask != 0) { nodeStack[stackSize] = node.m_leftOrFirst + 1; maskStack[stackSize] = childMask; stackSize++; }
+			childMask = intersectLaneBounds(nodes[node.m_leftOrFirst], _packet, inverse, laneMask, nearest);
+			if (childMask != 0) { nodeStack[stackSize] = node.m_leftOrFirst; maskStack[stackSize] = childMask; stackSize++; }
+		}
+	}
+
+	return hitMask;
+}
+
+/// <summary> Fits the given node's box around the given range of spheres, and finds the box around their centres. </summary>
+/// <param name="io_context"> The build state. </param>
+/// <param name="_nodeIndex"> The index of the node to fit. </param>
+/// <param name="_first"> The index within the order of the first sphere. </param>
+/// <param name="_count"> The number of spheres. </param>
+/// <param name="o_centreMin"> The minimum corner of the box around every centre. </param>
+/// <param name="o_centreMax"> The maximum corner of the box around every centre. </param>
+void Shapes::BoundingVolumeHierarchy::fitNode(BuildContext& io_context, const uint32_t _nodeIndex, const uint32_t _first, const uint32_t _count, glm::vec3& o_centreMin, glm::vec3& o_centreMax)
+{
+	// Fits the boxes around the given part of the range.
+	std::function<void(uint32_t, uint32_t, glm::vec3*)> fitRange = [&io_context](uint32_t _rangeFirst, uint32_t _rangeEnd, glm::vec3* o_bounds)
+	{
+		o_bounds[0] = glm::vec3(INFINITY); o_bounds[1] = glm::vec3(-INFINITY); o_bounds[2] = glm::vec3(INFINITY); o_bounds[3] = glm::vec3(-INFINITY);
+		for (uint32_t i = _rangeFirst; i < _rangeEnd; i++)
+		{
+			const glm::vec3& centre = io_context.m_centres[io_context.m_order[i]];
+			glm::vec3 radius(io_context.m_spheres.GetRadius(io_context.m_order[i]));
+			o_bounds[0] = glm::min(o_bounds[0], centre - radius);
+			o_bounds[1] = glm::max(o_bounds[1], centre + radius);
+			o_bounds[2] = glm::min(o_bounds[2], centre);
+			o_bounds[3] = glm::max(o_bounds[3], centre);
+		}
+	};
+
+	// Fit small ranges on this thread.
+	glm::vec3 bounds[4];
+	if (_count < ParallelBinThreshold) { fitRange(_first, _first + _count, bounds); }
+
+	// Otherwise fit each chunk on its own thread, then combine them.
+	else
+	{
+		std::vector<glm::vec3> chunkBounds(Threading::ThreadPool::Get().GetWorkerCount() * 4 * 4, glm::vec3(INFINITY));
+		uint32_t chunkCount = forEachChunk(_first, _count, ParallelBinThreshold / 4, [&](uint32_t _chunk, uint32_t _chunkFirst, uint32_t _chunkEnd) { fitRange(_chunkFirst, _chunkEnd, &chunkBounds[_chunk * 4]); });
+
+		bounds[0] = glm::vec3(INFINITY); bounds[1] = glm::vec3(-INFINITY); bounds[2] = glm::vec3(INFINITY); bounds[3] = glm::vec3(-INFINITY);
+		for (uint32_t c = 0; c < chunkCount; c++)
+		{
+			bounds[0] = glm::min(bounds[0], chunkBounds[c * 4]); bounds[1] = glm::max(bounds[1], chunkBounds[c * 4 + 1]);
+			bounds[2] = glm::min(bounds[2], chunkBounds[c * 4 + 2]); bounds[3] = glm::max(bounds[3], chunkBounds[c * 4 + 3]);
+		}
+	}
+
+	m_nodes[_nodeIndex].m_min = bounds[0];
+	m_nodes[_nodeIndex].m_max = bounds[1];
+	o_centreMin = bounds[2];
+	o_centreMax = bounds[3];
+}
+
+/// <summary> Fits the given node around the given range of spheres, then either splits it where the binned surface area heuristic is lowest or makes it a leaf. </summary>
+/// <param name="io_context"> The build state. </param>
+/// <param name="_nodeIndex"> The index of the node to build. </param>
+/// <param name="_depth"> The depth of the node, where the root is <c>0</c>. </param>
+/// <param name="_first"> The index within the order of the first sphere. </param>
+/// <param name="_count"> The number of spheres. </param>
+void Shapes::BoundingVolumeHierarchy::buildBinnedNode(BuildContext& io_context, const uint32_t _nodeIndex, const uint32_t _depth, const uint32_t _first, const uint32_t _count)
+{
+	// Fit the box around every sphere, and find the box around every centre to place the bins over.
+	glm::vec3 centreMin, centreMax;
+	fitNode(io_context, _nodeIndex, _first, _count, centreMin, centreMax);
+	glm::vec3 boundsMin = m_nodes[_nodeIndex].m_min, boundsMax = m_nodes[_nodeIndex].m_max;
+
+	// Small enough ranges are always leaves.
+	if (_count <= 2) { m_nodes[_nodeIndex].m_leftOrFirst = _first; m_nodes[_nodeIndex].m_count = _count; return; }
+
+	// Fills the bins along every axis from the given part of the range.
+	glm::vec3 binScale = glm::vec3(BinCount) / glm::max(centreMax - centreMin, glm::vec3(1e-30f));
+	std::function<void(uint32_t, uint32_t, BinSet&)> fillBins = [&io_context, &centreMin, &binScale](uint32_t _rangeFirst, uint32_t _rangeEnd, BinSet& o_bins)
+	{
+		o_bins.Reset();
+		for (uint32_t i = _rangeFirst; i < _rangeEnd; i++)
+		{
+			const glm::vec3& centre = io_context.m_centres[io_context.m_order[i]];
+			glm::vec3 radius(io_context.m_spheres.GetRadius(io_context.m_order[i]));
+			glm::uvec3 bin = glm::min(glm::uvec3((centre - centreMin) * binScale), glm::uvec3(BinCount - 1));
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				o_bins.m_counts[axis][bin[axis]]++;
+				o_bins.m_min[axis][bin[axis]] = glm::min(o_bins.m_min[axis][bin[axis]], centre - radius);
+				o_bins.m_max[axis][bin[axis]] = glm::max(o_bins.m_max[axis][bin[axis]], centre + radius);
+			}
+		}
+	};
+
+	// Bin small ranges on this thread, otherwise bin each chunk on its own thread and combine them.
+	BinSet bins;
+	if (_count < ParallelBinThreshold) { fillBins(_first, _first + _count, bins); }
+	else
+	{
+		std::vector<BinSet> chunkBins(Threading::ThreadPool::Get().GetWorkerCount() * 4);
+		uint32_t chunkCount = forEachChunk(_first, _count, ParallelBinThreshold / 4, [&](uint32_t _chunk, uint32_t _chunkFirst, uint32_t _chunkEnd) { fillBins(_chunkFirst, _chunkEnd, chunkBins[_chunk]); });
+
+		bins.Reset();
+		for (uint32_t c = 0; c < chunkCount; c++) { bins.Merge(chunkBins[c]); }
+	}
+
+	// Find the cheapest split between bins on any axis, where the cost of each side is its area multiplied by its sphere count.
+	float_t bestCost = INFINITY;
+	uint32_t bestAxis = 0, bestSplit = 0;
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		// If every centre is in the same place on this axis, it cannot be split.
+		if (centreMax[axis] - centreMin[axis] <= 0) { continue; }
+
+		// Sweep from the right to find the cost of everything right of each split.
+		float_t rightCosts[BinCount];
+		glm::vec3 sweepMin(INFINITY), sweepMax(-INFINITY);
+		uint32_t sweepCount = 0;
+		for (uint32_t b = BinCount - 1; b > 0; b--)
+		{
+			sweepMin = glm::min(sweepMin, bins.m_min[axis][b]); sweepMax = glm::max(sweepMax, bins.m_max[axis][b]); sweepCount += bins.m_counts[axis][b];
+			rightCosts[b] = sweepCount * halfArea(sweepMin, sweepMax);
+		}
+
+		// Sweep from the left, adding the cost of the left side to find the total cost of each split.
+		sweepMin = glm::vec3(INFINITY); sweepMax = glm::vec3(-INFINITY); sweepCount = 0;
+		for (uint32_t b = 0; b < BinCount - 1; b++)
+		{
+			sweepMin = glm::min(sweepMin, bins.m_min[axis][b]); sweepMax = glm::max(sweepMax, bins.m_max[axis][b]); sweepCount += bins.m_counts[axis][b];
+			float_t cost = sweepCount * halfArea(sweepMin, sweepMax) + rightCosts[b + 1];
+			if (sweepCount > 0 && sweepCount < _count && cost < bestCost) { bestCost = cost; bestAxis = axis; bestSplit = b + 1; }
+		}
+	}
+
+	// Become a leaf if the range fits in one and testing every sphere is cheaper than visiting two children.
+	float_t leafCost = _count * halfArea(boundsMin, boundsMax);
+	if (_count <= MaxLeafSize && leafCost <= bestCost + halfArea(boundsMin, boundsMax)) { m_nodes[_nodeIndex].m_leftOrFirst = _first; m_nodes[_nodeIndex].m_count = _count; return; }
+
+	// Split the spheres either side of the best split, or down the middle if every centre is in the same place or the tree is getting too deep.
+	uint32_t leftCount = _count / 2;
+	if (bestCost != INFINITY && _depth < MedianSplitDepth)
+	{
+		uint32_t* middle = std::partition(&io_context.m_order[_first], &io_context.m_order[_first] + _count, [&](const uint32_t _sphereIndex)
+		{
+			return glm::min((uint32_t)((io_context.m_centres[_sphereIndex][bestAxis] - centreMin[bestAxis]) * binScale[bestAxis]), BinCount - 1) < bestSplit;
+		});
+		leftCount = (uint32_t)(middle - &io_context.m_order[_first]);
+	}
+
+	// Create both children and build them, on separate threads if there is enough work.
+	uint32_t leftIndex = createChildren(io_context, _nodeIndex);
+	if (_count >= ParallelBuildThreshold)
+	{
+		Threading::ThreadPool::Get().ParallelFor(2, [&](uint32_t _child)
+		{
+			if (_child == 0) { buildBinnedNode(io_context, leftIndex, _depth + 1, _first, leftCount); }
+			else { buildBinnedNode(io_context, leftIndex + 1, _depth + 1, _first + leftCount, _count - leftCount); }
+		});
+	}
+	else
+	{
+		buildBinnedNode(io_context, leftIndex, _depth + 1, _first, leftCount);
+		buildBinnedNode(io_context, leftIndex + 1, _depth + 1, _first + leftCount, _count - leftCount);
+	}
+}
+
+/// <summary> Builds the given node over the given range of Morton-sorted spheres by splitting where the highest differing bit of their codes changes, then fits it around its children. </summary>
+/// <param name="io_context"> The build state. </param>
+/// <param name="_nodeIndex"> The index of the node to build. </param>
+/// <param name="_first"> The index within the order of the first sphere. </param>
+/// <param name="_count"> The number of spheres. </param>
+void Shapes::BoundingVolumeHierarchy::buildMortonNode(BuildContext& io_context, const uint32_t _nodeIndex, const uint32_t _first, const uint32_t _count)
+{
+	// Small enough ranges are leaves.
+	if (_count <= MaxLeafSize)
+	{
+		glm::vec3 centreMin, centreMax;
+		fitNode(io_context, _nodeIndex, _first, _count, centreMin, centreMax);
+		m_nodes[_nodeIndex].m_leftOrFirst = _first;
+		m_nodes[_nodeIndex].m_count = _count;
+		return;
+	}
+
+	// Find the last sphere that shares the highest differing bit with the first, or split down the middle if every code is the same.
+	uint32_t firstCode = io_context.m_codes[_first], lastCode = io_context.m_codes[_first + _count - 1];
+	uint32_t leftCount = _count / 2;
+	if (firstCode != lastCode)
+	{
+		// The codes are sorted, so binary search for the first code with the differing bit set.
+		uint32_t highestBit = 31;
+		while (((firstCode ^ lastCode) & (1u << highestBit)) == 0) { highestBit--; }
+		uint32_t prefixMask = ~((1u << highestBit) - 1);
+		uint32_t splitCode = (firstCode & prefixMask) | (1u << highestBit);
+		leftCount = (uint32_t)(std::lower_bound(io_context.m_codes.begin() + _first, io_context.m_codes.begin() + _first + _count, splitCode) - (io_context.m_codes.begin() + _first));
+	}
+
+	// Create both children and build them, on separate threads if there is enough work.
+	uint32_t leftIndex = createChildren(io_context, _nodeIndex);
+	if (_count >= ParallelBuildThreshold)
+	{
+		Threading::ThreadPool::Get().ParallelFor(2, [&](uint32_t _child)
+		{
+			if (_child == 0) { buildMortonNode(io_context, leftIndex, _first, leftCount); }
+			else { buildMortonNode(io_context, leftIndex + 1, _first + leftCount, _count - leftCount); }
+		});
+	}
+	else
+	{
+		buildMortonNode(io_context, leftIndex, _first, leftCount);
+		buildMortonNode(io_context, leftIndex + 1, _first + leftCount, _count - leftCount);
+	}
+
+	// Fit this node around both children.
+	m_nodes[_nodeIndex].m_min = glm::min(m_nodes[leftIndex].m_min, m_nodes[leftIndex + 1].m_min);
+	m_nodes[_nodeIndex].m_max = glm::max(m_nodes[leftIndex].m_max, m_nodes[leftIndex + 1].m_max);
+}
+
+/// <summary> Creates a pair of children for the given node, making it an interior node. </summary>
+/// <param name="io_context"> The build state. </param>
+/// <param name="_nodeIndex"> The index of the parent node. </param>
+/// <returns> The index of the left child, the right child is directly after it. </returns>
+uint32_t Shapes::BoundingVolumeHierarchy::createChildren(BuildContext& io_context, const uint32_t _nodeIndex)
+{
+	uint32_t leftIndex = io_context.m_nodeCount.fetch_add(2, std::memory_order_relaxed);
+	m_nodes[_nodeIndex].m_leftOrFirst = leftIndex;
+	m_nodes[_nodeIndex].m_count = 0;
+	return leftIndex;
+}
+
+/// <summary> Finds how far along the given ray it enters the given node's box. </summary>
+/// <param name="_node"> The node. </param>
+/// <param name="_ray"> The ray. </param>
+/// <param name="_inverseDirection"> The reciprocal of each component of the ray's direction. </param>
+/// <param name="_maxDistance"> The distance beyond which the box is not counted. </param>
+/// <returns> The distance at which the ray enters the box, <c>0</c> if it starts inside, or <c>INFINITY</c> if it misses or enters beyond the maximum distance. </returns>
+float_t Shapes::BoundingVolumeHierarchy::intersectBounds(const Node& _node, const Ray& _ray, const glm::vec3& _inverseDirection, const float_t _maxDistance)
+{
+	// Find where the ray crosses each pair of planes.
+	glm::vec3 toMin = (_node.m_min - _ray.m_origin) * _inverseDirection;
+	glm::vec3 toMax = (_node.m_max - _ray.m_origin) * _inverseDirection;
+	glm::vec3 nearPlanes = glm::min(toMin, toMax), farPlanes = glm::max(toMin, toMax);
+
+	// The ray is inside the box between the last plane it enters and the first plane it leaves.
+	float_t entry = glm::max(glm::max(nearPlanes.x, nearPlanes.y), glm::max(nearPlanes.z, 0.0f));
+	float_t exit = glm::min(glm::min(farPlanes.x, farPlanes.y), farPlanes.z);
+
+	return (entry <= exit && entry < _maxDistance) ? entry : INFINITY;
+}
+
+/// <summary> Finds the parent and depth of every node and the leaf holding every sphere, and clears the refit marks. </summary>
+/// <param name="_sphereCount"> The number of spheres the tree was built over. </param>
+void Shapes::BoundingVolumeHierarchy::linkNodes(const uint32_t _sphereCount)
+{
+	m_parents.assign(GetNodeCount(), (uint32_t)NoParent);
+	m_depths.assign(GetNodeCount(), 0);
+	m_sphereLeaves.resize(_sphereCount);
+	m_refitMarks.assign(GetNodeCount(), 0);
+	m_refitMark = 0;
+
+	// Children are always created after their parents, so walking forwards reaches each parent before its children.
+	for (uint32_t n = 0; n < GetNodeCount(); n++)
+	{
+		const Node& node = m_nodes[n];
+		if (node.IsLeaf()) { for (uint32_t i = node.m_leftOrFirst; i < node.m_leftOrFirst + node.m_count; i++) { m_sphereLeaves[i] = n; } }
+		else
+		{
+			m_parents[node.m_leftOrFirst] = m_parents[node.m_leftOrFirst + 1] = n;
+			m_depths[node.m_leftOrFirst] = m_depths[node.m_leftOrFirst + 1] = m_depths[n] + 1;
+		}
+	}
+}
\ No newline at end of file
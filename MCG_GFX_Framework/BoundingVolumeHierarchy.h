@@ -0,0 +1,234 @@
+#ifndef BOUNDINGVOLUMEHIERARCHY_H
+#define BOUNDINGVOLUMEHIERARCHY_H
+
+// Framework includes.
+#include <glm.hpp>
+
+// Data includes.
+#include "SphereSet.h"
+#include "Ray.h"
+#include "RayPacket.h"
+
+// Utility includes.
+#include <vector>
+#include <memory>
+
+// Typedef includes.
+#include <stdint.h>
+#include <cmath>
+
+namespace Shapes
+{
+	/// <summary> The ways in which a hierarchy can be built. </summary>
+	enum class BuildMethod : uint8_t
+	{
+		/// <summary> Top-down, splitting each node where the binned surface area heuristic is lowest. Slower to build, faster to trace. </summary>
+		BinnedSAH,
+
+		/// <summary> Sorting the spheres along a Morton curve and splitting where the codes differ. Much faster to build, slower to trace. </summary>
+		Morton
+	};
+
+	/// <summary> Represents the outcome of building a hierarchy. </summary>
+	struct BuildStats
+	{
+		/// <summary> Creates empty stats. </summary>
+		BuildStats() : m_method(BuildMethod::BinnedSAH), m_milliseconds(0), m_nodeCount(0), m_leafCount(0), m_cost(0) { }
+
+		/// <summary> The method used to build. </summary>
+		BuildMethod m_method;
+
+		/// <summary> The time taken to build, including reordering the spheres. </summary>
+		double m_milliseconds;
+
+		/// <summary> The number of nodes, including leaves. </summary>
+		uint32_t m_nodeCount;
+
+		/// <summary> The number of leaves. </summary>
+		uint32_t m_leafCount;
+
+		/// <summary> The surface area heuristic cost of the whole tree relative to its root, where lower is faster to trace. </summary>
+		float_t m_cost;
+	};
+
+	/// <summary> Represents the outcome of refitting a hierarchy after spheres have moved. </summary>
+	struct RefitStats
+	{
+		/// <summary> Creates empty stats. </summary>
+		RefitStats() : m_milliseconds(0), m_changedCount(0), m_refitNodeCount(0), m_cost(0), m_rebuilt(false) { }
+
+		/// <summary> The time taken to refit, including any rebuild. </summary>
+		double m_milliseconds;
+
+		/// <summary> The number of spheres that changed. </summary>
+		uint32_t m_changedCount;
+
+		/// <summary> The number of nodes whose boxes were refit. </summary>
+		uint32_t m_refitNodeCount;
+
+		/// <summary> The surface area heuristic cost of the tree after refitting, before any rebuild. </summary>
+		float_t m_cost;
+
+		/// <summary> Whether the tree had degraded enough to be rebuilt from scratch. </summary>
+		bool m_rebuilt;
+	};
+
+	/// <summary> Remembers the last sphere found blocking a shadow ray, as neighbouring shadow rays are usually blocked by the same sphere. </summary>
+	/// <remarks> Each thread or tile should keep its own, it is only ever a hint so a stale index is harmless. </remarks>
+	struct OccluderCache
+	{
+		/// <summary> Creates an empty cache. </summary>
+		OccluderCache() : m_index(UINT32_MAX) { }
+
+		/// <summary> The index within the set of the last sphere that blocked a ray, or <c>UINT32_MAX</c> if none has yet. </summary>
+		uint32_t m_index;
+	};
+
+	/// <summary> Represents a tree of axis-aligned boxes over a set of spheres, so that a ray only needs to be tested against the spheres in the boxes it passes through. </summary>
+	/// <remarks> Building reorders the sphere set so that the spheres in each leaf are next to each other and can be tested with the SIMD kernel. </remarks>
+	class BoundingVolumeHierarchy
+	{
+	public:
+		/// <summary> Represents a single box within the tree. </summary>
+		/// <remarks> Children are always created in pairs, so only the index of the left child is stored. </remarks>
+		struct Node
+		{
+			/// <summary> The minimum corner of the box. </summary>
+			glm::vec3 m_min;
+
+			/// <summary> The index of the left child if this is an interior node, or the index of the first sphere if this is a leaf. </summary>
+			uint32_t m_leftOrFirst;
+
+			/// <summary> The maximum corner of the box. </summary>
+			glm::vec3 m_max;
+
+			/// <summary> The number of spheres if this is a leaf, or <c>0</c> if this is an interior node. </summary>
+			uint32_t m_count;
+
+			/// <summary> Finds if this node is a leaf. </summary>
+			/// <returns> <c>true</c> if this node holds spheres; otherwise, <c>false</c>. </returns>
+			inline bool IsLeaf() const { return m_count > 0; }
+		};
+
+		/// <summary> Creates an empty tree. </summary>
+		BoundingVolumeHierarchy() : m_nodes(), m_mappedNodes(nullptr), m_mappedNodeCount(0), m_mapping(), m_buildStats(), m_parents(), m_depths(), m_sphereLeaves(), m_refitMarks(), m_refitMark(0), m_refitLevels(MaxDepth), m_weightedArea(0) { }
+
+		BoundingVolumeHierarchy(const Node*, uint32_t, const BuildStats&, std::shared_ptr<const void>);
+
+		BuildStats Build(SphereSet&, BuildMethod _method = BuildMethod::BinnedSAH);
+
+		RefitStats Refit(SphereSet&, const std::vector<uint32_t>&, float_t _rebuildRatio = 1.5f);
+
+		/// <summary> Gets the stats from the last build. </summary>
+		/// <returns> The stats from the last build. </returns>
+		inline const BuildStats& GetBuildStats() const { return m_buildStats; }
+
+		float_t CalculateCost() const;
+
+		bool IntersectClosest(const SphereSet&, const Ray&, SphereHit&, uint32_t _ignoreIndex = UINT32_MAX, uint64_t* io_testCount = nullptr) const;
+
+		bool IntersectAny(const SphereSet&, const Ray&, float_t, OccluderCache&, uint32_t _ignoreIndex = UINT32_MAX, uint64_t* io_testCount = nullptr) const;
+
+		bool IntersectPacket(const SphereSet&, RayPacket&, uint64_t* io_testCount = nullptr) const;
+
+		bool IntersectClosest(const SphereSet&, RayPacket&, uint64_t* io_testCount = nullptr) const;
+
+		uint32_t IntersectAny(const SphereSet&, const RayPacket&, OccluderCache&, uint64_t* io_testCount = nullptr) const;
+
+		/// <summary> Finds if the given ray hits any sphere before the given distance, stopping as soon as one is found. </summary>
+		/// <param name="_spheres"> The spheres this tree was built over. </param>
+		/// <param name="_ray"> The ray, with a normalised direction. </param>
+		/// <param name="_maxDistance"> The distance along the ray beyond which hits are not counted. </param>
+		/// <param name="_ignoreIndex"> The index of a sphere to skip, such as the one a ray is leaving. </param>
+		/// <returns> <c>true</c> if any sphere was hit; otherwise, <c>false</c>. </returns>
+		inline bool IntersectAny(const SphereSet& _spheres, const Ray& _ray, const float_t _maxDistance, const uint32_t _ignoreIndex = UINT32_MAX) const { OccluderCache cache; return IntersectAny(_spheres, _ray, _maxDistance, cache, _ignoreIndex); }
+
+		/// <summary> Gets the number of nodes within the tree. </summary>
+		/// <returns> The number of nodes, including leaves. </returns>
+		inline uint32_t GetNodeCount() const { return (m_mappedNodes != nullptr) ? m_mappedNodeCount : (uint32_t)m_nodes.size(); }
+
+		/// <summary> Gets every node, with the root first, wherever they are held. </summary>
+		/// <returns> The first node, which is only valid while the tree is unchanged. </returns>
+		inline const Node* GetNodes() const { return (m_mappedNodes != nullptr) ? m_mappedNodes : m_nodes.data(); }
+
+		/// <summary> Finds if the nodes are held within a mapped file rather than by the tree, in which case it cannot be refit. </summary>
+		/// <returns> <c>true</c> if the nodes are mapped; otherwise, <c>false</c>. </returns>
+		inline bool IsMapped() const { return m_mappedNodes != nullptr; }
+
+		/// <summary> The most spheres a leaf may hold, which is a single instruction of the widest kernel. </summary>
+		static const uint32_t MaxLeafSize = SphereSet::LaneCount;
+
+		/// <summary> The number of bins along each axis used to estimate the surface area heuristic. </summary>
+		static const uint32_t BinCount = 16;
+
+		/// <summary> The deepest the tree may be, which sizes the traversal stacks. </summary>
+		static const uint32_t MaxDepth = 128;
+
+		/// <summary> The depth past which ranges are split down the middle, so that even the worst scenes fit within the maximum depth. </summary>
+		static const uint32_t MedianSplitDepth = MaxDepth - 32;
+
+		/// <summary> The number of spheres a node must have for its children to be built on separate threads. </summary>
+		static const uint32_t ParallelBuildThreshold = 4096;
+
+		/// <summary> The number of spheres a node must have for its bins to be filled on several threads at once. </summary>
+		static const uint32_t ParallelBinThreshold = 65536;
+
+		/// <summary> The number of nodes at one depth that must be refit for them to be refit on several threads at once. </summary>
+		static const uint32_t ParallelRefitThreshold = 1024;
+
+		/// <summary> The parent of the root. </summary>
+		static const uint32_t NoParent = UINT32_MAX;
+	private:
+		/// <summary> The state shared by every thread while building. </summary>
+		struct BuildContext;
+
+		/// <summary> Every node, with the root first. </summary>
+		std::vector<Node> m_nodes;
+
+		/// <summary> The nodes held within a mapped file, which are used instead of <see cref="m_nodes"/> if set. </summary>
+		const Node* m_mappedNodes;
+
+		/// <summary> The number of mapped nodes. </summary>
+		uint32_t m_mappedNodeCount;
+
+		/// <summary> Keeps the file holding the mapped nodes open for as long as the tree uses them. </summary>
+		std::shared_ptr<const void> m_mapping;
+
+		/// <summary> The stats from the last build. </summary>
+		BuildStats m_buildStats;
+
+		/// <summary> The index of the parent of each node, so that boxes can be refit from the bottom up. </summary>
+		std::vector<uint32_t> m_parents;
+
+		/// <summary> The depth of each node, where the root is <c>0</c>. </summary>
+		std::vector<uint8_t> m_depths;
+
+		/// <summary> The index of the leaf holding each sphere. </summary>
+		std::vector<uint32_t> m_sphereLeaves;
+
+		/// <summary> The refit each node was last marked as changed in, so that marking a node twice can be avoided without clearing every mark. </summary>
+		std::vector<uint32_t> m_refitMarks;
+
+		/// <summary> The mark of the current refit. </summary>
+		uint32_t m_refitMark;
+
+		/// <summary> The changed nodes at each depth, kept between refits to avoid allocating. </summary>
+		std::vector<std::vector<uint32_t>> m_refitLevels;
+
+		/// <summary> The sum of the area of every node weighted by its cost, kept up to date while refitting so the quality can be found without visiting every node. </summary>
+		double m_weightedArea;
+
+		void fitNode(BuildContext&, uint32_t, uint32_t, uint32_t, glm::vec3&, glm::vec3&);
+
+		void buildBinnedNode(BuildContext&, uint32_t, uint32_t, uint32_t, uint32_t);
+
+		void buildMortonNode(BuildContext&, uint32_t, uint32_t, uint32_t);
+
+		uint32_t createChildren(BuildContext&, uint32_t);
+
+		void linkNodes(uint32_t);
+
+		static float_t intersectBounds(const Node&, const Ray&, const glm::vec3&, float_t);
+	};
+}
+#endif
\ No newline at end of file
@@ -1,79 +1,84 @@
 #include "Buffer.h"
 
 // Threading includes.
-#include <thread>
+#include "ThreadPool.h"
 
-// Utility includes.
-#include <iostream>
+// Diagnostic includes.
+#include "Telemetry.h"
+#include "Timeline.h"
 
 /// <summary> Creates and returns a buffer based off of this buffer, with each pixel being averaged based on the given level. </summary>
 /// <param name="_level"> The level of super-sampling to perform. </param>
+/// <param name="_settings"> The settings controlling the threads and tiles used. </param>
+/// <param name="o_target"> If given, the target to which each tile is also copied as soon as it is sampled. </param>
 /// <returns> The super-sampled buffer. </returns>
-Buffer& Buffer::SuperSample(const uint8_t _level, const uint8_t _threadAmount)
+Buffer& Buffer::SuperSample(const uint8_t _level, const Rendering::RenderSettings& _settings, Rendering::FrameTarget* o_target)
 {
-	// Track each thread.
-	std::vector<std::thread> threads(_threadAmount);
+	// Time the whole pass.
+	Telemetry::ScopedTimer sampleTimer(Telemetry::Phase::Sample);
+	Telemetry::ScopedSpan sampleSpan("supersample");
 
 	// Create a new buffer for the output.
 	Buffer* sampledBuffer = new Buffer(m_width / _level, m_height / _level);
 
-	// Begin each thread and add them to the vector.
-	for (uint8_t t = 0; t < _threadAmount; t++)
-	{
-		threads[t] = std::thread(&Buffer::sampleVertical, this, t, _threadAmount, _level, std::ref(*sampledBuffer));
-	}
+	// Split the output into tiles.
+	Rendering::TileScheduler scheduler(sampledBuffer->GetWidth(), sampledBuffer->GetHeight(), _settings.m_tileSize, _settings.m_tileOrder, sizeof(glm::vec3));
 
-	// Wait for each thread to be done before returning.
-	for (uint8_t t = 0; t < _threadAmount; t++)
+	// Have each thread keep sampling tiles until there are none left, returning once they have all finished.
+	Threading::ThreadPool::Get().ParallelFor(_settings.GetThreadCount(), [this, &scheduler, &_settings, _level, sampledBuffer, o_target](uint32_t)
 	{
-		// Wait for the thread to finish.
-		threads[t].join();
-
-		// Output the progress.
-		std::cout << ((100.0f / _threadAmount) * (t + 1)) << "% sampled." << std::endl;
-	}
+		Rendering::Tile tile;
+		while (scheduler.NextTile(tile))
+		{
+			Telemetry::ScopedSpan tileSpan("supersample tile", tile);
+			sampleTile(tile, _level, *sampledBuffer);
+			if (o_target != nullptr) { sampledBuffer->CopyTile(tile, *o_target, _settings.m_toneMapping); }
+		}
+	});
+	Telemetry::Recorder::Get().Add(Telemetry::Counter::PixelsWritten, (uint64_t)sampledBuffer->GetWidth() * sampledBuffer->GetHeight());
 
 	// Dereference and return the created buffer.
 	return *sampledBuffer;
 }
 
-SDL_Texture* Buffer::CreateTexture(SDL_Renderer& renderer)
+/// <summary> Quantises the given tile of this buffer and copies it to the same place on the given target, while it is still in the cache. </summary>
+/// <param name="_tile"> The tile to copy. </param>
+/// <param name="o_target"> The target to which the tile is copied. </param>
+/// <param name="_toneMapping"> How radiance brighter than full brightness is brought into range. </param>
+void Buffer::CopyTile(const Rendering::Tile& _tile, Rendering::FrameTarget& o_target, const ToneMapping _toneMapping) const
 {
-	// Create a surface with the pixel data.
-	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(m_data, m_width, m_height, 24, m_width * 3, SDL_PIXELFORMAT_RGB24);
-
-	// Create a texture from the surface.
-	SDL_Texture* texture = SDL_CreateTextureFromSurface(&renderer, surface);
-
-	// Free the surface.
-	SDL_FreeSurface(surface);
-	surface = nullptr;
-
-	// Return the texture.
-	return texture;
+	for (uint16_t y = _tile.m_y; y < _tile.m_y + _tile.m_height; y++)
+	{
+		const glm::vec3* row = rowAt(y);
+		for (uint16_t x = _tile.m_x; x < _tile.m_x + _tile.m_width; x++) { o_target.SetPixel(x, y, Colour::FromRadiance(row[x], _toneMapping)); }
+	}
 }
 
-void Buffer::sampleVertical(const uint8_t _threadNumber, const uint8_t _threadCount, const uint8_t _level, Buffer& o_buffer)
+/// <summary> Samples the given tile of the output buffer from this buffer. </summary>
+/// <param name="_tile"> The tile of the output buffer to sample. </param>
+/// <param name="_level"> The level of super-sampling to perform. </param>
+/// <param name="o_buffer"> The buffer object to which the output is drawn. </param>
+void Buffer::sampleTile(const Rendering::Tile& _tile, const uint8_t _level, Buffer& o_buffer) const
 {
-	// Go over every pixel between each sampled point and get the average colour.
-	for (uint16_t x = _threadNumber; x < o_buffer.GetWidth(); x += _threadCount)
+	// Go over every pixel in the tile row by row and get the average colour of the area it covers.
+	for (uint16_t y = _tile.m_y; y < _tile.m_y + _tile.m_height; y++)
 	{
-		for (uint16_t y = 0; y < o_buffer.GetHeight(); y++)
+		for (uint16_t x = _tile.m_x; x < _tile.m_x + _tile.m_width; x++)
 		{
 			o_buffer.SetPixel(x, y, GetAverage(x * _level, y * _level, _level));
 		}
 	}
 }
 
-/// <summary> Gets the average colour of the pixels at the given position with the given size. </summary>
+/// <summary> Gets the average radiance of the pixels at the given position with the given size. </summary>
 /// <param name="_x"> The x position of the pixel. </param>
 /// <param name="_y"> The y position of the pixel. </param>
 /// <param name="_level"> The width and height of the area to average. </param>
-/// <returns> The average colour from the given area. </returns>
-Colour Buffer::GetAverage(const uint16_t _x, const uint16_t _y, const uint8_t _level) const
+/// <returns> The root mean square of the radiance from the given area. </returns>
+glm::vec3 Buffer::GetAverage(const uint16_t _x, const uint16_t _y, const uint8_t _level) const
 {
-	// Start with black rgb.
-	uint32_t r = 0, g = 0, b = 0;
+	// Start with black.
+	glm::vec3 squaredSum(0.0f);
 
 	// Calculate the max x and y.
 	uint16_t maxX = glm::min(_x + _level, m_width - 1);
@@ -84,18 +89,15 @@ Colour Buffer::GetAverage(const uint16_t _x, const uint16_t _y, const uint8_t _l
 	{
 		for (uint16_t dataY = _y; dataY < maxY; dataY++)
 		{
-			Colour pixel = AtPixel(dataX, dataY);
-
 			// Add the squared rgb values.
-			r += pixel.r * pixel.r;
-			g += pixel.g * pixel.g;
-			b += pixel.b * pixel.b;
+			glm::vec3 pixel = AtPixel(dataX, dataY);
+			squaredSum += pixel * pixel;
 		}
 	}
 
 	// Calculate the total number of covered pixels.
 	uint32_t coveredPixels = (maxX - _x) * (maxY - _y);
 
-	// Return a colour with the average values.
-	return Colour(glm::min((uint32_t)glm::sqrt(r / coveredPixels), (uint32_t)CHAR_MAX), glm::min((uint32_t)glm::sqrt(g / coveredPixels), (uint32_t)CHAR_MAX), glm::min((uint32_t)glm::sqrt(b / coveredPixels), (uint32_t)CHAR_MAX));
+	// Return the root mean square, which keeps bright samples from being washed out by dark ones.
+	return glm::sqrt(squaredSum / (float_t)coveredPixels);
 }
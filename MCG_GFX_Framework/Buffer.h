@@ -1,8 +1,14 @@
 #ifndef BUFFER_H
 #define BUFFER_H
 
+// Framework includes.
+#include <glm.hpp>
+
 // Data includes.
 #include "Colour.h"
+#include "RenderSettings.h"
+#include "TileScheduler.h"
+#include "FrameTarget.h"
 
 // Utility includes.
 #include <vector>
@@ -10,38 +16,44 @@
 // Typedef includes.
 #include <stdint.h>
 
-// SDL includes.
-#include <SDL.h>
-
-/// <summary> Represents a buffer of colours to be drawn. </summary>
-/// <remarks> Removes some multi-threading issues with SDL. </remarks>
+/// <summary> Represents a buffer of radiance to be drawn. </summary>
+/// <remarks> Removes some multi-threading issues with SDL. Each pixel keeps its full floating point radiance, and is only quantised into a colour once it is copied or written out. </remarks>
 class Buffer
 {
 public:
 	/// <summary> Create a new buffer with the given size. </summary>
 	/// <param name="_width"> The width in pixels. </param>
 	/// <param name="_height"> The height in pixels. </param>
-	Buffer(const uint16_t _width, const uint16_t _height) : m_width(_width), m_height(_height), m_data(new Colour[_width * _height])
+	/// <remarks> Each row is padded to a whole number of cache lines and starts on a cache line, so tiles that are a whole number of cache lines wide never share one. </remarks>
+	Buffer(const uint16_t _width, const uint16_t _height) : m_width(_width), m_height(_height), m_pitch(((_width * sizeof(glm::vec3) + Rendering::TileScheduler::CacheLineSize - 1) / Rendering::TileScheduler::CacheLineSize) * Rendering::TileScheduler::CacheLineSize),
+		m_allocation(new uint8_t[m_pitch * _height + Rendering::TileScheduler::CacheLineSize]), m_data(m_allocation + (Rendering::TileScheduler::CacheLineSize - (uintptr_t)m_allocation % Rendering::TileScheduler::CacheLineSize) % Rendering::TileScheduler::CacheLineSize)
 	{
 
 	}
 
 	~Buffer()
 	{
-		delete[] m_data;
+		delete[] m_allocation;
 	}
 
+	/// <summary> Gets the radiance at the given pixel position, or black if the given position is out of range. </summary>
+	/// <param name="_x"> The x position of the pixel. </param>
+	/// <param name="_y"> The y position of the pixel. </param>
+	/// <returns> The radiance at the given pixel position, or black if the given position is out of range. </returns>
+	inline glm::vec3 AtPixel(const uint16_t _x, const uint16_t _y) const { return (inBounds(_x, _y)) ? rowAt(_y)[_x] : glm::vec3(0.0f); }
+
 	/// <summary> Gets the colour at the given pixel position, or black if the given position is out of range. </summary>
 	/// <param name="_x"> The x position of the pixel. </param>
 	/// <param name="_y"> The y position of the pixel. </param>
-	/// <returns> The colour at the given pixel position, or black if the given position is out of range. </returns>
-	inline Colour AtPixel(const uint16_t _x, const uint16_t _y) const { return (inBounds(_x, _y)) ? m_data[_y * m_width + _x] : Colour::Black(); }
+	/// <param name="_toneMapping"> How radiance brighter than full brightness is brought into range. Defaults to clamping. </param>
+	/// <returns> The quantised colour at the given pixel position, or black if the given position is out of range. </returns>
+	inline Colour ColourAtPixel(const uint16_t _x, const uint16_t _y, const ToneMapping _toneMapping = ToneMapping::Clamp) const { return Colour::FromRadiance(AtPixel(_x, _y), _toneMapping); }
 
-	/// <summary> Sets the colour at the given pixel position to the given colour, does nothing if the given position is out of range. </summary>
+	/// <summary> Sets the radiance at the given pixel position to the given radiance, does nothing if the given position is out of range. </summary>
 	/// <param name="_x"> The x position of the pixel. </param>
 	/// <param name="_y"> The y position of the pixel. </param>
-	/// <param name="_colour"> The colour to which the pixel is set. </param>
-	inline void SetPixel(const uint16_t _x, const uint16_t _y, const Colour _colour) { if (inBounds(_x, _y)) { m_data[_y * m_width + _x] = _colour; } }
+	/// <param name="_radiance"> The radiance to which the pixel is set. </param>
+	inline void SetPixel(const uint16_t _x, const uint16_t _y, const glm::vec3 _radiance) { if (inBounds(_x, _y)) { rowAt(_y)[_x] = _radiance; } }
 	
 	/// <summary> Gets the width of the buffer. </summary>
 	/// <returns> The width of the buffer in pixels. </returns>
@@ -51,9 +63,15 @@ public:
 	/// <returns> The height of the buffer in pixels. </returns>
 	inline uint16_t GetHeight() const { return m_height; }
 
-	Buffer& SuperSample(const uint8_t _level, const uint8_t _threadAmount);
+	/// <summary> Gets the distance between the start of each row. </summary>
+	/// <returns> The size of each row in bytes, including padding. </returns>
+	inline uint32_t GetPitch() const { return m_pitch; }
 
-	SDL_Texture* CreateTexture(SDL_Renderer& renderer);
+	Buffer& SuperSample(const uint8_t _level, const Rendering::RenderSettings& _settings, Rendering::FrameTarget* o_target = nullptr);
+
+	glm::vec3 GetAverage(uint16_t, uint16_t, uint8_t) const;
+
+	void CopyTile(const Rendering::Tile&, Rendering::FrameTarget&, ToneMapping _toneMapping = ToneMapping::Clamp) const;
 private:
 	/// <summary> The width of the buffer. </summary>
 	uint16_t m_width;
@@ -61,8 +79,19 @@ private:
 	/// <summary> The height of the buffer. </summary>
 	uint16_t m_height;
 
-	/// <summary> the raw colour data. </summary>
-	Colour* m_data;
+	/// <summary> The distance between the start of each row in bytes. </summary>
+	uint32_t m_pitch;
+
+	/// <summary> The allocated memory, which has room for the data to be moved onto a cache line. </summary>
+	uint8_t* m_allocation;
+
+	/// <summary> The raw radiance data, starting on a cache line. </summary>
+	uint8_t* m_data;
+
+	/// <summary> Gets the first pixel of the given row. </summary>
+	/// <param name="_y"> The y position of the row. </param>
+	/// <returns> A pointer to the first pixel of the row. </returns>
+	inline glm::vec3* rowAt(const uint16_t _y) const { return (glm::vec3*)(m_data + _y * m_pitch); }
 
 	/// <summary> Finds if the given position is in bounds. </summary>
 	/// <param name="_x"> The x position. </param>
@@ -70,8 +99,7 @@ private:
 	/// <returns> <c>true</c> if the given position is in range; otherwise, <c>false</c>. </returns>
 	inline bool inBounds(const uint16_t _x, const uint16_t _y) const { return _x >= 0 && _y >= 0 && _x < m_width && _y < m_height; }
 
-	void sampleVertical(const uint8_t _threadNumber, const uint8_t _threadCount, const uint8_t _level, Buffer& o_buffer);
+	void sampleTile(const Rendering::Tile& _tile, const uint8_t _level, Buffer& o_buffer) const;
 
-	Colour GetAverage(uint16_t, uint16_t, uint8_t) const;
 };
 #endif
\ No newline at end of file
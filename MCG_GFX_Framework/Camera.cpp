@@ -28,78 +28,156 @@ Ray Rendering::Camera::CreateRay(const glm::vec2 _pixelPosition) const
 	return Ray(glm::vec3(start), glm::normalize(glm::vec3(end - start)));
 }
 
-/// <summary> Calculates the final colour found at the end of the ray. </summary>
+/// <summary> Calculates the final radiance found at the end of the ray. </summary>
 /// <param name="_ray"> The ray. </param>
 /// <param name="_spheres"> The spheres within the world. </param>
+/// <param name="_hierarchy"> The hierarchy built over the spheres. </param>
 /// <param name="_lightSource"> The world's light source. </param>
-/// <param name="_remainingReflections"> The amount of reflections to do, reduced every time a reflection is made. Defaults to <c>5</c>. </param>
-/// <returns> The colour at the end of the ray. </returns>
-Colour Rendering::Camera::TraceRay(const Ray _ray, const std::vector<Shapes::Sphere> _spheres, const PointLight _lightSource, const uint8_t _remainingReflections) const
+/// <param name="io_occluderCache"> The last sphere to block a shadow ray on this thread, which is tried first for every shadow ray. </param>
+/// <param name="_termination"> When the path stops reflecting. Defaults to <see cref="PathTermination::DefaultReflectionLimit"/> reflections, never ending early. </param>
+/// <param name="o_sphereIndex"> If given, set to the index of the sphere first hit by the ray, or <c>UINT32_MAX</c> if there is none. </param>
+/// <param name="io_rayStats"> If given, the ray is counted here as a primary ray, along with every shadow and reflection ray it leads to. </param>
+/// <param name="o_bounceCount"> If given, set to the number of reflections made. </param>
+/// <returns> The radiance at the end of the ray. </returns>
+glm::vec3 Rendering::Camera::TraceRay(const Ray& _ray, const Shapes::SphereSet& _spheres, const Shapes::BoundingVolumeHierarchy& _hierarchy, const PointLight& _lightSource, Shapes::OccluderCache& io_occluderCache, const PathTermination& _termination, uint32_t* o_sphereIndex, Telemetry::RayStats* io_rayStats, uint32_t* o_bounceCount) const
 {
-	// Store a sphere intersection, as well as the sphere it pertains to.
-	SphereIntersection sphereIntersect = SphereIntersection::Empty();
-	Shapes::Sphere intersectedSphere = Shapes::Sphere();
+	if (io_rayStats != nullptr) { io_rayStats->m_rays[(size_t)Telemetry::RayType::Primary]++; }
 
-	// Keep track of the shortest distance, initialise to a very large number.
-	float_t shortestDistance = INT32_MAX;
+	// Find the closest sphere hit by the ray, then follow the path from there.
+	Shapes::SphereHit closestHit;
+	_hierarchy.IntersectClosest(_spheres, _ray, closestHit, UINT32_MAX, (io_rayStats != nullptr) ? &io_rayStats->m_sphereTests : nullptr);
+	return tracePath(_ray, closestHit, _spheres, _hierarchy, _lightSource, io_occluderCache, _termination, o_sphereIndex, o_bounceCount, io_rayStats);
+}
 
-	// Iterate through the spheres to find the closest one hit by the ray.
-	for (uint16_t sphereIndex = 0; sphereIndex < _spheres.size(); sphereIndex++)
+/// <summary> Follows the path of a ray from its closest hit, bouncing from one reflective surface to the next until it ends. </summary>
+/// <param name="_ray"> The ray, which has already been counted. </param>
+/// <param name="_closestHit"> The closest sphere hit by the ray, which has no index if it hit nothing. </param>
+/// <param name="_spheres"> The spheres within the world. </param>
+/// <param name="_hierarchy"> The hierarchy built over the spheres. </param>
+/// <param name="_lightSource"> The world's light source. </param>
+/// <param name="io_occluderCache"> The last sphere to block a shadow ray on this thread. </param>
+/// <param name="_termination"> When the path stops reflecting. </param>
+/// <param name="o_sphereIndex"> If given, set to the index of the sphere first hit, or <c>UINT32_MAX</c> if there is none. </param>
+/// <param name="o_bounceCount"> If given, set to the number of reflections made. </param>
+/// <param name="io_rayStats"> If given, the hit or miss of this ray is counted here, along with every ray it leads to. </param>
+/// <returns> The radiance at the end of the path. </returns>
+/// <remarks>
+/// Each hit adds its shade scaled by the throughput, the product of the reflectiveness of every surface before it, and a reflective hit keeps only its inverse reflectiveness of its own shade.
+/// The radiance is summed in full precision and never converted to a colour here, and a reflection that would be thrown away at the limit is never traced.
+/// A reflection dropped because of the path's low throughput adds nothing, so that the roulette stays unbiased.
+/// </remarks>
+glm::vec3 Rendering::Camera::tracePath(const Ray& _ray, const Shapes::SphereHit& _closestHit, const Shapes::SphereSet& _spheres, const Shapes::BoundingVolumeHierarchy& _hierarchy, const PointLight& _lightSource, Shapes::OccluderCache& io_occluderCache, const PathTermination& _termination, uint32_t* o_sphereIndex, uint32_t* o_bounceCount, Telemetry::RayStats* io_rayStats) const
+{
+	if (o_sphereIndex != nullptr) { *o_sphereIndex = _closestHit.m_index; }
+	uint64_t* testCount = (io_rayStats != nullptr) ? &io_rayStats->m_sphereTests : nullptr;
+
+	Ray currentRay = _ray;
+	Shapes::SphereHit closestHit = _closestHit;
+	glm::vec3 radiance(0.0f);
+	float_t throughput = 1.0f;
+	uint32_t bounceCount = 0;
+	while (true)
 	{
-		// Test the ray against this sphere.
-		SphereIntersection currentSphereIntersect = _spheres[sphereIndex].RayIntersects(_ray);
+		bool didHit = closestHit.m_index != UINT32_MAX;
+		if (io_rayStats != nullptr) { if (didHit) { io_rayStats->m_hits++; } else { io_rayStats->m_misses++; } }
 
-		// If the ray hit and the distance is shorter than the current shortest distance.
-		if (currentSphereIntersect.m_didHit && currentSphereIntersect.m_distance < shortestDistance)
-		{
-			// Set the shortest distance to this distance.
-			shortestDistance = currentSphereIntersect.m_distance;
+		// If the ray hit nothing, the path ends with the background.
+		if (!didHit) { radiance += GetBackgroundRadiance() * throughput; break; }
 
-			// Set the sphere data.
-			sphereIntersect = currentSphereIntersect;
-			intersectedSphere = _spheres[sphereIndex];
-		}
-	}
-
-	// If the ray hit nothing, return the background colour.
-	if (!sphereIntersect.m_didHit) { return Colour(0, 0, 64); }
-
-	// Otherwise, work out what should happen with the resulting hit.
-	else
-	{
-		// Get the normal of the intersection on the sphere.
-		glm::vec3 intersectionNormal = glm::normalize(sphereIntersect.m_firstIntersection - intersectedSphere.m_centre);
+		// Get the hit sphere, the point where the ray intersects it, and the normal there.
+		Shapes::Sphere intersectedSphere = _spheres.GetSphere(closestHit.m_index);
+		glm::vec3 intersection = currentRay.m_origin + closestHit.m_distance * currentRay.m_direction;
+		glm::vec3 intersectionNormal = glm::normalize(intersection - intersectedSphere.m_centre);
 
 		// Create a ray starting from the intersection point and travelling towards the light source.
-		Ray shadowRay(sphereIntersect.m_firstIntersection, glm::normalize(_lightSource.m_position - sphereIntersect.m_firstIntersection));
+		glm::vec3 toLight = _lightSource.m_position - intersection;
+		float_t lightDistance = glm::length(toLight);
+		Ray shadowRay(intersection, toLight / lightDistance);
 
-		// Check the shadow ray against every sphere, if any are hit, return black.
-		for (uint16_t sphereIndex = 0; sphereIndex < _spheres.size(); sphereIndex++)
+		// Check the shadow ray against every other sphere between the point and the light, if any are hit, the path ends in black.
+		bool isShadowed = _hierarchy.IntersectAny(_spheres, shadowRay, lightDistance, io_occluderCache, closestHit.m_index, testCount);
+		if (io_rayStats != nullptr)
 		{
-			if (_spheres[sphereIndex].m_centre != intersectedSphere.m_centre && _spheres[sphereIndex].RayIntersects(shadowRay).m_didHit) { return Colour::Black(); }
+			io_rayStats->m_rays[(size_t)Telemetry::RayType::Shadow]++;
+			if (isShadowed) { io_rayStats->m_hits++; } else { io_rayStats->m_misses++; }
 		}
+		if (isShadowed) { break; }
+
+		// Shade the hit once, whether or not it reflects.
+		glm::vec3 shade = intersectedSphere.Shade(intersection, intersectionNormal, _lightSource);
+		float_t reflectiveness = intersectedSphere.m_properties.m_reflectiveness;
 
-		// If the hit sphere is reflective, get the colour from the reflection.
-		if (intersectedSphere.m_properties.m_reflectiveness > 0.0f)
+		// If the surface is reflective and the limit has not been reached, keep the inverse reflectiveness of the shade and follow the reflection if the path survives it.
+		if (reflectiveness > 0.0f && bounceCount < _termination.m_reflectionLimit)
 		{
-			// Calculate the direction of the reflection.
-			glm::vec3 reflectionNormal = 2.0f * glm::dot(-_ray.m_direction, intersectionNormal) * intersectionNormal + _ray.m_direction;
+			radiance += shade * (throughput * (1.0f - reflectiveness));
+
+			// Reflect the direction about the normal.
+			glm::vec3 reflectionNormal = 2.0f * glm::dot(-currentRay.m_direction, intersectionNormal) * intersectionNormal + currentRay.m_direction;
+			throughput *= reflectiveness;
+			if (!_termination.Survives(throughput, reflectionNormal, bounceCount)) { if (io_rayStats != nullptr) { io_rayStats->m_terminations++; } break; }
+
+			// Find what the reflection hits.
+			currentRay = Ray(intersection, reflectionNormal);
+			if (io_rayStats != nullptr) { io_rayStats->m_rays[(size_t)Telemetry::RayType::Reflection]++; }
+			closestHit = Shapes::SphereHit();
+			_hierarchy.IntersectClosest(_spheres, currentRay, closestHit, UINT32_MAX, testCount);
+			bounceCount++;
+			continue;
+		}
 
-			// Create a ray starting from the intersection point and travelling directly away from the sphere.
-			Ray reflectionRay(sphereIntersect.m_firstIntersection, reflectionNormal);
+		// Otherwise, the path ends with the full shade, counting a reflection that was cut off by the limit.
+		if (reflectiveness > 0.0f && io_rayStats != nullptr) { io_rayStats->m_cutoffs++; }
+		radiance += shade * throughput;
+		break;
+	}
 
-			// Get the current colour of the hit sphere, with its inverse reflectiveness applied.
-			Colour currentColour = intersectedSphere.Shade(sphereIntersect.m_firstIntersection, intersectionNormal, _lightSource) * (1.0f - intersectedSphere.m_properties.m_reflectiveness);
+	if (io_rayStats != nullptr) { io_rayStats->AddDepth(bounceCount); }
+	if (o_bounceCount != nullptr) { *o_bounceCount = bounceCount; }
+	return radiance;
+}
 
-			// Get the colour of the reflected ray, with the reflectiveness of the hit sphere applied.
-			Colour reflectedColour = TraceRay(reflectionRay, _spheres, _lightSource, _remainingReflections - 1) * intersectedSphere.m_properties.m_reflectiveness;
+/// <summary> Creates a packet of rays from a block of neighbouring pixels, laid out row by row. </summary>
+/// <param name="_firstPixel"> The pixel position of the top left of the block. </param>
+/// <param name="_packetSize"> The number of rays, either <c>4</c>, <c>8</c>, or <c>16</c>, which are two, four, and four pixels wide. </param>
+/// <param name="_activeMask"> A bit for each ray whose result is wanted, such as those still within the tile. </param>
+/// <param name="o_packet"> The packet to fill, with every hit cleared. </param>
+void Rendering::Camera::CreatePacket(const glm::vec2 _firstPixel, const uint8_t _packetSize, const uint32_t _activeMask, RayPacket& o_packet) const
+{
+	uint32_t packetWidth = GetPacketWidth(_packetSize);
+	o_packet.m_size = _packetSize;
+	o_packet.m_activeMask = _activeMask;
+	for (uint32_t lane = 0; lane < _packetSize; lane++) { o_packet.SetRay(lane, CreateRay(_firstPixel + glm::vec2(lane % packetWidth, lane / packetWidth))); }
+}
 
-			// If there are reflections remaining, trace the ray recursively and combine the colours based off the hit sphere's reflectiveness.
-			if (_remainingReflections > 0) { return reflectedColour + currentColour; }
-		}
+/// <summary> Traces a packet of primary rays together through the hierarchy, then shades each active ray on its own. </summary>
+/// <param name="io_packet"> The rays, which are given their closest hits. </param>
+/// <param name="_spheres"> The spheres within the world. </param>
+/// <param name="_hierarchy"> The hierarchy built over the spheres. </param>
+/// <param name="_lightSource"> The world's light source. </param>
+/// <param name="io_occluderCache"> The last sphere to block a shadow ray on this thread. </param>
+/// <param name="_termination"> When each path stops reflecting. </param>
+/// <param name="o_radiance"> The radiance at the end of each active ray, indexed by lane. </param>
+/// <param name="o_sphereIndices"> If given, set to the index of the sphere first hit by each active ray, or <c>UINT32_MAX</c> if there is none. </param>
+/// <param name="io_rayStats"> If given, each active ray is counted here as a primary ray, along with every shadow and reflection ray it leads to. </param>
+/// <remarks> If the rays diverge too far to bound together, each is traced through the hierarchy on its own instead. A traced packet can, very rarely, find a grazing hit on a tiny sphere that a lone ray would miss, as described by <see cref="Shapes::BoundingVolumeHierarchy::IntersectPacket"/>. </remarks>
+void Rendering::Camera::TracePacket(RayPacket& io_packet, const Shapes::SphereSet& _spheres, const Shapes::BoundingVolumeHierarchy& _hierarchy, const PointLight& _lightSource, Shapes::OccluderCache& io_occluderCache, const PathTermination& _termination, glm::vec3* o_radiance, uint32_t* o_sphereIndices, Telemetry::RayStats* io_rayStats) const
+{
+	// Trace the whole packet at once if it is coherent, otherwise fall back to tracing each active ray alone.
+	uint64_t* testCount = (io_rayStats != nullptr) ? &io_rayStats->m_sphereTests : nullptr;
+	bool isPacket = _hierarchy.IntersectPacket(_spheres, io_packet, testCount);
+	for (uint32_t lane = 0; lane < io_packet.m_size; lane++)
+	{
+		if (!io_packet.IsActive(lane)) { continue; }
+		Ray ray = io_packet.GetRay(lane);
+
+		Shapes::SphereHit closestHit;
+		if (isPacket) { closestHit.m_index = io_packet.m_index[lane]; closestHit.m_distance = io_packet.m_distance[lane]; }
+		else { _hierarchy.IntersectClosest(_spheres, ray, closestHit, UINT32_MAX, testCount); }
 
-		// Return the basic shade.
-		return intersectedSphere.Shade(sphereIntersect.m_firstIntersection, intersectionNormal, _lightSource);
+		// Follow the path from the hit exactly as a single ray would.
+		if (io_rayStats != nullptr) { io_rayStats->m_rays[(size_t)Telemetry::RayType::Primary]++; if (isPacket) { io_rayStats->m_packetRays++; } }
+		o_radiance[lane] = tracePath(ray, closestHit, _spheres, _hierarchy, _lightSource, io_occluderCache, _termination, (o_sphereIndices != nullptr) ? &o_sphereIndices[lane] : nullptr, nullptr, io_rayStats);
 	}
 }
 
@@ -107,18 +185,19 @@ Colour Rendering::Camera::TraceRay(const Ray _ray, const std::vector<Shapes::Sph
 /// <param name="_viewportSize"> The size of the viewport in pixels </param>
 /// <param name="_position"> The position of the camera within the world. </param>
 /// <param name="_lookAt"> The world position at which to look. </param>
+/// <param name="_fieldOfView"> The vertical field of view in degrees. Defaults to <c>45</c>. </param>
 /// <returns> The complete camera. </returns>
-Rendering::Camera& Rendering::Camera::FromLookAt(const glm::vec2 _viewportSize, const glm::vec3 _position, const glm::vec3 _lookAt)
+Rendering::Camera& Rendering::Camera::FromLookAt(const glm::vec2 _viewportSize, const glm::vec3 _position, const glm::vec3 _lookAt, const float_t _fieldOfView)
 {
 	// Create a basic camera with just the width and height set.
 	Camera* camera = new Camera(_viewportSize);
 
-	// Initilise the projection matrix to a standard fov.
-	camera->m_projection = glm::perspective<float_t>(glm::radians(45.0f), _viewportSize.x / _viewportSize.y, 0.1f, 1000.0f);
+	// Initilise the projection matrix to the given fov.
+	camera->m_projection = glm::perspective<float_t>(glm::radians(_fieldOfView), _viewportSize.x / _viewportSize.y, 0.1f, 1000.0f);
 
-	// Initialise the view matrix.
-	camera->m_invertedView = glm::lookAt(_position, _lookAt, glm::vec3(0, 1, 0));
-	camera->m_view = glm::inverse(camera->m_invertedView);
+	// Initialise the view matrix, which takes the world into the camera's space, and its inverse, which rays are cast through to take them back out into the world.
+	camera->m_view = glm::lookAt(_position, _lookAt, glm::vec3(0, 1, 0));
+	camera->m_invertedView = glm::inverse(camera->m_view);
 
 	// Save the inverted projection matrix.
 	camera->m_invertedProjection = glm::inverse(camera->m_projection);
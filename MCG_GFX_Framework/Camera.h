@@ -6,9 +6,16 @@
 
 // Data includes.
 #include "Ray.h"
+#include "RayPacket.h"
 #include "Colour.h"
 #include "Sphere.h"
+#include "SphereSet.h"
+#include "BoundingVolumeHierarchy.h"
 #include "PointLight.h"
+#include "RenderSettings.h"
+
+// Diagnostic includes.
+#include "Telemetry.h"
 
 // Utility includes.
 #include <vector>
@@ -32,16 +39,34 @@ namespace Rendering
 		/// <returns> The width of the viewport in pixels. </returns>
 		inline uint16_t GetHeight() const { return (uint16_t)m_viewportSize.y; }
 
-		Colour TraceRay(Ray, std::vector<Shapes::Sphere>, PointLight, const uint8_t _remainingReflections = 5) const;
+		glm::vec3 TraceRay(const Ray&, const Shapes::SphereSet&, const Shapes::BoundingVolumeHierarchy&, const PointLight&, Shapes::OccluderCache&, const PathTermination& _termination = PathTermination(), uint32_t* o_sphereIndex = nullptr, Telemetry::RayStats* io_rayStats = nullptr, uint32_t* o_bounceCount = nullptr) const;
 
 		/// <summary> Traces a ray from the given pixel position on the screen. </summary>
 		/// <param name="_pixelPosition"> The position on the screen in pixels. </param>
 		/// <param name="_spheres"> The spheres within the world. </param>
+		/// <param name="_hierarchy"> The hierarchy built over the spheres. </param>
 		/// <param name="_lightSource"> The world's light source. </param>
-		/// <returns> The colour at the end of the ray. </returns>
-		inline Colour TraceRay(const glm::vec2 _pixelPosition, const std::vector<Shapes::Sphere> _spheres, const PointLight _lightSource) const { return TraceRay(CreateRay(_pixelPosition), _spheres, _lightSource); }
+		/// <param name="io_occluderCache"> The last sphere to block a shadow ray on this thread. </param>
+		/// <param name="_termination"> When the path stops reflecting. </param>
+		/// <param name="o_sphereIndex"> If given, set to the index of the sphere seen at the pixel, or <c>UINT32_MAX</c> if there is none. </param>
+		/// <param name="io_rayStats"> If given, every ray traced is counted here. </param>
+		/// <returns> The radiance at the end of the ray. </returns>
+		inline glm::vec3 TraceRay(const glm::vec2 _pixelPosition, const Shapes::SphereSet& _spheres, const Shapes::BoundingVolumeHierarchy& _hierarchy, const PointLight& _lightSource, Shapes::OccluderCache& io_occluderCache, const PathTermination& _termination = PathTermination(), uint32_t* o_sphereIndex = nullptr, Telemetry::RayStats* io_rayStats = nullptr) const { return TraceRay(CreateRay(_pixelPosition), _spheres, _hierarchy, _lightSource, io_occluderCache, _termination, o_sphereIndex, io_rayStats); }
+
+		void CreatePacket(glm::vec2, uint8_t, uint32_t, RayPacket&) const;
+
+		void TracePacket(RayPacket&, const Shapes::SphereSet&, const Shapes::BoundingVolumeHierarchy&, const PointLight&, Shapes::OccluderCache&, const PathTermination&, glm::vec3*, uint32_t* o_sphereIndices = nullptr, Telemetry::RayStats* io_rayStats = nullptr) const;
 
-		static Camera& FromLookAt(glm::vec2, glm::vec3, glm::vec3);
+		/// <summary> Gets the width in pixels of the block of pixels covered by a packet of the given size. </summary>
+		/// <param name="_packetSize"> The number of rays in the packet. </param>
+		/// <returns> Two for a packet of four, otherwise four. </returns>
+		static inline uint32_t GetPacketWidth(const uint8_t _packetSize) { return (_packetSize <= 4) ? 2 : 4; }
+
+		/// <summary> Gets the radiance seen by a ray that hits nothing. </summary>
+		/// <returns> A dark blue. </returns>
+		static inline glm::vec3 GetBackgroundRadiance() { return Colour(0, 0, 64).ToScalar(); }
+
+		static Camera& FromLookAt(glm::vec2, glm::vec3, glm::vec3, float_t _fieldOfView = 45.0f);
 	private:
 		/// <summary> The private constructor to create a basic camera with just the width and height. </summary>
 		/// <param name="_viewportSize"> The size of the viewport in pixels. </param>
@@ -61,6 +86,8 @@ namespace Rendering
 
 		/// <summary> The inverted view matrix. </summary>
 		glm::mat4 m_invertedView;
+
+		glm::vec3 tracePath(const Ray&, const Shapes::SphereHit&, const Shapes::SphereSet&, const Shapes::BoundingVolumeHierarchy&, const PointLight&, Shapes::OccluderCache&, const PathTermination&, uint32_t*, uint32_t*, Telemetry::RayStats*) const;
 	};
 }
 #endif
\ No newline at end of file
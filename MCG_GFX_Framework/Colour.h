@@ -8,7 +8,18 @@
 #include <stdint.h>
 #include <cmath>
 
-/// <summary> Represents a 24-bit colour. </summary>
+/// <summary> The ways in which radiance is brought into the range of a colour. </summary>
+enum class ToneMapping : uint8_t
+{
+	/// <summary> Each channel is cut off at full brightness, so anything brighter is lost. </summary>
+	Clamp,
+
+	/// <summary> Each channel is divided by one more than itself, which keeps the detail in bright areas at the cost of darkening the rest. </summary>
+	Reinhard
+};
+
+/// <summary> Represents a 24-bit colour, as written to the screen or an image. </summary>
+/// <remarks> Rendering works in floating point radiance, which is only converted to a colour once the pixel is finished. </remarks>
 struct Colour
 {
 	/// <summary> Creates a black colour. </summary>
@@ -31,36 +42,27 @@ struct Colour
 
 	/// <summary> Calculates and returns this colour as a vector 3 where each value is between <c>0</c> and <c>1</c>. </summary>
 	/// <returns> The calculated scalar vector. </returns>
-	inline glm::vec3 ToScalar() const { return glm::vec3(r / (float_t)CHAR_MAX, g / (float_t)CHAR_MAX, b / (float_t)CHAR_MAX); }
+	inline glm::vec3 ToScalar() const { return glm::vec3(r, g, b) * (1.0f / UINT8_MAX); }
 
-	/// <summary> Blends these colours together using multiplication. </summary>
-	/// <param name="_other"> The other colour with which to blend. </param>
-	/// <returns> The blended colour. </returns>
-	inline Colour operator*(const Colour& _other) const { return FromScalar(ToScalar() * _other.ToScalar()); }
-
-	/// <summary> Blends this colour with the given scalar value using multiplication. </summary>
-	/// <param name="_scalar"> The scalar with which to multiply. </param>
-	/// <returns> The blended colour. </returns>
-	inline Colour operator*(const float_t& _scalar) const { return FromScalar(ToScalar() * _scalar); }
-
-	/// <summary> Blends these colours together using addition. </summary>
-	/// <param name="_other"> The other colour with which to blend. </param>
-	/// <returns> The blended colour. </returns>
-	inline Colour operator+(const Colour& _other) const { return FromScalar(ToScalar() + _other.ToScalar()); }
-
-	/// <summary> Blends this colour with the given scalar value using addition. </summary>
-	/// <param name="_scalar"> The scalar with which to add. </param>
-	/// <returns> The blended colour. </returns>
-	inline Colour operator+(const float_t& _scalar) const { return FromScalar(ToScalar() + _scalar); }
+	/// <summary> Compares these colours. </summary>
+	/// <param name="_other"> The other colour with which to compare. </param>
+	/// <returns> <c>true</c> if every value is the same; otherwise, <c>false</c>. </returns>
+	inline bool operator==(const Colour& _other) const { return r == _other.r && g == _other.g && b == _other.b; }
 
 	/// <summary> Implicitly converts this colour into a vector3. </summary>
 	/// <returns> The converted colour. </returns>
 	inline operator glm::ivec3() const { return glm::ivec3(r, g, b); }
 
-	/// <summary> Creates a colour from the given scalar vector. </summary>
-	/// <param name="_scalar"> The vector whose values are all between <c>0</c> and <c>1</c>. </param>
+	/// <summary> Creates a colour from the given scalar vector, rounding each value to the nearest step. </summary>
+	/// <param name="_scalar"> The vector whose values are between <c>0</c> and <c>1</c>, any outside are clamped. </param>
 	/// <returns> The parsed colour. </returns>
-	inline static Colour FromScalar(const glm::vec3 _scalar) { return Colour(glm::min((float_t)CHAR_MAX, ceil(_scalar.x * CHAR_MAX)), glm::min((float_t)CHAR_MAX, ceil(_scalar.y * CHAR_MAX)), glm::min((float_t)CHAR_MAX, ceil(_scalar.z * CHAR_MAX))); }
+	inline static Colour FromScalar(const glm::vec3 _scalar) { glm::vec3 steps = glm::clamp(_scalar, 0.0f, 1.0f) * (float_t)UINT8_MAX + 0.5f; return Colour((uint8_t)steps.x, (uint8_t)steps.y, (uint8_t)steps.z); }
+
+	/// <summary> Creates a colour from the given radiance, which is the only point at which a rendered colour loses precision. </summary>
+	/// <param name="_radiance"> The red, green, and blue radiance, where <c>1</c> is full brightness but brighter values are allowed. </param>
+	/// <param name="_toneMapping"> How radiance brighter than <c>1</c> is brought into range. Defaults to clamping. </param>
+	/// <returns> The quantised colour. </returns>
+	inline static Colour FromRadiance(const glm::vec3 _radiance, const ToneMapping _toneMapping = ToneMapping::Clamp) { return FromScalar((_toneMapping == ToneMapping::Reinhard) ? _radiance / (1.0f + _radiance) : _radiance); }
 
 	/// <summary> Black. </summary>
 	/// <returns> r0 b0 g0. </returns>
@@ -0,0 +1,85 @@
+#include "CostMap.h"
+
+// Utility includes.
+#include <algorithm>
+#include <cmath>
+
+/// <summary> Creates a map of the given size with every cost at zero. </summary>
+/// <param name="_width"> The width in pixels, which should match the camera. </param>
+/// <param name="_height"> The height in pixels, which should match the camera. </param>
+Telemetry::CostMap::CostMap(const uint16_t _width, const uint16_t _height) : m_width(_width), m_height(_height)
+{
+	for (std::vector<uint32_t>& costs : m_costs) { costs.assign((size_t)_width * _height, 0); }
+}
+
+/// <summary> Sets every cost back to zero, ready for the next frame. </summary>
+void Telemetry::CostMap::Clear()
+{
+	for (std::vector<uint32_t>& costs : m_costs) { std::fill(costs.begin(), costs.end(), 0); }
+}
+
+/// <summary> Finds the most costly pixel by the given metric. </summary>
+/// <param name="_metric"> The measure of cost. </param>
+/// <returns> The highest cost of any pixel, or <c>0</c> if the map is empty. </returns>
+uint32_t Telemetry::CostMap::GetMaximum(const CostMetric _metric) const
+{
+	const std::vector<uint32_t>& costs = m_costs[(size_t)_metric];
+	return costs.empty() ? 0 : *std::max_element(costs.begin(), costs.end());
+}
+
+/// <summary> Adds up the cost of every pixel by the given metric. </summary>
+/// <param name="_metric"> The measure of cost. </param>
+/// <returns> The total cost of the frame. </returns>
+uint64_t Telemetry::CostMap::GetTotal(const CostMetric _metric) const
+{
+	uint64_t total = 0;
+	for (uint32_t cost : m_costs[(size_t)_metric]) { total += cost; }
+	return total;
+}
+
+/// <summary> Creates and returns a false colour image of the given cost, running from black for the cheapest pixels through blue, red, and yellow to white for the most costly. </summary>
+/// <param name="_metric"> The measure of cost. </param>
+/// <returns> The image, the same size as the map. </returns>
+/// <remarks> Costs are scaled logarithmically against the highest, as a handful of deep reflections would otherwise leave the rest of the image black. </remarks>
+Buffer& Telemetry::CostMap::CreateImage(const CostMetric _metric) const
+{
+	Buffer* image = new Buffer(m_width, m_height);
+	const std::vector<uint32_t>& costs = m_costs[(size_t)_metric];
+	float_t logMaximum = std::log1p((float_t)GetMaximum(_metric));
+
+	for (uint16_t y = 0; y < m_height; y++)
+	{
+		for (uint16_t x = 0; x < m_width; x++) { image->SetPixel(x, y, heat((logMaximum > 0) ? std::log1p((float_t)costs[(size_t)y * m_width + x]) / logMaximum : 0).ToScalar()); }
+	}
+
+	return *image;
+}
+
+/// <summary> Maps the given heat to a colour, blending between black, blue, red, yellow, and white. </summary>
+/// <param name="_heat"> The heat between <c>0</c> and <c>1</c>. </param>
+/// <returns> The colour of the heat. </returns>
+Colour Telemetry::CostMap::heat(const float_t _heat)
+{
+	static const glm::vec3 stops[] = { glm::vec3(0, 0, 0), glm::vec3(0, 0, 255), glm::vec3(255, 0, 0), glm::vec3(255, 255, 0), glm::vec3(255, 255, 255) };
+	const size_t lastStop = sizeof(stops) / sizeof(stops[0]) - 1;
+
+	// Find the two stops either side of the heat and blend between them.
+	float_t position = glm::clamp(_heat, 0.0f, 1.0f) * lastStop;
+	size_t stop = std::min((size_t)position, lastStop - 1);
+	glm::vec3 colour = glm::mix(stops[stop], stops[stop + 1], position - stop);
+	return Colour((uint8_t)colour.r, (uint8_t)colour.g, (uint8_t)colour.b);
+}
+
+/// <summary> Gets the name of the given metric, as used in file names. </summary>
+/// <param name="_metric"> The metric. </param>
+/// <returns> The name in lower case. </returns>
+const char* Telemetry::GetName(const CostMetric _metric)
+{
+	switch (_metric)
+	{
+	case CostMetric::Time: return "time";
+	case CostMetric::SphereTests: return "sphere_tests";
+	case CostMetric::Rays: return "rays";
+	default: return "unknown";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef COSTMAP_H
+#define COSTMAP_H
+
+// Data includes.
+#include "Buffer.h"
+
+// Diagnostic includes.
+#include "Telemetry.h"
+
+// Utility includes.
+#include <chrono>
+#include <vector>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Telemetry
+{
+	/// <summary> The measures of how much a pixel cost to draw. </summary>
+	enum class CostMetric : uint8_t
+	{
+		/// <summary> The time spent tracing the pixel, in nanoseconds. </summary>
+		Time,
+
+		/// <summary> The number of spheres tested against the pixel's rays. </summary>
+		SphereTests,
+
+		/// <summary> The number of rays of any type traced for the pixel. </summary>
+		Rays,
+
+		/// <summary> The number of metrics. </summary>
+		Count
+	};
+
+	/// <summary> Represents the cost of drawing each pixel of a frame, which can be turned into a false colour image to see where the time goes. </summary>
+	/// <remarks> Each pixel is only ever written by the thread drawing its tile, so no locking is needed. </remarks>
+	class CostMap
+	{
+	public:
+		CostMap(uint16_t, uint16_t);
+
+		/// <summary> Gets the width of the map. </summary>
+		/// <returns> The width in pixels. </returns>
+		inline uint16_t GetWidth() const { return m_width; }
+
+		/// <summary> Gets the height of the map. </summary>
+		/// <returns> The height in pixels. </returns>
+		inline uint16_t GetHeight() const { return m_height; }
+
+		/// <summary> Adds the given cost to the given pixel, such as when it is refined after its first sample. </summary>
+		/// <param name="_x"> The x position of the pixel. </param>
+		/// <param name="_y"> The y position of the pixel. </param>
+		/// <param name="_duration"> The time spent tracing the pixel. </param>
+		/// <param name="_rayStats"> The rays traced for the pixel alone. </param>
+		inline void Add(const uint16_t _x, const uint16_t _y, const std::chrono::steady_clock::duration _duration, const RayStats& _rayStats)
+		{
+			size_t index = (size_t)_y * m_width + _x;
+			m_costs[(size_t)CostMetric::Time][index] += (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(_duration).count();
+			m_costs[(size_t)CostMetric::SphereTests][index] += (uint32_t)_rayStats.m_sphereTests;
+			m_costs[(size_t)CostMetric::Rays][index] += (uint32_t)_rayStats.GetTotal();
+		}
+
+		/// <summary> Gets the given cost of the given pixel. </summary>
+		/// <param name="_metric"> The measure of cost. </param>
+		/// <param name="_x"> The x position of the pixel. </param>
+		/// <param name="_y"> The y position of the pixel. </param>
+		/// <returns> The cost of the pixel. </returns>
+		inline uint32_t GetCost(const CostMetric _metric, const uint16_t _x, const uint16_t _y) const { return m_costs[(size_t)_metric][(size_t)_y * m_width + _x]; }
+
+		void Clear();
+
+		uint32_t GetMaximum(CostMetric) const;
+
+		uint64_t GetTotal(CostMetric) const;
+
+		Buffer& CreateImage(CostMetric) const;
+	private:
+		/// <summary> The width of the map in pixels. </summary>
+		uint16_t m_width;
+
+		/// <summary> The height of the map in pixels. </summary>
+		uint16_t m_height;
+
+		/// <summary> The cost of every pixel row by row, indexed by metric. </summary>
+		std::vector<uint32_t> m_costs[(size_t)CostMetric::Count];
+
+		static Colour heat(float_t);
+	};
+
+	const char* GetName(CostMetric);
+}
+#endif
\ No newline at end of file
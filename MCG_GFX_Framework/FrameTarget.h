@@ -0,0 +1,70 @@
+#ifndef FRAMETARGET_H
+#define FRAMETARGET_H
+
+// Data includes.
+#include "Colour.h"
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Rendering
+{
+	/// <summary> Represents memory outside of any buffer into which finished pixels are written, such as a locked streaming texture. </summary>
+	/// <remarks> Pixels are packed into 32 bits with each channel at its own shift, so the memory can be in the display's native format and need no conversion once written. </remarks>
+	struct FrameTarget
+	{
+		/// <summary> Creates a target over the given memory. </summary>
+		/// <param name="_pixels"> The first pixel of the first row. </param>
+		/// <param name="_pitch"> The distance between the start of each row in bytes. </param>
+		/// <param name="_width"> The width in pixels. </param>
+		/// <param name="_height"> The height in pixels. </param>
+		/// <param name="_redShift"> The bit at which the red channel starts. </param>
+		/// <param name="_greenShift"> The bit at which the green channel starts. </param>
+		/// <param name="_blueShift"> The bit at which the blue channel starts. </param>
+		/// <param name="_alphaMask"> The bits of the alpha channel, which are always set, or <c>0</c> if there is no alpha. </param>
+		FrameTarget(uint8_t* _pixels, const uint32_t _pitch, const uint16_t _width, const uint16_t _height, const uint8_t _redShift, const uint8_t _greenShift, const uint8_t _blueShift, const uint32_t _alphaMask)
+			: m_pixels(_pixels), m_pitch(_pitch), m_width(_width), m_height(_height), m_redShift(_redShift), m_greenShift(_greenShift), m_blueShift(_blueShift), m_alphaMask(_alphaMask) { }
+
+		/// <summary> Packs and writes the given colour to the given pixel position, does nothing if the given position is out of range. </summary>
+		/// <param name="_x"> The x position of the pixel. </param>
+		/// <param name="_y"> The y position of the pixel. </param>
+		/// <param name="_colour"> The colour to which the pixel is set. </param>
+		inline void SetPixel(const uint16_t _x, const uint16_t _y, const Colour _colour)
+		{
+			if (_x < m_width && _y < m_height) { ((uint32_t*)(m_pixels + _y * m_pitch))[_x] = ((uint32_t)_colour.r << m_redShift) | ((uint32_t)_colour.g << m_greenShift) | ((uint32_t)_colour.b << m_blueShift) | m_alphaMask; }
+		}
+
+		/// <summary> Gets the width of the target. </summary>
+		/// <returns> The width of the target in pixels. </returns>
+		inline uint16_t GetWidth() const { return m_width; }
+
+		/// <summary> Gets the height of the target. </summary>
+		/// <returns> The height of the target in pixels. </returns>
+		inline uint16_t GetHeight() const { return m_height; }
+	private:
+		/// <summary> The first pixel of the first row. </summary>
+		uint8_t* m_pixels;
+
+		/// <summary> The distance between the start of each row in bytes. </summary>
+		uint32_t m_pitch;
+
+		/// <summary> The width in pixels. </summary>
+		uint16_t m_width;
+
+		/// <summary> The height in pixels. </summary>
+		uint16_t m_height;
+
+		/// <summary> The bit at which the red channel starts. </summary>
+		uint8_t m_redShift;
+
+		/// <summary> The bit at which the green channel starts. </summary>
+		uint8_t m_greenShift;
+
+		/// <summary> The bit at which the blue channel starts. </summary>
+		uint8_t m_blueShift;
+
+		/// <summary> The bits of the alpha channel, which are always set. </summary>
+		uint32_t m_alphaMask;
+	};
+}
+#endif
\ No newline at end of file
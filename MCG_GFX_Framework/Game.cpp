@@ -9,83 +9,108 @@
 // SDL includes.
 #include <SDL.h>
 
-// Utility includes.
-#include <chrono>
+// Diagnostic includes.
+#include "Telemetry.h"
+#include "Timeline.h"
 #include <iostream>
 
-/// <summary> Draws the world and super samples it. </summary>
-void Game::draw()
+namespace
 {
-	// Create a buffer for the full res and a buffer for the sampled res, then a buffer that simply points to the buffer that needs to be drawn.
-	Buffer* superSampledBuffer = NULL;
-	Buffer* fullResBuffer = NULL;
-	Buffer* drawBuffer = NULL;
+	/// <summary> Finds the lowest set bit of the given mask. </summary>
+	/// <param name="_mask"> The mask of a colour channel. </param>
+	/// <returns> The bit at which the channel starts. </returns>
+	uint8_t maskShift(uint32_t _mask)
+	{
+		uint8_t shift = 0;
+		while (_mask != 0 && (_mask & 1) == 0) { _mask >>= 1; shift++; }
+		return shift;
+	}
 
-	// Clear the screen.
-	MCG::SetBackground(glm::ivec3(0, 64, 0));
+	/// <summary> Finds if the given pixel format packs each channel into its own byte of a 32-bit pixel, so that it can be written without conversion. </summary>
+	/// <param name="_format"> The pixel format. </param>
+	/// <returns> <c>true</c> if the format can be written to by a frame target; otherwise, <c>false</c>. </returns>
+	bool isByteAligned32(const uint32_t _format)
+	{
+		int bitsPerPixel;
+		uint32_t redMask, greenMask, blueMask, alphaMask;
+		if (SDL_ISPIXELFORMAT_FOURCC(_format) || SDL_BYTESPERPIXEL(_format) != 4 || !SDL_PixelFormatEnumToMasks(_format, &bitsPerPixel, &redMask, &greenMask, &blueMask, &alphaMask)) { return false; }
+		return redMask == (0xFFu << maskShift(redMask)) && greenMask == (0xFFu << maskShift(greenMask)) && blueMask == (0xFFu << maskShift(blueMask));
+	}
+}
 
-	// Print to the console that rendering has started.
-	std::cout << "Rendering with " << (int)m_threads << " threads at " << (int)m_samples << "x resolution" << std::endl;
+/// <summary> Draws the world, tracing and averaging every sample of each pixel in a single pass, and records the frame's telemetry. </summary>
+void Game::draw()
+{
+	// Create the texture the first time it is needed, then lock it so the finished tiles can be written straight into it, skipping the frame if either fails.
+	if (m_texture == nullptr && !createTexture()) { std::cerr << "Could not create the frame texture: " << SDL_GetError() << std::endl; return; }
+	Rendering::FrameTarget target(nullptr, 0, 0, 0, 0, 0, 0, 0);
+	if (!lockTexture(target)) { std::cerr << "Could not lock the frame texture: " << SDL_GetError() << std::endl; return; }
 
-	// Start the main timer and ray timer from here.
-	std::chrono::time_point<std::chrono::steady_clock> mainTimer = std::chrono::high_resolution_clock::now();
-	std::chrono::time_point<std::chrono::steady_clock> rayTimer = std::chrono::high_resolution_clock::now();
+	// Start the frame's record.
+	Telemetry::Recorder& telemetry = Telemetry::Recorder::Get();
+	telemetry.BeginFrame();
 
-	// Draw the world at full res and save it to a buffer.
-	fullResBuffer = &m_world.Draw(m_threads);
+	// Clear the screen.
+	MCG::SetBackground(glm::ivec3(0, 64, 0));
 
-	// Print to the console that the raycasting has been finished.
-	double renderTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - rayTimer).count();;
-	std::cout << "Render completed in " << renderTime << "ms" << std::endl;
+	// Draw the world at the window's res and save it to a buffer, writing each tile to the texture as soon as it is finished.
+	Buffer& outputBuffer = m_world.Draw(m_settings, &target);
 
-	// If the sample rate is greater than 1, sample and draw, otherwise draw the full res.
-	if (m_samples > 1)
+	// Every pixel is already in the texture, so unlocking it is all that is left to upload.
 	{
-		// Print to the console that the sampling will now take place.
-		std::cout << "Super sampling at " << (int)m_samples << "x." << std::endl;
-
-		// Start the sampling timer.
-		std::chrono::time_point<std::chrono::steady_clock> sampleTimer = std::chrono::high_resolution_clock::now();
-
-		// Super sample the buffer and save it.
-		superSampledBuffer = &fullResBuffer->SuperSample(m_samples, m_threads);
-
-		// Set the sampled buffer to be drawn.
-		drawBuffer = superSampledBuffer;
-
-		// Print the time taken to sample.
-		double sampleTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - sampleTimer).count();;
-		std::cout << "Sampling completed in " << sampleTime << "ms" << std::endl;
+		Telemetry::ScopedTimer uploadTimer(Telemetry::Phase::Upload);
+		Telemetry::ScopedSpan uploadSpan("upload");
+		SDL_UnlockTexture(m_texture);
 	}
-	else { drawBuffer = fullResBuffer; }
 
-	// Print that the upload is starting.
-	std::cout << "Uploading texture data to GPU" << std::endl;
-
-	// Start the upload timer here.
-	std::chrono::time_point<std::chrono::steady_clock> uploadTimer = std::chrono::high_resolution_clock::now();
-
-	// Upload the data to the GPU.
-	SDL_Texture* texture = drawBuffer->CreateTexture(*MCG::GetRenderer());
+	// Draw the texture to the screen, which is left out of the upload time as it can wait on the display.
+	{
+		Telemetry::ScopedSpan presentSpan("present");
+		MCG::DrawTexture(m_texture);
+	}
 
-	// Draw the texture.
-	MCG::DrawTexture(texture);
+	// End the frame's record and timeline, which writes them out.
+	telemetry.EndFrame((uint16_t)m_windowSize.x, (uint16_t)m_windowSize.y, m_settings.GetThreadCount(), m_settings.m_sampleLevel);
+	Telemetry::Timeline::Get().EndFrame();
 
-	// Calculate the upload time and print it.
-	double uploadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - uploadTimer).count();;
-	std::cout << "Uploaded texture data in " << uploadTime << "ms" << std::endl;
+	// Now that it has been used, delete the output buffer.
+	delete &outputBuffer;
+}
 
-	// Get the time taken to render and output it to the console.
-	double mainTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - mainTimer).count();
-	std::cout << "Took " << mainTime << "ms to render with " << (int)m_threads << " threads at " << (int)m_samples << "x super-sampling." << std::endl;
+/// <summary> Creates the streaming texture that every frame is written into, in the renderer's native format if it can be written without conversion. </summary>
+/// <returns> <c>true</c> if the texture was created; otherwise, <c>false</c>. </returns>
+bool Game::createTexture()
+{
+	// Use the first format the renderer supports that a frame target can write, falling back to one that SDL will convert.
+	SDL_RendererInfo rendererInfo;
+	m_textureFormat = SDL_PIXELFORMAT_ARGB8888;
+	if (SDL_GetRendererInfo(MCG::GetRenderer(), &rendererInfo) == 0)
+	{
+		for (uint32_t i = 0; i < rendererInfo.num_texture_formats; i++)
+		{
+			if (isByteAligned32(rendererInfo.texture_formats[i])) { m_textureFormat = rendererInfo.texture_formats[i]; break; }
+		}
+	}
 
-	// Now that it has been used, delete the full res and sampled buffer.
-	delete fullResBuffer;
-	delete superSampledBuffer;
-	fullResBuffer = NULL;
-	superSampledBuffer = NULL;
-	drawBuffer = NULL;
+	m_texture = SDL_CreateTexture(MCG::GetRenderer(), m_textureFormat, SDL_TEXTUREACCESS_STREAMING, m_windowSize.x, m_windowSize.y);
+	return m_texture != nullptr;
+}
 
-	SDL_DestroyTexture(texture);
-	texture = nullptr;
+/// <summary> Locks the whole texture for writing. </summary>
+/// <param name="o_target"> Set to a frame target over the locked memory, which is valid until the texture is unlocked. </param>
+/// <returns> <c>true</c> if the texture was locked; otherwise, <c>false</c>, and the target is left unchanged. </returns>
+bool Game::lockTexture(Rendering::FrameTarget& o_target)
+{
+	// Lock the texture to get its memory.
+	void* pixels = nullptr;
+	int pitch = 0;
+	if (SDL_LockTexture(m_texture, NULL, &pixels, &pitch) != 0 || pixels == nullptr) { return false; }
+
+	// Find where each channel goes within a pixel.
+	int bitsPerPixel;
+	uint32_t redMask, greenMask, blueMask, alphaMask;
+	SDL_PixelFormatEnumToMasks(m_textureFormat, &bitsPerPixel, &redMask, &greenMask, &blueMask, &alphaMask);
+
+	o_target = Rendering::FrameTarget((uint8_t*)pixels, (uint32_t)pitch, (uint16_t)m_windowSize.x, (uint16_t)m_windowSize.y, maskShift(redMask), maskShift(greenMask), maskShift(blueMask), alphaMask);
+	return true;
 }
\ No newline at end of file
@@ -10,23 +10,47 @@
 // Typedef includes.
 #include <stdint.h>
 
+// SDL includes.
+#include <SDL.h>
+
 /// <summary> Represents a container that allows for functions to be called to manipulate the world. </summary>
 class Game
 {
 public:
 	/// <summary> Creates the game with the given window size, threads, and sample rate. </summary>
 	/// <param name="_windowSize"> The size of the window in pixels. </param>
-	/// <param name="_threadAmount"> The number of threads to use for rendering. Defaults to <c>1</c>. </param>
+	/// <param name="_threadAmount"> The number of threads to use for rendering. Defaults to <c>0</c>, which uses every worker in the thread pool. </param>
+	/// <param name="_samples"> The sample rate to use for rendering. Defaults to <c>1</c>. </param>
+	/// <param name="_scene"> The scene to render. Defaults to the default scene. </param>
+	Game(const glm::ivec2 _windowSize, const uint16_t _threadAmount = 0, const uint8_t _samples = 1, const Scenes::Scene& _scene = Scenes::Scene::Default()) : m_windowSize(_windowSize), m_world(World(_windowSize, _scene)), m_settings(), m_texture(nullptr), m_textureFormat(SDL_PIXELFORMAT_UNKNOWN) { m_settings.m_threadAmount = _threadAmount; m_settings.m_sampleLevel = _samples; draw(); }
+
+	/// <summary> Creates the game with the given window size, world, threads, and sample rate. </summary>
+	/// <param name="_windowSize"> The size of the window in pixels. </param>
+	/// <param name="_world"> The world to render, such as one traced straight from a mapped scene, whose camera should match the window size. </param>
+	/// <param name="_threadAmount"> The number of threads to use for rendering. Defaults to <c>0</c>, which uses every worker in the thread pool. </param>
 	/// <param name="_samples"> The sample rate to use for rendering. Defaults to <c>1</c>. </param>
-	Game(const glm::ivec2 _windowSize, const uint8_t _threadAmount = 1, const uint8_t _samples = 1) : m_windowSize(_windowSize), m_world(World(_windowSize * (int)_samples)), m_threads(_threadAmount), m_samples(_samples) { draw(); }
+	Game(const glm::ivec2 _windowSize, const World& _world, const uint16_t _threadAmount = 0, const uint8_t _samples = 1) : m_windowSize(_windowSize), m_world(_world), m_settings(), m_texture(nullptr), m_textureFormat(SDL_PIXELFORMAT_UNKNOWN) { m_settings.m_threadAmount = _threadAmount; m_settings.m_sampleLevel = _samples; draw(); }
+
+	/// <summary> The game owns the texture it draws to, so it cannot be copied. </summary>
+	Game(const Game&) = delete;
+
+	/// <summary> The game owns the texture it draws to, so it cannot be copied. </summary>
+	Game& operator=(const Game&) = delete;
+
+	/// <summary> Destroys the texture drawn to. </summary>
+	~Game() { if (m_texture != nullptr) { SDL_DestroyTexture(m_texture); } }
 
 	/// <summary> Change the sample rate multiplier, then draw. </summary>
-	/// <param name="_newSamples"> The number of samples to use. </param>
-	inline void ChangeSampleRate(const uint8_t _newSamples) { m_samples = _newSamples; m_world = World(m_windowSize * (int)_newSamples); draw(); }
+	/// <param name="_newSamples"> The width and height of the grid of samples traced within each pixel. </param>
+	inline void ChangeSampleRate(const uint8_t _newSamples) { m_settings.m_sampleLevel = _newSamples; draw(); }
+
+	/// <summary> Change how the samples of each pixel are chosen, then draw. </summary>
+	/// <param name="_newMode"> The new sample mode. </param>
+	inline void ChangeSampleMode(const Rendering::SampleMode _newMode) { m_settings.m_sampleMode = _newMode; draw(); }
 
 	/// <summary> Change the amount of threads used to draw, then draw. </summary>
-	/// <param name="_newThreads"> The new amount of threads to use. </param>
-	inline void ChangeThreads(const uint8_t _newThreads) { m_threads = _newThreads; draw(); }
+	/// <param name="_newThreads"> The new amount of threads to use, or <c>0</c> to use every worker in the thread pool. </param>
+	inline void ChangeThreads(const uint16_t _newThreads) { m_settings.m_threadAmount = _newThreads; draw(); }
 private:
 	/// <summary> The size of the window. </summary>
 	glm::ivec2 m_windowSize;
@@ -34,12 +58,19 @@ private:
 	/// <summary> The world to render and manipulate. </summary>
 	World m_world;
 
-	/// <summary> The amount of threads with which to render. </summary>
-	uint8_t m_threads;
+	/// <summary> The settings with which to render. </summary>
+	Rendering::RenderSettings m_settings;
+
+	/// <summary> The texture that each frame is written straight into, which lasts as long as the game. </summary>
+	SDL_Texture* m_texture;
 
-	/// <summary> The number of samples to make of the final buffer. </summary>
-	uint8_t m_samples;
+	/// <summary> The pixel format of the texture, which is the renderer's native format where possible. </summary>
+	uint32_t m_textureFormat;
 
 	void draw();
+
+	bool createTexture();
+
+	bool lockTexture(Rendering::FrameTarget&);
 };
 #endif
\ No newline at end of file
@@ -145,7 +145,12 @@ bool MCG::ProcessFrame(Game& _game)
 				case SDLK_F4: { _game.ChangeSampleRate(8); break; }
 				case SDLK_F5: { _game.ChangeSampleRate(16); break; }
 
-				// 1-8 to change thread amount.
+				// F6 to sample adaptively, F7 to sample every pixel uniformly.
+				case SDLK_F6: { _game.ChangeSampleMode(Rendering::SampleMode::Adaptive); break; }
+				case SDLK_F7: { _game.ChangeSampleMode(Rendering::SampleMode::Uniform); break; }
+
+				// 1-8 to change thread amount, 0 to use every available thread.
+				case SDLK_0: { _game.ChangeThreads(0); break; }
 				case SDLK_1: { _game.ChangeThreads(1); break; }
 				case SDLK_2: { _game.ChangeThreads(2); break; }
 				case SDLK_3: { _game.ChangeThreads(3); break; }
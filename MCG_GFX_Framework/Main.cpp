@@ -4,6 +4,16 @@
 
 // Data includes.
 #include "Game.h"
+#include "SceneFile.h"
+#include "MappedScene.h"
+
+// Diagnostic includes.
+#include "Telemetry.h"
+#include "Timeline.h"
+
+// Utility includes.
+#include <iostream>
+#include <string>
 
 int main( int argc, char *argv[] )
 {
@@ -13,8 +23,29 @@ int main( int argc, char *argv[] )
 	// Initialise the window.
 	if(!MCG::Init(windowSize)) { return -1; }
 
+	// Write a line of telemetry to the console for every frame.
+	Telemetry::Recorder::Get().SetOutput(&std::cout);
+	Telemetry::Recorder::Get().SetEnabled(true);
+
+	// If given a path with --trace, write a Chrome trace of every frame to that path followed by the frame's number.
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::string(argv[i]) == "--trace") { Telemetry::Timeline::Get().SetOutputPrefix(argv[i + 1]); Telemetry::Timeline::Get().SetEnabled(true); }
+	}
+
+	// If given a path with --scene, render that scene instead of the default, tracing straight from it if it can be mapped.
+	Scenes::Scene scene = Scenes::Scene::Default();
+	Scenes::MappedScene mappedScene;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::string(argv[i]) != "--scene") { continue; }
+		std::string error;
+		bool loaded = Scenes::MappedScene::IsMappedScene(argv[i + 1]) ? mappedScene.Open(argv[i + 1], error) : Scenes::SceneFile::Load(argv[i + 1], scene, error);
+		if (!loaded) { std::cerr << error << std::endl; return -1; }
+	}
+
 	// Create a game object to render and handle the world.
-	Game game = Game(windowSize, 8, 2);
+	Game game(windowSize, mappedScene.IsOpen() ? World(windowSize, mappedScene) : World(windowSize, scene), 0, 2);
 
 	// Keep rendering the same frame and taking user input until they wish to quit.
 	while (MCG::ProcessFrame(game)) {};
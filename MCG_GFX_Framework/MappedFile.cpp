@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+
+// Platform includes.
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// <summary> Unmaps the file, if one is mapped. </summary>
+Scenes::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/// <summary> Maps the whole of the given file read-only, replacing any file already mapped. </summary>
+/// <remarks> Nothing is read from the file here, the operating system reads each page the first time it is touched. </remarks>
+/// <param name="_path"> The path of the file. </param>
+/// <param name="o_error"> Why the file could not be mapped, if it could not. </param>
+/// <returns> <c>true</c> if the file was mapped; otherwise, <c>false</c>. </returns>
+bool Scenes::MappedFile::Open(const std::string& _path, std::string& o_error)
+{
+	Close();
+
+#if defined(_WIN32)
+	// Open the file and find its size.
+	HANDLE file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { o_error = "Could not open " + _path; return false; }
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { CloseHandle(file); o_error = "Could not map " + _path + " as it is empty"; return false; }
+
+	// Map a view of the whole file, the view keeps the file open so both handles can be closed straight away.
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) { o_error = "Could not map " + _path; return false; }
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == nullptr) { o_error = "Could not map " + _path; return false; }
+
+	m_size = (uint64_t)fileSize.QuadPart;
+#else
+	// Open the file and find its size.
+	int file = open(_path.c_str(), O_RDONLY);
+	if (file < 0) { o_error = "Could not open " + _path; return false; }
+	struct stat fileStatus;
+	if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0) { close(file); o_error = "Could not map " + _path + " as it is empty"; return false; }
+
+	// Map the whole file shared so that the page cache is used directly, the mapping keeps the file open so it can be closed straight away.
+	void* data = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+	if (data == MAP_FAILED) { o_error = "Could not map " + _path; return false; }
+
+	// Rays touch the scene all over, so reading ahead of each fault would mostly read pages that are not needed yet.
+	madvise(data, (size_t)fileStatus.st_size, MADV_RANDOM);
+
+	m_size = (uint64_t)fileStatus.st_size;
+#endif
+
+	m_data = (const uint8_t*)data;
+	return true;
+}
+
+/// <summary> Unmaps the file, if one is mapped. </summary>
+void Scenes::MappedFile::Close()
+{
+	if (m_data == nullptr) { return; }
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_data);
+#else
+	munmap((void*)m_data, (size_t)m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+// Utility includes.
+#include <string>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Scenes
+{
+	/// <summary> Represents a whole file mapped read-only into memory, so that pages are only read from disk when first touched and are shared with any other process mapping the same file. </summary>
+	class MappedFile
+	{
+	public:
+		/// <summary> Creates an empty mapping. </summary>
+		MappedFile() : m_data(nullptr), m_size(0) { }
+
+		MappedFile(const MappedFile&) = delete;
+
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile();
+
+		bool Open(const std::string&, std::string&);
+
+		void Close();
+
+		/// <summary> Gets the start of the file. </summary>
+		/// <returns> The first byte, or <c>nullptr</c> if nothing is mapped. </returns>
+		inline const uint8_t* GetData() const { return m_data; }
+
+		/// <summary> Gets the size of the file. </summary>
+		/// <returns> The size in bytes. </returns>
+		inline uint64_t GetSize() const { return m_size; }
+	private:
+		/// <summary> The start of the mapped file. </summary>
+		const uint8_t* m_data;
+
+		/// <summary> The size of the mapped file in bytes. </summary>
+		uint64_t m_size;
+	};
+}
+#endif
\ No newline at end of file
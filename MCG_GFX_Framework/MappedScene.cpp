@@ -0,0 +1,226 @@
+#include "MappedScene.h"
+
+// Data includes.
+#include "SceneFile.h"
+
+// Utility includes.
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+static_assert(Scenes::MappedScene::Version == Scenes::SceneFile::BinaryVersion, "Binary scenes are always written to be mapped.");
+static_assert(sizeof(Scenes::MappedSceneHeader) == 160, "The mapped scene header must have no padding.");
+static_assert(sizeof(Scenes::BinaryMaterial) == 8, "A binary material must have no padding.");
+static_assert(sizeof(Shapes::BoundingVolumeHierarchy::Node) == 32, "A hierarchy node must have no padding, as the nodes are used straight from the file.");
+
+/// <summary> Maps the given scene file, checking its header and the layout of its sections against the size of the file, but reading no sphere or node and copying nothing out except the material table. </summary>
+/// <param name="_path"> The path of the file, which must be a binary scene of <see cref="Version"/>. </param>
+/// <param name="o_error"> Why the scene could not be mapped, if it could not. </param>
+/// <returns> <c>true</c> if the scene was mapped; otherwise, <c>false</c>. </returns>
+bool Scenes::MappedScene::Open(const std::string& _path, std::string& o_error)
+{
+	// Start from nothing, so that a failed open leaves nothing mapped.
+	m_file.reset();
+	m_header = nullptr;
+	m_materials.clear();
+
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->Open(_path, o_error)) { return false; }
+
+	// Check the header, and that each section is exactly where it should be and fits within the file.
+	if (file->GetSize() < sizeof(MappedSceneHeader)) { o_error = "The mapped scene is too short for its header"; return false; }
+	const MappedSceneHeader* header = (const MappedSceneHeader*)file->GetData();
+	if (memcmp(header->m_magic, SceneFile::BinaryMagic, sizeof(header->m_magic)) != 0) { o_error = _path + " is not a binary scene"; return false; }
+	if (header->m_version != Version) { o_error = "Cannot map binary scene version " + std::to_string(header->m_version) + ", only version " + std::to_string(Version); return false; }
+	if (header->m_sphereCount > UINT32_MAX - Shapes::SphereSet::LaneCount) { o_error = "The mapped scene has too many spheres"; return false; }
+	if (header->m_sphereCount > 0 && header->m_materialCount == 0) { o_error = "The mapped scene has spheres but no materials"; return false; }
+	if (header->m_nodeCount > 0 && (header->m_sphereCount == 0 || (uint64_t)header->m_nodeCount > 2 * (uint64_t)header->m_sphereCount - 1)) { o_error = "The mapped scene has more nodes than its spheres could need"; return false; }
+	if (header->m_buildMethod[0] > (uint8_t)Shapes::BuildMethod::Morton) { o_error = "The mapped scene has unknown build method " + std::to_string(header->m_buildMethod[0]); return false; }
+	if (!SceneCamera(glm::vec3(), glm::vec3(), header->m_camera[6]).IsValid()) { o_error = "Header: invalid camera"; return false; }
+
+	uint64_t offsets[(size_t)MappedSection::Count];
+	uint64_t size = Layout(header->m_sphereCount, header->m_materialCount, header->m_nodeCount, offsets);
+	if (memcmp(offsets, header->m_sectionOffsets, sizeof(offsets)) != 0) { o_error = "The mapped scene's sections are not where they should be"; return false; }
+	if (file->GetSize() < size) { o_error = "The mapped scene is shorter than its header says"; return false; }
+
+	// Copy out the materials, which are tiny.
+	const BinaryMaterial* materials = (const BinaryMaterial*)(file->GetData() + offsets[(size_t)MappedSection::Materials]);
+	for (uint32_t i = 0; i < header->m_materialCount; i++) { m_materials.push_back(Shapes::ShapeProperties(Colour(materials[i].m_colour[0], materials[i].m_colour[1], materials[i].m_colour[2]), materials[i].m_reflectiveness)); }
+
+	m_file = file;
+	m_header = header;
+	return true;
+}
+
+/// <summary> Checks every sphere and node within the mapped scene, so that no index read from the file can reach outside an array. </summary>
+/// <param name="o_error"> The first sphere or node that is invalid and why, if one is. </param>
+/// <returns> <c>true</c> if the whole scene is valid; otherwise, <c>false</c>. </returns>
+/// <remarks> This reads the whole file, so it is left to those that cannot trust where the file came from rather than done on every open. </remarks>
+bool Scenes::MappedScene::Validate(std::string& o_error) const
+{
+	return checkSpheres(*m_header, m_file->GetData(), o_error) && checkHierarchy(*m_header, m_file->GetData(), o_error);
+}
+
+/// <summary> Gets where the scene is viewed from. </summary>
+/// <returns> The camera. </returns>
+Scenes::SceneCamera Scenes::MappedScene::GetCamera() const
+{
+	const float_t* camera = m_header->m_camera;
+	return SceneCamera(glm::vec3(camera[0], camera[1], camera[2]), glm::vec3(camera[3], camera[4], camera[5]), camera[6]);
+}
+
+/// <summary> Gets the source of light. </summary>
+/// <returns> The light. </returns>
+PointLight Scenes::MappedScene::GetLight() const
+{
+	const float_t* light = m_header->m_light;
+	return PointLight(glm::vec3(light[0], light[1], light[2]), light[3], Colour(m_header->m_lightColour[0], m_header->m_lightColour[1], m_header->m_lightColour[2]));
+}
+
+/// <summary> Creates a set that uses the spheres straight from the file, which stays mapped for as long as the set exists. </summary>
+/// <returns> The sphere set, in the order of the hierarchy's leaves. </returns>
+Shapes::SphereSet Scenes::MappedScene::CreateSphereSet() const
+{
+	Shapes::SphereArrays arrays;
+	arrays.m_centreX = (const float_t*)getSection(MappedSection::CentreX);
+	arrays.m_centreY = (const float_t*)getSection(MappedSection::CentreY);
+	arrays.m_centreZ = (const float_t*)getSection(MappedSection::CentreZ);
+	arrays.m_radiusSquared = (const float_t*)getSection(MappedSection::RadiusSquared);
+	arrays.m_radius = (const float_t*)getSection(MappedSection::Radius);
+	arrays.m_materialIndex = (const uint32_t*)getSection(MappedSection::MaterialIndex);
+	arrays.m_originalIndex = (const uint32_t*)getSection(MappedSection::OriginalIndex);
+	return Shapes::SphereSet(m_header->m_sphereCount, arrays, m_materials, m_file);
+}
+
+/// <summary> Creates a hierarchy that uses the nodes straight from the file, which stays mapped for as long as the hierarchy exists. </summary>
+/// <returns> The hierarchy, which is empty if none was saved. </returns>
+Shapes::BoundingVolumeHierarchy Scenes::MappedScene::CreateHierarchy() const
+{
+	if (!HasHierarchy()) { return Shapes::BoundingVolumeHierarchy(); }
+
+	Shapes::BuildStats buildStats;
+	buildStats.m_method = (Shapes::BuildMethod)m_header->m_buildMethod[0];
+	buildStats.m_nodeCount = m_header->m_nodeCount;
+	buildStats.m_leafCount = m_header->m_leafCount;
+	buildStats.m_cost = m_header->m_buildCost;
+	return Shapes::BoundingVolumeHierarchy((const Shapes::BoundingVolumeHierarchy::Node*)getSection(MappedSection::Nodes), m_header->m_nodeCount, buildStats, m_file);
+}
+
+/// <summary> Copies the whole scene out of the file, putting the spheres back in the order they were saved in. </summary>
+/// <param name="o_scene"> The scene, which is replaced. </param>
+void Scenes::MappedScene::CopyTo(Scene& o_scene) const
+{
+	o_scene = Scene();
+	o_scene.m_camera = GetCamera();
+	o_scene.m_light = GetLight();
+	o_scene.m_materials = m_materials;
+
+	Shapes::SphereSet spheres = CreateSphereSet();
+	Shapes::SphereArrays arrays = spheres.GetArrays();
+	o_scene.m_spheres.resize(spheres.GetCount());
+	for (uint32_t i = 0; i < spheres.GetCount(); i++) { o_scene.m_spheres[arrays.m_originalIndex[i]] = { spheres.GetCentre(i), spheres.GetRadius(i), arrays.m_materialIndex[i] }; }
+}
+
+/// <summary> Checks that every sphere within the given mapped scene has a size and a material that exists, that their original indices are each used exactly once, and that the padding past them can never be hit. </summary>
+/// <param name="_header"> The header, whose section offsets have already been checked against the file. </param>
+/// <param name="_data"> The first byte of the mapped file. </param>
+/// <param name="o_error"> The first sphere that is invalid and why, if one is. </param>
+/// <returns> <c>true</c> if every sphere is valid; otherwise, <c>false</c>. </returns>
+bool Scenes::MappedScene::checkSpheres(const MappedSceneHeader& _header, const uint8_t* _data, std::string& o_error)
+{
+	const float_t* radiiSquared = (const float_t*)(_data + _header.m_sectionOffsets[(size_t)MappedSection::RadiusSquared]);
+	const float_t* radii = (const float_t*)(_data + _header.m_sectionOffsets[(size_t)MappedSection::Radius]);
+	const uint32_t* materialIndices = (const uint32_t*)(_data + _header.m_sectionOffsets[(size_t)MappedSection::MaterialIndex]);
+	const uint32_t* originalIndices = (const uint32_t*)(_data + _header.m_sectionOffsets[(size_t)MappedSection::OriginalIndex]);
+
+	std::vector<bool> isOriginalUsed(_header.m_sphereCount, false);
+	for (uint32_t i = 0; i < _header.m_sphereCount; i++)
+	{
+		if (!(radii[i] > 0)) { o_error = "Sphere " + std::to_string(i) + ": invalid sphere"; return false; }
+		if (materialIndices[i] >= _header.m_materialCount) { o_error = "A sphere refers to material " + std::to_string(materialIndices[i]) + ", which does not exist"; return false; }
+
+		// The original indices must be a permutation, as copying the scene out writes each sphere to its original index.
+		uint32_t originalIndex = originalIndices[i];
+		if (originalIndex >= _header.m_sphereCount || isOriginalUsed[originalIndex]) { o_error = "Sphere " + std::to_string(i) + " has original index " + std::to_string(originalIndex) + ", which is out of range or already used"; return false; }
+		isOriginalUsed[originalIndex] = true;
+	}
+
+	// The padding lanes are tested alongside real spheres, so each must have the negative size that no ray can hit.
+	for (uint32_t i = _header.m_sphereCount; i < _header.m_sphereCount + Shapes::SphereSet::LaneCount; i++)
+	{
+		if (radiiSquared[i] != -1) { o_error = "Padding sphere " + std::to_string(i) + " could be hit"; return false; }
+	}
+
+	return true;
+}
+
+/// <summary> Checks that every node within the given mapped scene's hierarchy only refers to spheres and nodes that exist, and that the tree is shallow enough to traverse. </summary>
+/// <param name="_header"> The header, whose section offsets have already been checked against the file. </param>
+/// <param name="_data"> The first byte of the mapped file. </param>
+/// <param name="o_error"> The first node that is invalid and why, if one is. </param>
+/// <returns> <c>true</c> if every node is valid or there is no hierarchy; otherwise, <c>false</c>. </returns>
+/// <remarks> Children must come after their parent, as they always do once built, which also means the nodes cannot form a loop. </remarks>
+bool Scenes::MappedScene::checkHierarchy(const MappedSceneHeader& _header, const uint8_t* _data, std::string& o_error)
+{
+	const Shapes::BoundingVolumeHierarchy::Node* nodes = (const Shapes::BoundingVolumeHierarchy::Node*)(_data + _header.m_sectionOffsets[(size_t)MappedSection::Nodes]);
+
+	// Going over the nodes in order reaches every parent before its children, so each node's depth is known by the time it is checked.
+	std::vector<uint32_t> depths(_header.m_nodeCount, 0);
+	for (uint32_t n = 0; n < _header.m_nodeCount; n++)
+	{
+		const Shapes::BoundingVolumeHierarchy::Node& node = nodes[n];
+		if (node.IsLeaf())
+		{
+			if ((uint64_t)node.m_leftOrFirst + node.m_count > _header.m_sphereCount) { o_error = "Node " + std::to_string(n) + " holds spheres past the last sphere"; return false; }
+			continue;
+		}
+
+		if (node.m_leftOrFirst <= n || (uint64_t)node.m_leftOrFirst + 1 >= _header.m_nodeCount) { o_error = "Node " + std::to_string(n) + " has children out of range"; return false; }
+		if (depths[n] + 1 >= Shapes::BoundingVolumeHierarchy::MaxDepth) { o_error = "The mapped scene's hierarchy is too deep to traverse"; return false; }
+		depths[node.m_leftOrFirst] = glm::max(depths[node.m_leftOrFirst], depths[n] + 1);
+		depths[node.m_leftOrFirst + 1] = glm::max(depths[node.m_leftOrFirst + 1], depths[n] + 1);
+	}
+
+	return true;
+}
+
+/// <summary> Finds if the given file is a binary scene that can be mapped, by reading only its magic bytes and version. </summary>
+/// <param name="_path"> The path of the file. </param>
+/// <returns> <c>true</c> if the file starts like a mapped scene; otherwise, <c>false</c>. </returns>
+bool Scenes::MappedScene::IsMappedScene(const std::string& _path)
+{
+	std::ifstream file(_path, std::ios::binary);
+	char magic[sizeof(SceneFile::BinaryMagic)];
+	uint32_t version;
+	return file.read(magic, sizeof(magic)) && file.read((char*)&version, sizeof(version)) && memcmp(magic, SceneFile::BinaryMagic, sizeof(magic)) == 0 && version == Version;
+}
+
+/// <summary> Finds where each section of a mapped scene with the given counts starts, each aligned to <see cref="SectionAlignment"/>. </summary>
+/// <param name="_sphereCount"> The number of spheres, not including padding. </param>
+/// <param name="_materialCount"> The number of materials. </param>
+/// <param name="_nodeCount"> The number of hierarchy nodes. </param>
+/// <param name="o_offsets"> The offset from the start of the file of each <see cref="MappedSection"/>. </param>
+/// <returns> The size of the whole file in bytes. </returns>
+uint64_t Scenes::MappedScene::Layout(const uint32_t _sphereCount, const uint32_t _materialCount, const uint32_t _nodeCount, uint64_t* o_offsets)
+{
+	// Each array holds a full vector of padding past the end, as a sphere set does.
+	uint64_t paddedCount = (uint64_t)_sphereCount + Shapes::SphereSet::LaneCount;
+	const uint64_t sectionSizes[(size_t)MappedSection::Count] =
+	{
+		paddedCount * sizeof(float_t), paddedCount * sizeof(float_t), paddedCount * sizeof(float_t), paddedCount * sizeof(float_t), paddedCount * sizeof(float_t),
+		paddedCount * sizeof(uint32_t), paddedCount * sizeof(uint32_t),
+		(uint64_t)_materialCount * sizeof(BinaryMaterial),
+		(uint64_t)_nodeCount * sizeof(Shapes::BoundingVolumeHierarchy::Node)
+	};
+
+	// Place each section on the next aligned offset after the last.
+	uint64_t offset = sizeof(MappedSceneHeader);
+	for (size_t section = 0; section < (size_t)MappedSection::Count; section++)
+	{
+		offset = (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+		o_offsets[section] = offset;
+		offset += sectionSizes[section];
+	}
+
+	return offset;
+}
\ No newline at end of file
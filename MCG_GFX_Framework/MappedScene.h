@@ -0,0 +1,160 @@
+#ifndef MAPPEDSCENE_H
+#define MAPPEDSCENE_H
+
+// Data includes.
+#include "Scene.h"
+#include "SphereSet.h"
+#include "BoundingVolumeHierarchy.h"
+#include "MappedFile.h"
+
+// Utility includes.
+#include <string>
+#include <memory>
+
+// Typedef includes.
+#include <stdint.h>
+#include <cmath>
+
+namespace Scenes
+{
+	/// <summary> The sections of a mapped scene, in the order they are laid out within the file. </summary>
+	enum class MappedSection : uint8_t
+	{
+		CentreX,
+		CentreY,
+		CentreZ,
+		RadiusSquared,
+		Radius,
+		MaterialIndex,
+		OriginalIndex,
+		Materials,
+		Nodes,
+		Count
+	};
+
+	/// <summary> Represents a material within a binary scene. </summary>
+	struct BinaryMaterial
+	{
+		/// <summary> The colour, followed by a byte of padding. </summary>
+		uint8_t m_colour[4];
+
+		/// <summary> How reflective the surface is. </summary>
+		float_t m_reflectiveness;
+	};
+
+	/// <summary> Represents the start of a mapped scene, laid out with no padding so it can be used straight from the file. </summary>
+	struct MappedSceneHeader
+	{
+		/// <summary> The magic bytes, which must match <see cref="SceneFile::BinaryMagic"/>. </summary>
+		char m_magic[8];
+
+		/// <summary> The version of the format. </summary>
+		uint32_t m_version;
+
+		/// <summary> The number of materials. </summary>
+		uint32_t m_materialCount;
+
+		/// <summary> The number of spheres, not including padding. </summary>
+		uint32_t m_sphereCount;
+
+		/// <summary> The number of hierarchy nodes, or <c>0</c> if no hierarchy was saved. </summary>
+		uint32_t m_nodeCount;
+
+		/// <summary> The camera's position, the point it looks at, and its field of view. </summary>
+		float_t m_camera[7];
+
+		/// <summary> The light's position and intensity. </summary>
+		float_t m_light[4];
+
+		/// <summary> The light's colour, followed by a byte of padding. </summary>
+		uint8_t m_lightColour[4];
+
+		/// <summary> The <see cref="Shapes::BuildMethod"/> the hierarchy was built with, followed by three bytes of padding. </summary>
+		uint8_t m_buildMethod[4];
+
+		/// <summary> The number of leaves within the hierarchy. </summary>
+		uint32_t m_leafCount;
+
+		/// <summary> The surface area heuristic cost of the hierarchy. </summary>
+		float_t m_buildCost;
+
+		/// <summary> Unused, keeping the offsets eight byte aligned. </summary>
+		uint32_t m_reserved;
+
+		/// <summary> The offset from the start of the file of each <see cref="MappedSection"/>. </summary>
+		uint64_t m_sectionOffsets[(size_t)MappedSection::Count];
+	};
+
+	/// <summary> Represents a binary scene mapped into memory, which a world can trace straight from without reading or copying the spheres. </summary>
+	/// <remarks>
+	/// The file holds a header, then each array of a <see cref="Shapes::SphereSet"/> with its padding, then the material table, then the hierarchy's nodes.
+	/// Every section starts on its own cache line, and the spheres are saved in the order of the hierarchy's leaves.
+	/// Opening only checks the header and the layout of the sections against the size of the file, so it takes the same time however many spheres there are.
+	/// The spheres and nodes are trusted until <see cref="Validate"/> is called, which makes one pass over them so that no index read from the file can reach outside an array.
+	/// </remarks>
+	class MappedScene
+	{
+	public:
+		/// <summary> Creates an empty scene with nothing mapped. </summary>
+		MappedScene() : m_file(), m_header(nullptr), m_materials() { }
+
+		bool Open(const std::string&, std::string&);
+
+		bool Validate(std::string&) const;
+
+		/// <summary> Finds if a scene is mapped. </summary>
+		/// <returns> <c>true</c> if a scene has been opened; otherwise, <c>false</c>. </returns>
+		inline bool IsOpen() const { return m_header != nullptr; }
+
+		/// <summary> Gets the number of spheres. </summary>
+		/// <returns> The number of spheres, not including padding. </returns>
+		inline uint32_t GetSphereCount() const { return m_header->m_sphereCount; }
+
+		/// <summary> Gets the material table. </summary>
+		/// <returns> Every unique set of surface properties. </returns>
+		inline const std::vector<Shapes::ShapeProperties>& GetMaterials() const { return m_materials; }
+
+		/// <summary> Finds if a prebuilt hierarchy was saved with the spheres. </summary>
+		/// <returns> <c>true</c> if there is a hierarchy; otherwise, <c>false</c>. </returns>
+		inline bool HasHierarchy() const { return m_header->m_nodeCount > 0; }
+
+		SceneCamera GetCamera() const;
+
+		PointLight GetLight() const;
+
+		Shapes::SphereSet CreateSphereSet() const;
+
+		Shapes::BoundingVolumeHierarchy CreateHierarchy() const;
+
+		void CopyTo(Scene&) const;
+
+		static bool IsMappedScene(const std::string&);
+
+		static uint64_t Layout(uint32_t, uint32_t, uint32_t, uint64_t*);
+
+		/// <summary> The version of the binary format that is mapped. </summary>
+		static const uint32_t Version = 2;
+
+		/// <summary> The alignment in bytes of each section, a cache line, which is also wide enough for any vector load. </summary>
+		static const uint64_t SectionAlignment = 64;
+	private:
+		/// <summary> The mapped file, shared with every set and hierarchy created from it. </summary>
+		std::shared_ptr<MappedFile> m_file;
+
+		/// <summary> The header at the start of the mapped file. </summary>
+		const MappedSceneHeader* m_header;
+
+		/// <summary> The material table, copied out of the file as it is tiny and needs converting. </summary>
+		std::vector<Shapes::ShapeProperties> m_materials;
+
+		/// <summary> Gets the start of the given section. </summary>
+		/// <param name="_section"> The section. </param>
+		/// <returns> The first byte of the section within the mapped file. </returns>
+		inline const uint8_t* getSection(const MappedSection _section) const { return m_file->GetData() + m_header->m_sectionOffsets[(size_t)_section]; }
+
+		static bool checkSpheres(const MappedSceneHeader&, const uint8_t*, std::string&);
+
+		static bool checkHierarchy(const MappedSceneHeader&, const uint8_t*, std::string&);
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+// Framework includes.
+#include <glm.hpp>
+
+// Data includes.
+#include "Ray.h"
+
+// Typedef includes.
+#include <stdint.h>
+#include <cmath>
+
+/// <summary> Represents a small block of neighbouring rays stored as a structure of arrays, so that one sphere or box can be tested against every ray at once. </summary>
+/// <remarks> Every lane up to the size is always traced, inactive lanes are only there to keep the packet square and their results are ignored. </remarks>
+struct alignas(32) RayPacket
+{
+	/// <summary> The most rays a packet can hold. </summary>
+	static const uint32_t MaxSize = 16;
+
+	/// <summary> Creates an empty packet with every lane cleared, so that kernels wider than the packet read harmless rays. </summary>
+	RayPacket() : m_originX(), m_originY(), m_originZ(), m_directionX(), m_directionY(), m_directionZ(), m_distance(), m_index(), m_size(0), m_activeMask(0) { }
+
+	/// <summary> The x position of each origin. </summary>
+	float_t m_originX[MaxSize];
+
+	/// <summary> The y position of each origin. </summary>
+	float_t m_originY[MaxSize];
+
+	/// <summary> The z position of each origin. </summary>
+	float_t m_originZ[MaxSize];
+
+	/// <summary> The x component of each normalised direction. </summary>
+	float_t m_directionX[MaxSize];
+
+	/// <summary> The y component of each normalised direction. </summary>
+	float_t m_directionY[MaxSize];
+
+	/// <summary> The z component of each normalised direction. </summary>
+	float_t m_directionZ[MaxSize];
+
+	/// <summary> The distance to the closest hit of each ray, or <c>INFINITY</c> if it has hit nothing. When finding any hit, the distance beyond which hits are not counted. </summary>
+	float_t m_distance[MaxSize];
+
+	/// <summary> The index within the set of the closest sphere hit by each ray, or <c>UINT32_MAX</c> if it has hit nothing. When finding any hit, the index of a sphere to skip. </summary>
+	uint32_t m_index[MaxSize];
+
+	/// <summary> The number of rays, which is a multiple of four. </summary>
+	uint32_t m_size;
+
+	/// <summary> A bit for each ray whose result is wanted. </summary>
+	uint32_t m_activeMask;
+
+	/// <summary> Sets the given ray, and clears its hit. </summary>
+	/// <param name="_lane"> The index of the ray within the packet. </param>
+	/// <param name="_ray"> The ray, with a normalised direction. </param>
+	inline void SetRay(const uint32_t _lane, const Ray& _ray)
+	{
+		m_originX[_lane] = _ray.m_origin.x; m_originY[_lane] = _ray.m_origin.y; m_originZ[_lane] = _ray.m_origin.z;
+		m_directionX[_lane] = _ray.m_direction.x; m_directionY[_lane] = _ray.m_direction.y; m_directionZ[_lane] = _ray.m_direction.z;
+		m_distance[_lane] = INFINITY;
+		m_index[_lane] = UINT32_MAX;
+	}
+
+	/// <summary> Gets the given ray on its own. </summary>
+	/// <param name="_lane"> The index of the ray within the packet. </param>
+	/// <returns> The ray. </returns>
+	inline Ray GetRay(const uint32_t _lane) const { return Ray(glm::vec3(m_originX[_lane], m_originY[_lane], m_originZ[_lane]), glm::vec3(m_directionX[_lane], m_directionY[_lane], m_directionZ[_lane])); }
+
+	/// <summary> Finds if the result of the given ray is wanted. </summary>
+	/// <param name="_lane"> The index of the ray within the packet. </param>
+	/// <returns> <c>true</c> if the ray is active; otherwise, <c>false</c>. </returns>
+	inline bool IsActive(const uint32_t _lane) const { return (m_activeMask & (1u << _lane)) != 0; }
+
+	/// <summary> Gets the bits of the rays whose results are wanted, ignoring any past the size. </summary>
+	/// <returns> A bit for each active lane. </returns>
+	inline uint32_t GetActiveLanes() const { return m_activeMask & ((m_size >= 32) ? UINT32_MAX : ((1u << m_size) - 1)); }
+
+	/// <summary> Counts the rays whose results are wanted. </summary>
+	/// <returns> The number of active lanes up to the size. </returns>
+	inline uint32_t GetActiveCount() const { return CountLanes(GetActiveLanes()); }
+
+	/// <summary> Counts the lanes set within the given mask. </summary>
+	/// <param name="_laneMask"> A bit for each lane. </param>
+	/// <returns> The number of bits set. </returns>
+	static inline uint32_t CountLanes(uint32_t _laneMask)
+	{
+		uint32_t count = 0;
+		for (; _laneMask != 0; _laneMask &= _laneMask - 1) { count++; }
+		return count;
+	}
+};
+#endif
\ No newline at end of file
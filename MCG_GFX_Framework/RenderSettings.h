@@ -0,0 +1,152 @@
+#ifndef RENDERSETTINGS_H
+#define RENDERSETTINGS_H
+
+// Framework includes.
+#include <glm.hpp>
+
+// Data includes.
+#include "TileScheduler.h"
+#include "Colour.h"
+
+// Threading includes.
+#include "ThreadPool.h"
+
+// Utility includes.
+#include <cstring>
+
+// Typedef includes.
+#include <stdint.h>
+#include <cmath>
+
+namespace Rendering
+{
+	/// <summary> The ways in which the samples of each pixel are chosen. </summary>
+	enum class SampleMode : uint8_t
+	{
+		/// <summary> Every pixel traces the full grid of samples. </summary>
+		Uniform,
+
+		/// <summary> Every pixel traces one sample, then only pixels on an edge trace the rest of the grid. </summary>
+		Adaptive
+	};
+
+	/// <summary> The ways in which rays are traced through the world. </summary>
+	enum class TraceMode : uint8_t
+	{
+		/// <summary> Each path is followed bounce by bounce to its end before the next path is started. </summary>
+		Recursive,
+
+		/// <summary> Every path within a tile is traced one bounce at a time, each stage running over a whole queue of rays. </summary>
+		Wavefront
+	};
+
+	/// <summary> The ways in which a path whose throughput has fallen low is ended before it reaches the reflection limit. </summary>
+	enum class TerminationMode : uint8_t
+	{
+		/// <summary> Every path reflects until it reaches the reflection limit. </summary>
+		None,
+
+		/// <summary> A reflection is dropped once the path's throughput falls below the threshold, as it could then add less than one step of colour. </summary>
+		Threshold,
+
+		/// <summary> Once the path's throughput falls below the threshold, a reflection is only traced with a probability of the throughput over the threshold, and is scaled up by the inverse when it is, so that on average the colour is unchanged. </summary>
+		RussianRoulette
+	};
+
+	/// <summary> Represents when a path stops reflecting. </summary>
+	struct PathTermination
+	{
+		/// <summary> The most reflections made by default. </summary>
+		static const uint8_t DefaultReflectionLimit = 5;
+
+		/// <summary> Creates the settings with the given limit, mode, and threshold. </summary>
+		/// <param name="_reflectionLimit"> The most reflections to make. Defaults to <see cref="DefaultReflectionLimit"/>. </param>
+		/// <param name="_mode"> How a path with a low throughput is ended early. Defaults to never. </param>
+		/// <param name="_threshold"> The throughput below which a path may be ended early. Defaults to one step of an 8-bit colour. </param>
+		explicit PathTermination(const uint8_t _reflectionLimit = DefaultReflectionLimit, const TerminationMode _mode = TerminationMode::None, const float_t _threshold = 1.0f / 255.0f) : m_reflectionLimit(_reflectionLimit), m_mode(_mode), m_threshold(_threshold) { }
+
+		/// <summary> The most reflections to make, after which a reflective surface is shaded as if it were not. </summary>
+		uint8_t m_reflectionLimit;
+
+		/// <summary> How a path with a low throughput is ended early. </summary>
+		TerminationMode m_mode;
+
+		/// <summary> The throughput below which a path may be ended early. </summary>
+		float_t m_threshold;
+
+		/// <summary> Decides whether a path follows the given reflection. </summary>
+		/// <param name="io_throughput"> The path's throughput after the reflection, which is scaled up if it survives the roulette. </param>
+		/// <param name="_direction"> The direction of the reflection, which seeds the roulette so that the same ray always makes the same choice. </param>
+		/// <param name="_bounce"> The number of reflections made before this one. </param>
+		/// <returns> <c>true</c> if the reflection should be traced; otherwise, <c>false</c> if the path ends here. </returns>
+		inline bool Survives(float_t& io_throughput, const glm::vec3& _direction, const uint32_t _bounce) const
+		{
+			if (m_mode == TerminationMode::None || io_throughput >= m_threshold) { return true; }
+			if (m_mode == TerminationMode::Threshold) { return false; }
+
+			// Survive with a probability of the throughput over the threshold, in which case the throughput is divided by that probability, bringing it up to the threshold.
+			if (getRouletteSample(_direction, _bounce) >= io_throughput / m_threshold) { return false; }
+			io_throughput = m_threshold;
+			return true;
+		}
+	private:
+		/// <summary> Hashes the given direction and bounce into a number that is spread evenly between <c>0</c> and <c>1</c>. </summary>
+		/// <param name="_direction"> The direction of the reflection. </param>
+		/// <param name="_bounce"> The number of reflections made before this one. </param>
+		/// <returns> A number from <c>0</c> up to but not including <c>1</c>. </returns>
+		static inline float_t getRouletteSample(const glm::vec3& _direction, const uint32_t _bounce)
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &_direction.x, sizeof(uint32_t)); std::memcpy(bits + 1, &_direction.y, sizeof(uint32_t)); std::memcpy(bits + 2, &_direction.z, sizeof(uint32_t));
+
+			// Mix the bits together, then finish with the avalanche of MurmurHash3 so every bit of the input affects every bit of the output.
+			uint32_t hash = (bits[0] * 0x9E3779B1u) ^ (bits[1] * 0x85EBCA77u) ^ (bits[2] * 0xC2B2AE3Du) ^ _bounce;
+			hash ^= hash >> 16; hash *= 0x85EBCA6Bu;
+			hash ^= hash >> 13; hash *= 0xC2B2AE35u;
+			hash ^= hash >> 16;
+			return (hash >> 8) * (1.0f / 16777216.0f);
+		}
+	};
+
+	/// <summary> Represents the settings that control how a frame is rendered. </summary>
+	struct RenderSettings
+	{
+		/// <summary> Creates the default settings, using every thread with 64 pixel tiles along a Morton curve, one sample per pixel, packets of eight primary rays with each path followed to its end in turn, up to five reflections, and clamped colours. </summary>
+		RenderSettings() : m_threadAmount(0), m_tileSize(64), m_tileOrder(TileOrder::Morton), m_sampleLevel(1), m_sampleMode(SampleMode::Uniform), m_edgeThreshold(12), m_packetSize(8), m_traceMode(TraceMode::Recursive), m_termination(), m_toneMapping(ToneMapping::Clamp) { }
+
+		/// <summary> The amount of threads with which to render, where <c>0</c> uses every worker in the thread pool. </summary>
+		uint16_t m_threadAmount;
+
+		/// <summary> The requested width and height of each tile in pixels, the width is rounded up to whole cache lines. </summary>
+		uint16_t m_tileSize;
+
+		/// <summary> The order in which tiles are drawn. </summary>
+		TileOrder m_tileOrder;
+
+		/// <summary> The width and height of the grid of samples traced within each pixel, which are averaged as they are traced. </summary>
+		uint8_t m_sampleLevel;
+
+		/// <summary> How the samples of each pixel are chosen, only used when the sample level is more than <c>1</c>. </summary>
+		SampleMode m_sampleMode;
+
+		/// <summary> The summed difference of red, green, and blue between neighbouring pixels above which a pixel is treated as an edge when sampling adaptively. </summary>
+		uint16_t m_edgeThreshold;
+
+		/// <summary> The number of neighbouring rays traced together, which are the primary rays when tracing one sample per pixel and every ray when tracing as a wavefront, either <c>4</c>, <c>8</c>, or <c>16</c>, or <c>1</c> to trace each ray alone. </summary>
+		uint8_t m_packetSize;
+
+		/// <summary> How rays are traced, which only changes the image within the tolerance of tracing rays as packets. </summary>
+		TraceMode m_traceMode;
+
+		/// <summary> How many reflections each path makes, and whether paths with a low throughput are ended early. </summary>
+		PathTermination m_termination;
+
+		/// <summary> How each pixel's radiance is brought into the range of a colour when it is copied to the screen. </summary>
+		ToneMapping m_toneMapping;
+
+		/// <summary> Gets the amount of threads that will actually be used. </summary>
+		/// <returns> The thread amount, or the number of workers in the thread pool if it is <c>0</c>. </returns>
+		inline uint16_t GetThreadCount() const { return (m_threadAmount == 0) ? (uint16_t)Threading::ThreadPool::Get().GetWorkerCount() : m_threadAmount; }
+	};
+}
+#endif
\ No newline at end of file
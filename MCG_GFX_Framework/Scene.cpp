@@ -0,0 +1,22 @@
+#include "Scene.h"
+
+/// <summary> Creates the scene the world was originally built with: six spheres of varying reflectiveness lit from the top left. </summary>
+/// <returns> The default scene. </returns>
+Scenes::Scene Scenes::Scene::Default()
+{
+	Scene scene;
+
+	scene.AddSphere(glm::vec3(0, 0, 0), 6.0f, Shapes::ShapeProperties(Colour::Red(), 0.5f));
+
+	scene.AddSphere(glm::vec3(-8, 0, -8), 2.5f, Shapes::ShapeProperties::MatteGrey());
+
+	scene.AddSphere(glm::vec3(-5.5f, -10, -8), 2.5f, Shapes::ShapeProperties(Colour(255, 215, 0), 0));
+
+	scene.AddSphere(glm::vec3(0, 9, -15), 1.75f, Shapes::ShapeProperties(Colour(255, 0, 255), 0));
+
+	scene.AddSphere(glm::vec3(8, 8, -8), 5.0f, Shapes::ShapeProperties(Colour::Green(), 0.85f));
+
+	scene.AddSphere(glm::vec3(-20, 9.5f, 25), 20.0f, Shapes::ShapeProperties(Colour(235, 243, 246), 0.35f));
+
+	return scene;
+}
\ No newline at end of file
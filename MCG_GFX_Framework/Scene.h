@@ -0,0 +1,97 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+// Framework includes.
+#include <glm.hpp>
+
+// Data includes.
+#include "ShapeProperties.h"
+#include "PointLight.h"
+
+// Utility includes.
+#include <vector>
+#include <unordered_map>
+
+// Typedef includes.
+#include <stdint.h>
+#include <cmath>
+
+namespace Scenes
+{
+	/// <summary> Represents where a scene is viewed from. </summary>
+	struct SceneCamera
+	{
+		/// <summary> Creates a camera at the given position looking at the given point. </summary>
+		/// <param name="_position"> The position of the camera within the world. </param>
+		/// <param name="_lookAt"> The point the camera looks at. </param>
+		/// <param name="_fieldOfView"> The vertical field of view in degrees. Defaults to <c>45</c>. </param>
+		SceneCamera(const glm::vec3 _position, const glm::vec3 _lookAt, const float_t _fieldOfView = 45.0f) : m_position(_position), m_lookAt(_lookAt), m_fieldOfView(_fieldOfView) { }
+
+		/// <summary> The position of the camera within the world. </summary>
+		glm::vec3 m_position;
+
+		/// <summary> The point the camera looks at. </summary>
+		glm::vec3 m_lookAt;
+
+		/// <summary> The vertical field of view in degrees. </summary>
+		float_t m_fieldOfView;
+
+		/// <summary> Finds if the camera can be viewed through. </summary>
+		/// <returns> <c>true</c> if the field of view is between <c>0</c> and <c>180</c> degrees; otherwise, <c>false</c>. </returns>
+		inline bool IsValid() const { return m_fieldOfView > 0 && m_fieldOfView < 180; }
+	};
+
+	/// <summary> Represents a sphere within a scene, which refers to its surface by index rather than holding a copy. </summary>
+	struct SceneSphere
+	{
+		/// <summary> The centre of the sphere. </summary>
+		glm::vec3 m_centre;
+
+		/// <summary> The radius of the sphere. </summary>
+		float_t m_radius;
+
+		/// <summary> The index of the sphere's surface within the scene's materials. </summary>
+		uint32_t m_material;
+
+		/// <summary> Finds if the sphere has a size, not counting its material. </summary>
+		/// <returns> <c>true</c> if the radius is above <c>0</c>; otherwise, <c>false</c>. </returns>
+		inline bool IsValid() const { return m_radius > 0; }
+	};
+
+	/// <summary> Represents everything needed to create a world: the camera, the light, the materials, and the spheres. </summary>
+	struct Scene
+	{
+		/// <summary> Creates an empty scene with the default camera and light. </summary>
+		Scene() : m_camera(glm::vec3(0, 0, -50), glm::vec3(0, 0, 0)), m_light(glm::vec3(-20, 0, -20), 2.0f, Colour(94, 85, 64)), m_materials(), m_spheres(), m_materialIndices() { }
+
+		/// <summary> Where the scene is viewed from. </summary>
+		SceneCamera m_camera;
+
+		/// <summary> The source of light. </summary>
+		PointLight m_light;
+
+		/// <summary> Every distinct surface, referred to by index from each sphere. </summary>
+		std::vector<Shapes::ShapeProperties> m_materials;
+
+		/// <summary> Every sphere. </summary>
+		std::vector<SceneSphere> m_spheres;
+
+		/// <summary> The index of each material added by <see cref="AddSphere"/>, which is checked against the table before it is reused, as the table may also be filled directly. </summary>
+		std::unordered_map<Shapes::ShapeProperties, uint32_t, Shapes::ShapePropertiesHash> m_materialIndices;
+
+		/// <summary> Adds a sphere with the given surface, reusing a matching material if there is one. </summary>
+		/// <param name="_centre"> The centre of the sphere. </param>
+		/// <param name="_radius"> The radius of the sphere. </param>
+		/// <param name="_properties"> The surface of the sphere. </param>
+		inline void AddSphere(const glm::vec3 _centre, const float_t _radius, const Shapes::ShapeProperties& _properties)
+		{
+			std::unordered_map<Shapes::ShapeProperties, uint32_t, Shapes::ShapePropertiesHash>::const_iterator found = m_materialIndices.find(_properties);
+			uint32_t material = (found != m_materialIndices.end() && found->second < m_materials.size() && m_materials[found->second] == _properties) ? found->second : (uint32_t)m_materials.size();
+			if (material == m_materials.size()) { m_materialIndices[_properties] = material; m_materials.push_back(_properties); }
+			m_spheres.push_back({ _centre, _radius, material });
+		}
+
+		static Scene Default();
+	};
+}
+#endif
\ No newline at end of file
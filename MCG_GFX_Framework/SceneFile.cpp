@@ -0,0 +1,242 @@
+#include "SceneFile.h"
+
+// Data includes.
+#include "MappedScene.h"
+
+// Utility includes.
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <iomanip>
+
+namespace
+{
+	/// <summary> Parses a colour channel from the given stream. </summary>
+	/// <param name="io_stream"> The stream to read from. </param>
+	/// <param name="o_channel"> The channel. </param>
+	/// <returns> <c>true</c> if a whole number from <c>0</c> to <c>255</c> was read; otherwise, <c>false</c>. </returns>
+	bool readChannel(std::istream& io_stream, uint8_t& o_channel)
+	{
+		int32_t value;
+		if (!(io_stream >> value) || value < 0 || value > 255) { return false; }
+		o_channel = (uint8_t)value;
+		return true;
+	}
+}
+
+/// <summary> The eight bytes at the start of every binary scene. </summary>
+const char Scenes::SceneFile::BinaryMagic[8] = { 'M', 'C', 'G', 'S', 'C', 'E', 'N', 'E' };
+
+/// <summary> Loads the scene from the given file, telling text and binary scenes apart by the magic bytes at the start. </summary>
+/// <param name="_path"> The path of the file. </param>
+/// <param name="o_scene"> The loaded scene, which is replaced. </param>
+/// <param name="o_error"> The reason the scene could not be loaded, if it could not. </param>
+/// <returns> <c>true</c> if the whole scene was loaded; otherwise, <c>false</c>. </returns>
+bool Scenes::SceneFile::Load(const std::string& _path, Scene& o_scene, std::string& o_error)
+{
+	std::ifstream file(_path, std::ios::binary);
+	if (!file) { o_error = "Could not open " + _path; return false; }
+
+	// Check the start against the magic bytes.
+	char magic[sizeof(BinaryMagic)] = {};
+	file.read(magic, sizeof(magic));
+	bool isBinary = file.gcount() == sizeof(magic) && memcmp(magic, BinaryMagic, sizeof(magic)) == 0;
+	uint32_t version = 0;
+	if (isBinary) { file.read((char*)&version, sizeof(version)); }
+	file.clear();
+	file.seekg(0, std::ios::beg);
+
+	// Binary scenes are mapped, checked in full as copying out reads every sphere anyway, then copied out.
+	if (isBinary)
+	{
+		if (version != MappedScene::Version) { o_error = "Unsupported binary scene version " + std::to_string(version); return false; }
+		MappedScene mappedScene;
+		if (!mappedScene.Open(_path, o_error) || !mappedScene.Validate(o_error)) { return false; }
+		mappedScene.CopyTo(o_scene);
+		return true;
+	}
+
+	o_scene = Scene();
+	return loadText(file, o_scene, o_error);
+}
+
+/// <summary> Saves the given scene to the given file in the given format. </summary>
+/// <param name="_scene"> The scene to save. </param>
+/// <param name="_path"> The path of the file, which is replaced if it exists. </param>
+/// <param name="_format"> The format of the file. </param>
+/// <param name="_withHierarchy"> Whether a binary scene should hold a hierarchy built over its spheres, so that it can be traced as soon as it is mapped. </param>
+/// <returns> <c>true</c> if the whole file was written; otherwise, <c>false</c>. </returns>
+bool Scenes::SceneFile::Save(const Scene& _scene, const std::string& _path, const SceneFormat _format, const bool _withHierarchy)
+{
+	std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+	if (!file) { return false; }
+	return (_format == SceneFormat::Binary) ? saveBinary(_scene, file, _withHierarchy) : saveText(_scene, file);
+}
+
+/// <summary> Finds the format of a scene from the extension of the given path, <c>.scene</c> for text and <c>.sceneb</c> for binary. </summary>
+/// <param name="_path"> The path. </param>
+/// <param name="o_format"> The format, if the extension is known. </param>
+/// <returns> <c>true</c> if the extension is known; otherwise, <c>false</c>. </returns>
+bool Scenes::SceneFile::FormatFromPath(const std::string& _path, SceneFormat& o_format)
+{
+	// Get the extension in lower case.
+	size_t dot = _path.find_last_of('.');
+	if (dot == std::string::npos) { return false; }
+	std::string extension = _path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char _character) { return (char)tolower(_character); });
+
+	if (extension == "scene" || extension == "txt") { o_format = SceneFormat::Text; return true; }
+	if (extension == "sceneb") { o_format = SceneFormat::Binary; return true; }
+	return false;
+}
+
+/// <summary> Parses a text scene from the given stream, line by line. </summary>
+/// <param name="io_stream"> The stream, at the start of the scene. </param>
+/// <param name="o_scene"> The scene, which should be empty. </param>
+/// <param name="o_error"> The line that could not be parsed and why, if one could not. </param>
+/// <returns> <c>true</c> if every line was parsed; otherwise, <c>false</c>. </returns>
+bool Scenes::SceneFile::loadText(std::istream& io_stream, Scene& o_scene, std::string& o_error)
+{
+	std::unordered_map<std::string, uint32_t> materialIndices;
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(io_stream, line); lineNumber++)
+	{
+		// Skip comments and blank lines.
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) { line.erase(comment); }
+		std::istringstream command(line);
+		std::string name;
+		if (!(command >> name)) { continue; }
+
+		// Read the command's values, stopping at the first that is missing or invalid.
+		bool isValid;
+		if (name == "camera")
+		{
+			SceneCamera& camera = o_scene.m_camera;
+			isValid = (bool)(command >> camera.m_position.x >> camera.m_position.y >> camera.m_position.z >> camera.m_lookAt.x >> camera.m_lookAt.y >> camera.m_lookAt.z);
+			if (isValid && !(command >> camera.m_fieldOfView)) { camera.m_fieldOfView = 45.0f; command.clear(); }
+			isValid &= camera.IsValid();
+		}
+		else if (name == "light")
+		{
+			PointLight& light = o_scene.m_light;
+			isValid = (command >> light.m_position.x >> light.m_position.y >> light.m_position.z >> light.m_intensity) && readChannel(command, light.m_colour.r) && readChannel(command, light.m_colour.g) && readChannel(command, light.m_colour.b);
+		}
+		else if (name == "material")
+		{
+			std::string materialName;
+			Shapes::ShapeProperties properties;
+			isValid = (command >> materialName) && readChannel(command, properties.m_colour.r) && readChannel(command, properties.m_colour.g) && readChannel(command, properties.m_colour.b) && (command >> properties.m_reflectiveness);
+			if (isValid && !materialIndices.emplace(materialName, (uint32_t)o_scene.m_materials.size()).second) { o_error = "Line " + std::to_string(lineNumber) + ": material \"" + materialName + "\" is already defined"; return false; }
+			if (isValid) { o_scene.m_materials.push_back(properties); }
+		}
+		else if (name == "sphere")
+		{
+			SceneSphere sphere;
+			std::string materialName;
+			isValid = (bool)(command >> sphere.m_centre.x >> sphere.m_centre.y >> sphere.m_centre.z >> sphere.m_radius >> materialName) && sphere.IsValid();
+			std::unordered_map<std::string, uint32_t>::const_iterator material = materialIndices.find(materialName);
+			if (isValid && material == materialIndices.end()) { o_error = "Line " + std::to_string(lineNumber) + ": unknown material \"" + materialName + "\""; return false; }
+			if (isValid) { sphere.m_material = material->second; o_scene.m_spheres.push_back(sphere); }
+		}
+		else { o_error = "Line " + std::to_string(lineNumber) + ": unknown command \"" + name + "\""; return false; }
+
+		// Anything left over is as wrong as anything missing.
+		std::string extra;
+		if (!isValid || (command >> extra)) { o_error = "Line " + std::to_string(lineNumber) + ": invalid " + name; return false; }
+	}
+
+	return true;
+}
+
+/// <summary> Writes the given scene to the given stream as text, naming each material after its index. </summary>
+/// <param name="_scene"> The scene to write. </param>
+/// <param name="io_stream"> The stream. </param>
+/// <returns> <c>true</c> if the whole scene was written; otherwise, <c>false</c>. </returns>
+bool Scenes::SceneFile::saveText(const Scene& _scene, std::ostream& io_stream)
+{
+	// Write every float with enough digits to be read back exactly.
+	io_stream << std::setprecision(9);
+
+	const SceneCamera& camera = _scene.m_camera;
+	io_stream << "camera " << camera.m_position.x << " " << camera.m_position.y << " " << camera.m_position.z << " " << camera.m_lookAt.x << " " << camera.m_lookAt.y << " " << camera.m_lookAt.z << " " << camera.m_fieldOfView << "\n";
+
+	const PointLight& light = _scene.m_light;
+	io_stream << "light " << light.m_position.x << " " << light.m_position.y << " " << light.m_position.z << " " << light.m_intensity << " " << (int)light.m_colour.r << " " << (int)light.m_colour.g << " " << (int)light.m_colour.b << "\n";
+
+	for (size_t i = 0; i < _scene.m_materials.size(); i++)
+	{
+		const Shapes::ShapeProperties& material = _scene.m_materials[i];
+		io_stream << "material m" << i << " " << (int)material.m_colour.r << " " << (int)material.m_colour.g << " " << (int)material.m_colour.b << " " << material.m_reflectiveness << "\n";
+	}
+
+	for (const SceneSphere& sphere : _scene.m_spheres) { io_stream << "sphere " << sphere.m_centre.x << " " << sphere.m_centre.y << " " << sphere.m_centre.z << " " << sphere.m_radius << " m" << sphere.m_material << "\n"; }
+
+	return (bool)io_stream;
+}
+
+/// <summary> Writes the given scene to the given stream in the binary format, laid out to be mapped by <see cref="MappedScene"/>. </summary>
+/// <param name="_scene"> The scene to write. </param>
+/// <param name="io_stream"> The stream, which must be opened in binary mode. </param>
+/// <param name="_withHierarchy"> Whether to build a hierarchy over the spheres and save it with them. </param>
+/// <returns> <c>true</c> if the whole scene was written; otherwise, <c>false</c>. </returns>
+bool Scenes::SceneFile::saveBinary(const Scene& _scene, std::ostream& io_stream, const bool _withHierarchy)
+{
+	// Lay the spheres out exactly as a world would, building the hierarchy over them if asked to.
+	std::vector<Shapes::Sphere> sceneSpheres;
+	sceneSpheres.reserve(_scene.m_spheres.size());
+	for (const SceneSphere& sphere : _scene.m_spheres) { sceneSpheres.push_back(Shapes::Sphere(sphere.m_centre, sphere.m_radius, _scene.m_materials[sphere.m_material])); }
+	Shapes::SphereSet spheres(sceneSpheres);
+	Shapes::BoundingVolumeHierarchy hierarchy;
+	if (_withHierarchy) { hierarchy.Build(spheres); }
+
+	// Fill in the header.
+	MappedSceneHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, BinaryMagic, sizeof(BinaryMagic));
+	header.m_version = BinaryVersion;
+	header.m_materialCount = (uint32_t)spheres.GetMaterials().size();
+	header.m_sphereCount = spheres.GetCount();
+	header.m_nodeCount = hierarchy.GetNodeCount();
+
+	const SceneCamera& camera = _scene.m_camera;
+	const float_t cameraValues[7] = { camera.m_position.x, camera.m_position.y, camera.m_position.z, camera.m_lookAt.x, camera.m_lookAt.y, camera.m_lookAt.z, camera.m_fieldOfView };
+	memcpy(header.m_camera, cameraValues, sizeof(cameraValues));
+
+	const PointLight& light = _scene.m_light;
+	const float_t lightValues[4] = { light.m_position.x, light.m_position.y, light.m_position.z, light.m_intensity };
+	memcpy(header.m_light, lightValues, sizeof(lightValues));
+	header.m_lightColour[0] = light.m_colour.r;
+	header.m_lightColour[1] = light.m_colour.g;
+	header.m_lightColour[2] = light.m_colour.b;
+
+	const Shapes::BuildStats& buildStats = hierarchy.GetBuildStats();
+	header.m_buildMethod[0] = (uint8_t)buildStats.m_method;
+	header.m_leafCount = buildStats.m_leafCount;
+	header.m_buildCost = buildStats.m_cost;
+	uint64_t fileSize = MappedScene::Layout(header.m_sphereCount, header.m_materialCount, header.m_nodeCount, header.m_sectionOffsets);
+
+	// Convert the material table.
+	std::vector<BinaryMaterial> materials;
+	for (const Shapes::ShapeProperties& properties : spheres.GetMaterials()) { materials.push_back({ { properties.m_colour.r, properties.m_colour.g, properties.m_colour.b, 0 }, properties.m_reflectiveness }); }
+
+	// Write each section at its offset, padding the gaps between them with zeroes.
+	Shapes::SphereArrays arrays = spheres.GetArrays();
+	uint64_t paddedCount = (uint64_t)header.m_sphereCount + Shapes::SphereSet::LaneCount;
+	const void* sections[(size_t)MappedSection::Count] = { arrays.m_centreX, arrays.m_centreY, arrays.m_centreZ, arrays.m_radiusSquared, arrays.m_radius, arrays.m_materialIndex, arrays.m_originalIndex, materials.data(), hierarchy.GetNodes() };
+	const uint64_t sectionSizes[(size_t)MappedSection::Count] = { paddedCount * sizeof(float_t), paddedCount * sizeof(float_t), paddedCount * sizeof(float_t), paddedCount * sizeof(float_t), paddedCount * sizeof(float_t), paddedCount * sizeof(uint32_t), paddedCount * sizeof(uint32_t), materials.size() * sizeof(BinaryMaterial), (uint64_t)header.m_nodeCount * sizeof(Shapes::BoundingVolumeHierarchy::Node) };
+	const char zeroes[MappedScene::SectionAlignment] = {};
+
+	io_stream.write((const char*)&header, sizeof(header));
+	uint64_t offset = sizeof(header);
+	for (size_t section = 0; section < (size_t)MappedSection::Count; section++)
+	{
+		io_stream.write(zeroes, (std::streamsize)(header.m_sectionOffsets[section] - offset));
+		if (sectionSizes[section] > 0) { io_stream.write((const char*)sections[section], (std::streamsize)sectionSizes[section]); }
+		offset = header.m_sectionOffsets[section] + sectionSizes[section];
+	}
+
+	return (bool)io_stream && offset == fileSize;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+// Data includes.
+#include "Scene.h"
+
+// Utility includes.
+#include <string>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Scenes
+{
+	/// <summary> The file formats a scene can be stored as. </summary>
+	enum class SceneFormat : uint8_t
+	{
+		/// <summary> One command per line, which can be written by hand. </summary>
+		Text,
+
+		/// <summary> A fixed header followed by each array of the spheres, the materials, and a prebuilt hierarchy, laid out so that it can be mapped and traced straight from the file. </summary>
+		Binary
+	};
+
+	/// <summary> Reads and writes scenes. </summary>
+	/// <remarks>
+	/// The text format has one command per line, with anything after a <c>#</c> ignored:
+	/// <c>camera px py pz lx ly lz [fov]</c>, <c>light x y z intensity r g b</c>, <c>material name r g b reflectiveness</c>, and <c>sphere x y z radius material</c>.
+	/// Colours are from <c>0</c> to <c>255</c>, and a material must be defined before any sphere that uses it.
+	/// </remarks>
+	class SceneFile
+	{
+	public:
+		/// <summary> The eight bytes at the start of every binary scene. </summary>
+		static const char BinaryMagic[8];
+
+		/// <summary> The version of the binary format written, which is laid out to be mapped by <see cref="MappedScene"/>. </summary>
+		static const uint32_t BinaryVersion = 2;
+
+		static bool Load(const std::string&, Scene&, std::string&);
+
+		static bool Save(const Scene&, const std::string&, SceneFormat, bool _withHierarchy = true);
+
+		static bool FormatFromPath(const std::string&, SceneFormat&);
+	private:
+		static bool loadText(std::istream&, Scene&, std::string&);
+
+		static bool saveText(const Scene&, std::ostream&);
+
+		static bool saveBinary(const Scene&, std::ostream&, bool);
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "SceneGenerator.h"
+
+// Utility includes.
+#include <random>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	/// <summary> Generates random numbers the same way on every platform, which the standard distributions do not promise. </summary>
+	class Random
+	{
+	public:
+		/// <summary> Creates a generator from the given seed. </summary>
+		/// <param name="_seed"> The seed. </param>
+		Random(const uint32_t _seed) : m_engine(_seed) { }
+
+		/// <summary> Gets a number from <c>0</c> up to but not including <c>1</c>. </summary>
+		/// <returns> The number, using the top 24 bits of the engine so every value is exact. </returns>
+		inline float_t Next() { return (float_t)(m_engine() >> 8) * (1.0f / 16777216.0f); }
+
+		/// <summary> Gets a number within the given range. </summary>
+		/// <param name="_min"> The smallest number. </param>
+		/// <param name="_max"> The number that is never quite reached. </param>
+		/// <returns> The number. </returns>
+		inline float_t Range(const float_t _min, const float_t _max) { return _min + (_max - _min) * Next(); }
+
+		/// <summary> Gets a whole number from <c>0</c> up to but not including the given count. </summary>
+		/// <param name="_count"> The number of possible values. </param>
+		/// <returns> The number. </returns>
+		inline uint32_t Below(const uint32_t _count) { return (uint32_t)(((uint64_t)m_engine() * _count) >> 32); }
+	private:
+		/// <summary> The engine, whose output is fully defined by the standard. </summary>
+		std::mt19937 m_engine;
+	};
+
+	/// <summary> Adds the given number of random materials to the given scene. </summary>
+	/// <param name="io_scene"> The scene. </param>
+	/// <param name="io_random"> The random number generator. </param>
+	/// <param name="_count"> The number of materials to add. </param>
+	/// <param name="_minReflectiveness"> The least reflective a material may be. </param>
+	/// <param name="_maxReflectiveness"> The most reflective a material may be. </param>
+	/// <returns> The index of the first added material. </returns>
+	uint32_t addPalette(Scenes::Scene& io_scene, Random& io_random, const uint32_t _count, const float_t _minReflectiveness, const float_t _maxReflectiveness)
+	{
+		uint32_t first = (uint32_t)io_scene.m_materials.size();
+		for (uint32_t i = 0; i < _count; i++)
+		{
+			Colour colour((uint8_t)(40 + io_random.Below(216)), (uint8_t)(40 + io_random.Below(216)), (uint8_t)(40 + io_random.Below(216)));
+			io_scene.m_materials.push_back(Shapes::ShapeProperties(colour, io_random.Range(_minReflectiveness, _maxReflectiveness)));
+		}
+		return first;
+	}
+
+	/// <summary> Finds the smallest whole number whose cube is at least the given count. </summary>
+	/// <param name="_count"> The count. </param>
+	/// <returns> The cube root, rounded up. </returns>
+	uint32_t cubeRootCeiling(const uint32_t _count)
+	{
+		uint32_t root = (uint32_t)std::cbrt((double)_count);
+		while ((uint64_t)root * root * root < _count) { root++; }
+		return root;
+	}
+
+	/// <summary> Scatters spheres through a cube sized so that there is one sphere for every 64 cubic units, seen from in front. </summary>
+	/// <param name="io_scene"> The scene to fill. </param>
+	/// <param name="_count"> The number of spheres. </param>
+	/// <param name="io_random"> The random number generator. </param>
+	void generateRandomField(Scenes::Scene& io_scene, const uint32_t _count, Random& io_random)
+	{
+		const uint32_t materialCount = 8;
+		addPalette(io_scene, io_random, materialCount, 0.0f, 0.8f);
+
+		float_t halfSide = 2.0f * (float_t)std::cbrt((double)_count);
+		io_scene.m_spheres.reserve(_count);
+		for (uint32_t i = 0; i < _count; i++)
+		{
+			glm::vec3 centre(io_random.Range(-halfSide, halfSide), io_random.Range(-halfSide, halfSide), io_random.Range(-halfSide, halfSide));
+			float_t radius = io_random.Range(0.4f, 1.6f);
+			io_scene.m_spheres.push_back({ centre, radius, io_random.Below(materialCount) });
+		}
+
+		io_scene.m_camera = Scenes::SceneCamera(glm::vec3(0, 0, -halfSide * 2.2f - 10), glm::vec3(0, 0, 0));
+		io_scene.m_light.m_position = glm::vec3(-halfSide * 2, halfSide, -halfSide * 2);
+	}
+
+	/// <summary> Packs equal spheres into a cubic lattice, filling it a row at a time, seen from above one corner. </summary>
+	/// <param name="io_scene"> The scene to fill. </param>
+	/// <param name="_count"> The number of spheres. </param>
+	/// <param name="io_random"> The random number generator, which only picks the colours. </param>
+	void generateGrid(Scenes::Scene& io_scene, const uint32_t _count, Random& io_random)
+	{
+		const uint32_t materialCount = 6;
+		addPalette(io_scene, io_random, materialCount, 0.0f, 0.5f);
+
+		const float_t spacing = 3.0f;
+		uint32_t side = cubeRootCeiling(_count);
+		float_t halfExtent = (side - 1) * spacing * 0.5f;
+		io_scene.m_spheres.reserve(_count);
+		for (uint32_t i = 0; i < _count; i++)
+		{
+			uint32_t x = i % side, y = (i / side) % side, z = i / (side * side);
+			glm::vec3 centre(x * spacing - halfExtent, y * spacing - halfExtent, z * spacing - halfExtent);
+			io_scene.m_spheres.push_back({ centre, 1.0f, (x + y + z) % materialCount });
+		}
+
+		float_t distance = halfExtent * 2.6f + 15;
+		io_scene.m_camera = Scenes::SceneCamera(glm::normalize(glm::vec3(-0.6f, 0.5f, -1)) * distance, glm::vec3(0, 0, 0));
+		io_scene.m_light.m_position = glm::vec3(-distance, distance, -distance * 0.5f);
+	}
+
+	/// <summary> Grows the sphereflake a generation at a time from a single sphere, stopping as soon as there are enough spheres. </summary>
+	/// <param name="io_scene"> The scene to fill. </param>
+	/// <param name="_count"> The number of spheres. </param>
+	/// <param name="io_random"> The random number generator, which picks the colours and twists each set of children. </param>
+	void generateSphereflake(Scenes::Scene& io_scene, const uint32_t _count, Random& io_random)
+	{
+		// Give each generation its own colour, all fairly shiny.
+		const uint32_t materialCount = 5;
+		addPalette(io_scene, io_random, materialCount, 0.4f, 0.8f);
+
+		// The axis of each sphere points away from its parent, and its children are spread around it.
+		std::vector<glm::vec3> axes;
+		std::vector<uint8_t> generations;
+		axes.reserve(_count);
+		generations.reserve(_count);
+		io_scene.m_spheres.reserve(_count);
+		io_scene.m_spheres.push_back({ glm::vec3(0, 0, 0), 8.0f, 0 });
+		axes.push_back(glm::vec3(0, 1, 0));
+		generations.push_back(0);
+
+		for (uint32_t parent = 0; io_scene.m_spheres.size() < _count; parent++)
+		{
+			// Find two directions at right angles to the axis.
+			Scenes::SceneSphere parentSphere = io_scene.m_spheres[parent];
+			glm::vec3 axis = axes[parent];
+			glm::vec3 side = glm::normalize(glm::cross((glm::abs(axis.y) < 0.9f) ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0), axis));
+			glm::vec3 up = glm::cross(axis, side);
+			float_t twist = io_random.Range(0.0f, glm::radians(360.0f));
+
+			// Place six children around the middle and three around the top, each touching the parent.
+			float_t childRadius = parentSphere.m_radius / 3.0f;
+			for (uint32_t child = 0; child < 9 && io_scene.m_spheres.size() < _count; child++)
+			{
+				float_t elevation = (child < 6) ? 0.0f : glm::radians(60.0f);
+				float_t azimuth = twist + ((child < 6) ? child * glm::radians(60.0f) : (child - 6) * glm::radians(120.0f) + glm::radians(30.0f));
+				glm::vec3 direction = std::cos(elevation) * (std::cos(azimuth) * side + std::sin(azimuth) * up) + std::sin(elevation) * axis;
+
+				uint8_t generation = (uint8_t)(generations[parent] + 1);
+				io_scene.m_spheres.push_back({ parentSphere.m_centre + direction * (parentSphere.m_radius + childRadius), childRadius, generation % materialCount });
+				axes.push_back(direction);
+				generations.push_back(generation);
+			}
+		}
+
+		io_scene.m_camera = Scenes::SceneCamera(glm::vec3(0, 14, -42), glm::vec3(0, 2, 0));
+		io_scene.m_light.m_position = glm::vec3(-25, 30, -20);
+	}
+
+	/// <summary> Builds two facing walls of overlapping mirrored spheres with a quarter of the spheres scattered between them, seen from one end at an angle so rays bounce between the walls. </summary>
+	/// <param name="io_scene"> The scene to fill. </param>
+	/// <param name="_count"> The number of spheres. </param>
+	/// <param name="io_random"> The random number generator. </param>
+	void generateMirrors(Scenes::Scene& io_scene, const uint32_t _count, Random& io_random)
+	{
+		io_scene.m_materials.push_back(Shapes::ShapeProperties(Colour(235, 235, 240), 0.95f));
+		const uint32_t materialCount = 6;
+		uint32_t firstColour = addPalette(io_scene, io_random, materialCount, 0.0f, 0.3f);
+
+		// Split the spheres between the walls and the space between them.
+		uint32_t middleCount = std::max(1u, _count / 4), wallCount = _count - middleCount;
+		uint32_t columns = (uint32_t)std::ceil(std::sqrt((double)((wallCount + 1) / 2)));
+		const float_t spacing = 2.0f;
+		float_t halfExtent = std::max(columns * spacing * 0.5f, 6.0f), halfWidth = std::max(halfExtent * 0.25f, 4.0f);
+
+		// Fill each wall a row at a time, the spheres overlapping so that the wall is almost flat.
+		io_scene.m_spheres.reserve(_count);
+		for (uint32_t i = 0; i < wallCount; i++)
+		{
+			uint32_t cell = i / 2;
+			float_t y = (cell % columns) * spacing - halfExtent + spacing * 0.5f, z = (cell / columns) * spacing - halfExtent + spacing * 0.5f;
+			io_scene.m_spheres.push_back({ glm::vec3((i % 2 == 0) ? -halfWidth - 1 : halfWidth + 1, y, z), 1.25f, 0 });
+		}
+
+		// Scatter coloured spheres between the walls.
+		for (uint32_t i = 0; i < middleCount; i++)
+		{
+			glm::vec3 centre(io_random.Range(-halfWidth + 1.5f, halfWidth - 1.5f), io_random.Range(-halfExtent, halfExtent) * 0.8f, io_random.Range(-halfExtent, halfExtent) * 0.8f);
+			io_scene.m_spheres.push_back({ centre, io_random.Range(0.4f, 1.2f), firstColour + io_random.Below(materialCount) });
+		}
+
+		io_scene.m_camera = Scenes::SceneCamera(glm::vec3(0, 0, -halfExtent - halfWidth), glm::vec3(halfWidth * 0.6f, 0, 0), 60.0f);
+		io_scene.m_light.m_position = glm::vec3(0, halfExtent * 0.3f, -halfExtent * 0.3f);
+	}
+
+	/// <summary> Packs tiny spheres into a cube a fiftieth of a unit across at the origin, which the default camera sees as less than a pixel when a thousand pixels tall. </summary>
+	/// <param name="io_scene"> The scene to fill. </param>
+	/// <param name="_count"> The number of spheres. </param>
+	/// <param name="io_random"> The random number generator. </param>
+	void generateSubPixel(Scenes::Scene& io_scene, const uint32_t _count, Random& io_random)
+	{
+		const uint32_t materialCount = 4;
+		addPalette(io_scene, io_random, materialCount, 0.0f, 0.5f);
+
+		// Size the spheres so that they fill around a tenth of the cube, however many there are.
+		const float_t halfSide = 0.01f;
+		float_t radius = 0.6f * halfSide / (float_t)std::cbrt((double)_count);
+		io_scene.m_spheres.reserve(_count);
+		for (uint32_t i = 0; i < _count; i++)
+		{
+			glm::vec3 centre(io_random.Range(-halfSide, halfSide), io_random.Range(-halfSide, halfSide), io_random.Range(-halfSide, halfSide));
+			io_scene.m_spheres.push_back({ centre, radius, io_random.Below(materialCount) });
+		}
+	}
+}
+
+/// <summary> Generates a scene of the given kind and size. </summary>
+/// <param name="_type"> The kind of scene. </param>
+/// <param name="_sphereCount"> The number of spheres, from <c>1</c> to <see cref="MaxSphereCount"/>. </param>
+/// <param name="_seed"> The seed for every random choice. Defaults to <c>1</c>. </param>
+/// <returns> The generated scene, with a camera and light placed to see it. </returns>
+Scenes::Scene Scenes::SceneGenerator::Generate(const GeneratorType _type, const uint32_t _sphereCount, const uint32_t _seed)
+{
+	Scene scene;
+	Random random(_seed);
+	uint32_t sphereCount = glm::clamp(_sphereCount, 1u, MaxSphereCount);
+
+	switch (_type)
+	{
+	case GeneratorType::RandomField: generateRandomField(scene, sphereCount, random); break;
+	case GeneratorType::Grid: generateGrid(scene, sphereCount, random); break;
+	case GeneratorType::Sphereflake: generateSphereflake(scene, sphereCount, random); break;
+	case GeneratorType::Mirrors: generateMirrors(scene, sphereCount, random); break;
+	case GeneratorType::SubPixel: generateSubPixel(scene, sphereCount, random); break;
+	default: break;
+	}
+
+	return scene;
+}
+
+/// <summary> Finds the kind of scene with the given name, as used on the command line. </summary>
+/// <param name="_name"> The name, such as <c>grid</c>. </param>
+/// <param name="o_type"> The kind of scene, if the name is known. </param>
+/// <returns> <c>true</c> if the name is known; otherwise, <c>false</c>. </returns>
+bool Scenes::SceneGenerator::TypeFromName(const std::string& _name, GeneratorType& o_type)
+{
+	for (uint8_t type = 0; type < (uint8_t)GeneratorType::Count; type++)
+	{
+		if (_name == GetName((GeneratorType)type)) { o_type = (GeneratorType)type; return true; }
+	}
+	return false;
+}
+
+/// <summary> Gets the name of the given kind of scene. </summary>
+/// <param name="_type"> The kind of scene. </param>
+/// <returns> The name in lower case. </returns>
+const char* Scenes::SceneGenerator::GetName(const GeneratorType _type)
+{
+	switch (_type)
+	{
+	case GeneratorType::RandomField: return "random";
+	case GeneratorType::Grid: return "grid";
+	case GeneratorType::Sphereflake: return "sphereflake";
+	case GeneratorType::Mirrors: return "mirrors";
+	case GeneratorType::SubPixel: return "subpixel";
+	default: return "unknown";
+	}
+}
\ No newline at end of file
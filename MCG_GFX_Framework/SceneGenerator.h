@@ -0,0 +1,52 @@
+#ifndef SCENEGENERATOR_H
+#define SCENEGENERATOR_H
+
+// Data includes.
+#include "Scene.h"
+
+// Utility includes.
+#include <string>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Scenes
+{
+	/// <summary> The kinds of scene that can be generated. </summary>
+	enum class GeneratorType : uint8_t
+	{
+		/// <summary> Spheres of random sizes and materials scattered through a cube, which grows with the count so the density stays the same. </summary>
+		RandomField,
+
+		/// <summary> Equal spheres packed into a cubic lattice. </summary>
+		Grid,
+
+		/// <summary> The sphereflake fractal, where nine spheres a third of the size sit on the surface of each sphere. </summary>
+		Sphereflake,
+
+		/// <summary> Two facing walls of mirrored spheres with coloured spheres between them, so that rays reflect as deeply as they are allowed to. </summary>
+		Mirrors,
+
+		/// <summary> Tiny spheres packed into a cube smaller than a single pixel in the middle of the screen. </summary>
+		SubPixel,
+
+		/// <summary> The number of kinds. </summary>
+		Count
+	};
+
+	/// <summary> Generates scenes of any size for measuring how the renderer scales. </summary>
+	/// <remarks> The same kind, count, and seed always generate the same scene, as the random numbers do not depend on the standard library's distributions. </remarks>
+	class SceneGenerator
+	{
+	public:
+		static Scene Generate(GeneratorType, uint32_t, uint32_t _seed = 1);
+
+		static bool TypeFromName(const std::string&, GeneratorType&);
+
+		static const char* GetName(GeneratorType);
+
+		/// <summary> The most spheres that can be generated. </summary>
+		static const uint32_t MaxSphereCount = 1u << 25;
+	};
+}
+#endif
\ No newline at end of file
@@ -4,8 +4,12 @@
 // Data includes.
 #include "Colour.h"
 
+// Utility includes.
+#include <functional>
+
 // Typedef includes.
 #include <cmath>
+#include <stddef.h>
 
 namespace Shapes
 {
@@ -30,6 +34,11 @@ namespace Shapes
 		/// <summary> How reflective the object is. </summary>
 		float_t m_reflectiveness;
 
+		/// <summary> Compares these properties. </summary>
+		/// <param name="_other"> The other properties with which to compare. </param>
+		/// <returns> <c>true</c> if the colour and reflectiveness are the same; otherwise, <c>false</c>. </returns>
+		inline bool operator==(const ShapeProperties& _other) const { return m_colour == _other.m_colour && m_reflectiveness == _other.m_reflectiveness; }
+
 		/// <summary> A non-reflective black. </summary>
 		static ShapeProperties MatteBlack() { return ShapeProperties(Colour::Black(), 0); }
 
@@ -40,5 +49,18 @@ namespace Shapes
 		/// <summary> Fully reflective. </summary>
 		static ShapeProperties Shiny() { return ShapeProperties(Colour::White(), 1); }
 	};
+
+	/// <summary> Hashes shape properties, so that a material table can be searched without comparing against every entry. </summary>
+	struct ShapePropertiesHash
+	{
+		/// <summary> Hashes the given properties, giving equal properties the same hash. </summary>
+		/// <param name="_properties"> The properties. </param>
+		/// <returns> The hash. </returns>
+		inline size_t operator()(const ShapeProperties& _properties) const
+		{
+			size_t colour = ((size_t)_properties.m_colour.r << 16) | ((size_t)_properties.m_colour.g << 8) | (size_t)_properties.m_colour.b;
+			return std::hash<float_t>()(_properties.m_reflectiveness) ^ (colour * 0x9E3779B1u);
+		}
+	};
 }
 #endif
\ No newline at end of file
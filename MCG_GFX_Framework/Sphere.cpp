@@ -3,24 +3,31 @@
 // Framework includes.
 #include <gtx/norm.hpp>
 
-/// <summary> Calculates the colour of a certain point on the sphere. </summary>
+/// <summary> Calculates the radiance of a certain point on the sphere. </summary>
 /// <param name="_intersection"> The point on the sphere for which to calculate the colour. </param>
 /// <param name="_normal"> The pre-calculated normal from the centre of the sphere to the intersection point. </param>
 /// <param name="_lightSource"> The light source to check against. </param>
-/// <returns> The calculated colour on the given intersection point on this sphere. </returns>
-Colour Shapes::Sphere::Shade(const glm::vec3 _intersection, const glm::vec3 _normal, const PointLight _lightSource) const
+/// <returns> The calculated radiance on the given intersection point on this sphere, which may be brighter than <c>1</c>. </returns>
+glm::vec3 Shapes::Sphere::Shade(const glm::vec3 _intersection, const glm::vec3 _normal, const PointLight _lightSource) const
 {
 	// Calulate the direction from the intersection point to the light source.
 	glm::vec3 directionToLight = glm::normalize(_lightSource.m_position - _intersection);
 
 	// Calculate the scalar for the light intensity based off the dot product of the normal and the direction towards the light.
-	float_t facingAmount = glm::dot(_normal, directionToLight);
+	return Shade(glm::dot(_normal, directionToLight), _lightSource);
+}
 
+/// <summary> Calculates the radiance of a point on the sphere that faces the light by the given amount. </summary>
+/// <param name="_facingAmount"> The dot product of the normal and the direction towards the light, such as one found for many points at once. </param>
+/// <param name="_lightSource"> The light source to check against. </param>
+/// <returns> The calculated radiance, which may be brighter than <c>1</c>. </returns>
+glm::vec3 Shapes::Sphere::Shade(const float_t _facingAmount, const PointLight _lightSource) const
+{
 	// If the facing is 0 or lower, just return black.
-	if (facingAmount <= 0.0f) { return Colour::Black(); }
+	if (_facingAmount <= 0.0f) { return glm::vec3(0.0f); }
 
-	// Calculate and return the final colour.
-	return m_properties.m_colour * _lightSource.m_colour * facingAmount * _lightSource.m_intensity;
+	// Calculate and return the final radiance, without rounding or clamping.
+	return m_properties.m_colour.ToScalar() * _lightSource.m_colour.ToScalar() * (_facingAmount * _lightSource.m_intensity);
 }
 
 /// <summary> Finds if the given ray intersects with this sphere. </summary>
@@ -37,7 +37,9 @@ namespace Shapes
 		/// <summary> The properties of the sphere. </summary>
 		ShapeProperties m_properties;
 
-		Colour Shade(glm::vec3, glm::vec3, PointLight) const;
+		glm::vec3 Shade(glm::vec3, glm::vec3, PointLight) const;
+
+		glm::vec3 Shade(float_t, PointLight) const;
 
 		SphereIntersection RayIntersects(Ray) const;
 	};
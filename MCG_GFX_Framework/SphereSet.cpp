@@ -0,0 +1,612 @@
+#include "SphereSet.h"
+
+// SIMD includes.
+#if defined(__AVX2__)
+#define SPHERESET_AVX2
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SPHERESET_SSE2
+#include <emmintrin.h>
+#endif
+
+// Utility includes.
+#include <unordered_map>
+
+/// <summary> Creates a set holding a copy of each of the given spheres. </summary>
+/// <param name="_spheres"> The spheres to copy. </param>
+Shapes::SphereSet::SphereSet(const std::vector<Sphere>& _spheres) : m_count((uint32_t)_spheres.size()), m_mapped(), m_mapping()
+{
+	// Make room for every sphere and the padding.
+	m_centreX.reserve(m_count + LaneCount);
+	m_centreY.reserve(m_count + LaneCount);
+	m_centreZ.reserve(m_count + LaneCount);
+	m_radiusSquared.reserve(m_count + LaneCount);
+	m_radius.reserve(m_count + LaneCount);
+	m_materialIndex.reserve(m_count + LaneCount);
+	m_originalIndex.reserve(m_count + LaneCount);
+	m_setIndex.reserve(m_count);
+
+	// Look up each sphere's properties by hash, so that building stays linear however many materials there are.
+	std::unordered_map<ShapeProperties, uint32_t, ShapePropertiesHash> materialIndices;
+	for (uint32_t i = 0; i < m_count; i++)
+	{
+		const Sphere& sphere = _spheres[i];
+
+		// Split the sphere into each array.
+		m_centreX.push_back(sphere.m_centre.x);
+		m_centreY.push_back(sphere.m_centre.y);
+		m_centreZ.push_back(sphere.m_centre.z);
+		m_radiusSquared.push_back(sphere.m_radius * sphere.m_radius);
+		m_radius.push_back(sphere.m_radius);
+
+		// Find the properties in the material table, adding them if they are new.
+		std::pair<std::unordered_map<ShapeProperties, uint32_t, ShapePropertiesHash>::iterator, bool> material = materialIndices.emplace(sphere.m_properties, (uint32_t)m_materials.size());
+		if (material.second) { m_materials.push_back(sphere.m_properties); }
+		m_materialIndex.push_back(material.first->second);
+		m_originalIndex.push_back(i);
+		m_setIndex.push_back(i);
+	}
+
+	// Add the padding to the end.
+	pad();
+}
+
+/// <summary> Creates a set that uses arrays held elsewhere, such as within a mapped scene file, rather than copying them. </summary>
+/// <remarks> The set cannot be reordered, and its spheres cannot be moved. </remarks>
+/// <param name="_count"> The number of spheres, not including padding. </param>
+/// <param name="_arrays"> The arrays, each with a full vector of padding past the end. </param>
+/// <param name="_materials"> The material table, which is small enough to copy. </param>
+/// <param name="_mapping"> Whatever holds the arrays, which is kept alive for as long as the set uses them. </param>
+Shapes::SphereSet::SphereSet(const uint32_t _count, const SphereArrays& _arrays, const std::vector<ShapeProperties>& _materials, std::shared_ptr<const void> _mapping)
+	: m_count(_count), m_materials(_materials), m_mapped(_arrays), m_mapping(std::move(_mapping)) { }
+
+/// <summary> Reorders the spheres so that the sphere at each index is the one that was at the given index. </summary>
+/// <param name="_order"> The index each sphere is taken from, which must hold every index exactly once. </param>
+void Shapes::SphereSet::Reorder(const std::vector<uint32_t>& _order)
+{
+	// Copy each array in the new order, keeping the padding at the end.
+	std::vector<float_t> centreX(m_centreX), centreY(m_centreY), centreZ(m_centreZ), radiusSquared(m_radiusSquared), radius(m_radius);
+	std::vector<uint32_t> materialIndex(m_materialIndex), originalIndex(m_originalIndex);
+	for (uint32_t i = 0; i < m_count; i++)
+	{
+		uint32_t from = _order[i];
+		centreX[i] = m_centreX[from];
+		centreY[i] = m_centreY[from];
+		centreZ[i] = m_centreZ[from];
+		radiusSquared[i] = m_radiusSquared[from];
+		radius[i] = m_radius[from];
+		materialIndex[i] = m_materialIndex[from];
+		originalIndex[i] = m_originalIndex[from];
+	}
+
+	// Swap the reordered arrays in.
+	m_centreX.swap(centreX);
+	m_centreY.swap(centreY);
+	m_centreZ.swap(centreZ);
+	m_radiusSquared.swap(radiusSquared);
+	m_radius.swap(radius);
+	m_materialIndex.swap(materialIndex);
+	m_originalIndex.swap(originalIndex);
+
+	// Point each original index at where its sphere now is.
+	for (uint32_t i = 0; i < m_count; i++) { m_setIndex[m_originalIndex[i]] = i; }
+}
+
+/// <summary> Moves and resizes the given sphere, keeping its surface properties. </summary>
+/// <param name="_index"> The index of the sphere within the set. </param>
+/// <param name="_centre"> The new centre position. </param>
+/// <param name="_radius"> The new radius. </param>
+void Shapes::SphereSet::Move(const uint32_t _index, const glm::vec3& _centre, const float_t _radius)
+{
+	m_centreX[_index] = _centre.x;
+	m_centreY[_index] = _centre.y;
+	m_centreZ[_index] = _centre.z;
+	m_radiusSquared[_index] = _radius * _radius;
+	m_radius[_index] = _radius;
+}
+
+/// <summary> Finds the closest sphere within the given range hit by the given ray, testing several spheres at once. </summary>
+/// <param name="_ray"> The ray, with a normalised direction. </param>
+/// <param name="_begin"> The index of the first sphere to test. </param>
+/// <param name="_end"> The index after the last sphere to test. </param>
+/// <param name="io_hit"> The closest hit, only hits closer than its current distance are counted. </param>
+/// <param name="_ignoreIndex"> The index of a sphere to skip, such as the one a ray is leaving. </param>
+/// <returns> <c>true</c> if a closer sphere was hit; otherwise, <c>false</c>. </returns>
+/// <remarks> Matches <see cref="Sphere::RayIntersects"/>, so rays starting inside a sphere or pointing away from its centre do not hit it. </remarks>
+bool Shapes::SphereSet::IntersectClosest(const Ray& _ray, const uint32_t _begin, const uint32_t _end, SphereHit& io_hit, const uint32_t _ignoreIndex) const
+{
+	// Keep track of the closest distance and index found.
+	const SphereArrays arrays = GetArrays();
+	uint32_t closestIndex = UINT32_MAX;
+	float_t closestDistance = io_hit.m_distance;
+
+#if defined(SPHERESET_AVX2)
+	// Spread the ray over every lane.
+	const __m256 originX = _mm256_set1_ps(_ray.m_origin.x), originY = _mm256_set1_ps(_ray.m_origin.y), originZ = _mm256_set1_ps(_ray.m_origin.z);
+	const __m256 directionX = _mm256_set1_ps(_ray.m_direction.x), directionY = _mm256_set1_ps(_ray.m_direction.y), directionZ = _mm256_set1_ps(_ray.m_direction.z);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256i endIndex = _mm256_set1_epi32((int32_t)_end), ignoreIndex = _mm256_set1_epi32((int32_t)_ignoreIndex), laneStep = _mm256_set1_epi32(8);
+
+	// Keep track of the closest distance and index within each lane.
+	__m256 bestDistance = _mm256_set1_ps(closestDistance);
+	__m256i bestIndex = _mm256_set1_epi32(-1);
+	__m256i laneIndex = _mm256_setr_epi32(_begin, _begin + 1, _begin + 2, _begin + 3, _begin + 4, _begin + 5, _begin + 6, _begin + 7);
+
+	for (uint32_t i = _begin; i < _end; i += 8)
+	{
+		// Calculate the direction towards each centre from the ray's origin, and how far along the ray each centre is.
+		__m256 toCentreX = _mm256_sub_ps(_mm256_loadu_ps(&arrays.m_centreX[i]), originX);
+		__m256 toCentreY = _mm256_sub_ps(_mm256_loadu_ps(&arrays.m_centreY[i]), originY);
+		__m256 toCentreZ = _mm256_sub_ps(_mm256_loadu_ps(&arrays.m_centreZ[i]), originZ);
+		__m256 toCentreSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, toCentreX), _mm256_mul_ps(toCentreY, toCentreY)), _mm256_mul_ps(toCentreZ, toCentreZ));
+		__m256 sphereRayDot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, directionX), _mm256_mul_ps(toCentreY, directionY)), _mm256_mul_ps(toCentreZ, directionZ));
+
+		// Calculate the squared half-length of the chord through each sphere, which is negative on a miss, then the distance to the first intersection.
+		__m256 radiusSquared = _mm256_loadu_ps(&arrays.m_radiusSquared[i]);
+		__m256 chordSquared = _mm256_sub_ps(radiusSquared, _mm256_sub_ps(toCentreSquared, _mm256_mul_ps(sphereRayDot, sphereRayDot)));
+		__m256 distance = _mm256_sub_ps(sphereRayDot, _mm256_sqrt_ps(_mm256_max_ps(chordSquared, zero)));
+
+		// A lane hits if the ray starts outside, points towards the centre, passes within the radius, is closer than the best, and is a sphere in range that is not ignored.
+		__m256 hitMask = _mm256_and_ps(_mm256_cmp_ps(toCentreSquared, radiusSquared, _CMP_GE_OQ), _mm256_cmp_ps(sphereRayDot, zero, _CMP_GT_OQ));
+		hitMask = _mm256_and_ps(hitMask, _mm256_and_ps(_mm256_cmp_ps(chordSquared, zero, _CMP_GE_OQ), _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ)));
+		__m256i validLane = _mm256_andnot_si256(_mm256_cmpeq_epi32(laneIndex, ignoreIndex), _mm256_cmpgt_epi32(endIndex, laneIndex));
+		hitMask = _mm256_and_ps(hitMask, _mm256_castsi256_ps(validLane));
+
+		// Keep the closer hits.
+		bestDistance = _mm256_blendv_ps(bestDistance, distance, hitMask);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(laneIndex), hitMask));
+		laneIndex = _mm256_add_epi32(laneIndex, laneStep);
+	}
+
+	// Find the closest hit across the lanes, preferring the lowest index on a tie.
+	float_t distances[8]; int32_t indices[8];
+	_mm256_storeu_ps(distances, bestDistance);
+	_mm256_storeu_si256((__m256i*)indices, bestIndex);
+	for (uint32_t lane = 0; lane < 8; lane++)
+	{
+		if (indices[lane] >= 0 && (distances[lane] < closestDistance || (distances[lane] == closestDistance && (uint32_t)indices[lane] < closestIndex))) { closestDistance = distances[lane]; closestIndex = (uint32_t)indices[lane]; }
+	}
+#elif defined(SPHERESET_SSE2)
+	// Spread the ray over every lane.
+	const __m128 originX = _mm_set1_ps(_ray.m_origin.x), originY = _mm_set1_ps(_ray.m_origin.y), originZ = _mm_set1_ps(_ray.m_origin.z);
+	const __m128 directionX = _mm_set1_ps(_ray.m_direction.x), directionY = _mm_set1_ps(_ray.m_direction.y), directionZ = _mm_set1_ps(_ray.m_direction.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i endIndex = _mm_set1_epi32((int32_t)_end), ignoreIndex = _mm_set1_epi32((int32_t)_ignoreIndex), laneStep = _mm_set1_epi32(4);
+
+	// Keep track of the closest distance and index within each lane.
+	__m128 bestDistance = _mm_set1_ps(closestDistance);
+	__m128i bestIndex = _mm_set1_epi32(-1);
+	__m128i laneIndex = _mm_setr_epi32(_begin, _begin + 1, _begin + 2, _begin + 3);
+
+	for (uint32_t i = _begin; i < _end; i += 4)
+	{
+		// Calculate the direction towards each centre from the ray's origin, and how far along the ray each centre is.
+		__m128 toCentreX = _mm_sub_ps(_mm_loadu_ps(&arrays.m_centreX[i]), originX);
+		__m128 toCentreY = _mm_sub_ps(_mm_loadu_ps(&arrays.m_centreY[i]), originY);
+		__m128 toCentreZ = _mm_sub_ps(_mm_loadu_ps(&arrays.m_centreZ[i]), originZ);
+		__m128 toCentreSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, toCentreX), _mm_mul_ps(toCentreY, toCentreY)), _mm_mul_ps(toCentreZ, toCentreZ));
+		__m128 sphereRayDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, directionX), _mm_mul_ps(toCentreY, directionY)), _mm_mul_ps(toCentreZ, directionZ));
+
+		// Calculate the squared half-length of the chord through each sphere, which is negative on a miss, then the distance to the first intersection.
+		__m128 radiusSquared = _mm_loadu_ps(&arrays.m_radiusSquared[i]);
+		__m128 chordSquared = _mm_sub_ps(radiusSquared, _mm_sub_ps(toCentreSquared, _mm_mul_ps(sphereRayDot, sphereRayDot)));
+		__m128 distance = _mm_sub_ps(sphereRayDot, _mm_sqrt_ps(_mm_max_ps(chordSquared, zero)));
+
+		// A lane hits if the ray starts outside, points towards the centre, passes within the radius, is closer than the best, and is a sphere in range that is not ignored.
+		__m128 hitMask = _mm_and_ps(_mm_cmpge_ps(toCentreSquared, radiusSquared), _mm_cmpgt_ps(sphereRayDot, zero));
+		hitMask = _mm_and_ps(hitMask, _mm_and_ps(_mm_cmpge_ps(chordSquared, zero), _mm_cmplt_ps(distance, bestDistance)));
+		__m128i validLane = _mm_andnot_si128(_mm_cmpeq_epi32(laneIndex, ignoreIndex), _mm_cmplt_epi32(laneIndex, endIndex));
+		hitMask = _mm_and_ps(hitMask, _mm_castsi128_ps(validLane));
+
+		// Keep the closer hits.
+		bestDistance = _mm_or_ps(_mm_and_ps(hitMask, distance), _mm_andnot_ps(hitMask, bestDistance));
+		__m128i hitIndexMask = _mm_castps_si128(hitMask);
+		bestIndex = _mm_or_si128(_mm_and_si128(hitIndexMask, laneIndex), _mm_andnot_si128(hitIndexMask, bestIndex));
+		laneIndex = _mm_add_epi32(laneIndex, laneStep);
+	}
+
+	// Find the closest hit across the lanes, preferring the lowest index on a tie.
+	float_t distances[4]; int32_t indices[4];
+	_mm_storeu_ps(distances, bestDistance);
+	_mm_storeu_si128((__m128i*)indices, bestIndex);
+	for (uint32_t lane = 0; lane < 4; lane++)
+	{
+		if (indices[lane] >= 0 && (distances[lane] < closestDistance || (distances[lane] == closestDistance && (uint32_t)indices[lane] < closestIndex))) { closestDistance = distances[lane]; closestIndex = (uint32_t)indices[lane]; }
+	}
+#else
+	// Without SIMD, test each sphere in turn with the same maths as the kernel.
+	for (uint32_t i = _begin; i < _end; i++)
+	{
+		if (i == _ignoreIndex) { continue; }
+
+		glm::vec3 toCentre = GetCentre(i) - _ray.m_origin;
+		float_t toCentreSquared = glm::dot(toCentre, toCentre);
+		float_t sphereRayDot = glm::dot(toCentre, _ray.m_direction);
+		float_t chordSquared = arrays.m_radiusSquared[i] - (toCentreSquared - sphereRayDot * sphereRayDot);
+		if (toCentreSquared < arrays.m_radiusSquared[i] || sphereRayDot <= 0 || chordSquared < 0) { continue; }
+
+		float_t distance = sphereRayDot - glm::sqrt(chordSquared);
+		if (distance < closestDistance) { closestDistance = distance; closestIndex = i; }
+	}
+#endif
+
+	// If nothing closer was hit, leave the given hit as it was.
+	if (closestIndex == UINT32_MAX) { return false; }
+
+	io_hit.m_index = closestIndex;
+	io_hit.m_distance = closestDistance;
+	return true;
+}
+
+/// <summary> Finds if the given ray hits any sphere within the given range before the given distance, stopping at the first group of spheres with a hit. </summary>
+/// <param name="_ray"> The ray, with a normalised direction. </param>
+/// <param name="_begin"> The index of the first sphere to test. </param>
+/// <param name="_end"> The index after the last sphere to test. </param>
+/// <param name="_maxDistance"> The distance along the ray beyond which hits are not counted. </param>
+/// <param name="o_index"> The index of a hit sphere, which is not necessarily the closest. </param>
+/// <param name="_ignoreIndex"> The index of a sphere to skip, such as the one a ray is leaving. </param>
+/// <returns> <c>true</c> if any sphere was hit; otherwise, <c>false</c>. </returns>
+bool Shapes::SphereSet::IntersectAny(const Ray& _ray, const uint32_t _begin, const uint32_t _end, const float_t _maxDistance, uint32_t& o_index, const uint32_t _ignoreIndex) const
+{
+	const SphereArrays arrays = GetArrays();
+
+#if defined(SPHERESET_AVX2)
+	// Spread the ray over every lane.
+	const __m256 originX = _mm256_set1_ps(_ray.m_origin.x), originY = _mm256_set1_ps(_ray.m_origin.y), originZ = _mm256_set1_ps(_ray.m_origin.z);
+	const __m256 directionX = _mm256_set1_ps(_ray.m_direction.x), directionY = _mm256_set1_ps(_ray.m_direction.y), directionZ = _mm256_set1_ps(_ray.m_direction.z);
+	const __m256 zero = _mm256_setzero_ps(), maxDistance = _mm256_set1_ps(_maxDistance);
+	const __m256i endIndex = _mm256_set1_epi32((int32_t)_end), ignoreIndex = _mm256_set1_epi32((int32_t)_ignoreIndex), laneStep = _mm256_set1_epi32(8);
+	__m256i laneIndex = _mm256_setr_epi32(_begin, _begin + 1, _begin + 2, _begin + 3, _begin + 4, _begin + 5, _begin + 6, _begin + 7);
+
+	for (uint32_t i = _begin; i < _end; i += 8)
+	{
+		// Calculate the direction towards each centre from the ray's origin, and how far along the ray each centre is.
+		__m256 toCentreX = _mm256_sub_ps(_mm256_loadu_ps(&arrays.m_centreX[i]), originX);
+		__m256 toCentreY = _mm256_sub_ps(_mm256_loadu_ps(&arrays.m_centreY[i]), originY);
+		__m256 toCentreZ = _mm256_sub_ps(_mm256_loadu_ps(&arrays.m_centreZ[i]), originZ);
+		__m256 toCentreSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, toCentreX), _mm256_mul_ps(toCentreY, toCentreY)), _mm256_mul_ps(toCentreZ, toCentreZ));
+		__m256 sphereRayDot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, directionX), _mm256_mul_ps(toCentreY, directionY)), _mm256_mul_ps(toCentreZ, directionZ));
+
+		// Calculate the squared half-length of the chord through each sphere, then the distance to the first intersection.
+		__m256 radiusSquared = _mm256_loadu_ps(&arrays.m_radiusSquared[i]);
+		__m256 chordSquared = _mm256_sub_ps(radiusSquared, _mm256_sub_ps(toCentreSquared, _mm256_mul_ps(sphereRayDot, sphereRayDot)));
+		__m256 distance = _mm256_sub_ps(sphereRayDot, _mm256_sqrt_ps(_mm256_max_ps(chordSquared, zero)));
+
+		// A lane hits under the same rules as the closest hit, but only needs to be before the maximum distance.
+		__m256 hitMask = _mm256_and_ps(_mm256_cmp_ps(toCentreSquared, radiusSquared, _CMP_GE_OQ), _mm256_cmp_ps(sphereRayDot, zero, _CMP_GT_OQ));
+		hitMask = _mm256_and_ps(hitMask, _mm256_and_ps(_mm256_cmp_ps(chordSquared, zero, _CMP_GE_OQ), _mm256_cmp_ps(distance, maxDistance, _CMP_LT_OQ)));
+		__m256i validLane = _mm256_andnot_si256(_mm256_cmpeq_epi32(laneIndex, ignoreIndex), _mm256_cmpgt_epi32(endIndex, laneIndex));
+		int32_t hitLanes = _mm256_movemask_ps(_mm256_and_ps(hitMask, _mm256_castsi256_ps(validLane)));
+
+		// Stop at the first lane that hit.
+		if (hitLanes != 0)
+		{
+			uint32_t lane = 0;
+			while ((hitLanes & (1 << lane)) == 0) { lane++; }
+			o_index = i + lane;
+			return true;
+		}
+		laneIndex = _mm256_add_epi32(laneIndex, laneStep);
+	}
+#elif defined(SPHERESET_SSE2)
+	// Spread the ray over every lane.
+	const __m128 originX = _mm_set1_ps(_ray.m_origin.x), originY = _mm_set1_ps(_ray.m_origin.y), originZ = _mm_set1_ps(_ray.m_origin.z);
+	const __m128 directionX = _mm_set1_ps(_ray.m_direction.x), directionY = _mm_set1_ps(_ray.m_direction.y), directionZ = _mm_set1_ps(_ray.m_direction.z);
+	const __m128 zero = _mm_setzero_ps(), maxDistance = _mm_set1_ps(_maxDistance);
+	const __m128i endIndex = _mm_set1_epi32((int32_t)_end), ignoreIndex = _mm_set1_epi32((int32_t)_ignoreIndex), laneStep = _mm_set1_epi32(4);
+	__m128i laneIndex = _mm_setr_epi32(_begin, _begin + 1, _begin + 2, _begin + 3);
+
+	for (uint32_t i = _begin; i < _end; i += 4)
+	{
+		// Calculate the direction towards each centre from the ray's origin, and how far along the ray each centre is.
+		__m128 toCentreX = _mm_sub_ps(_mm_loadu_ps(&arrays.m_centreX[i]), originX);
+		__m128 toCentreY = _mm_sub_ps(_mm_loadu_ps(&arrays.m_centreY[i]), originY);
+		__m128 toCentreZ = _mm_sub_ps(_mm_loadu_ps(&arrays.m_centreZ[i]), originZ);
+		__m128 toCentreSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, toCentreX), _mm_mul_ps(toCentreY, toCentreY)), _mm_mul_ps(toCentreZ, toCentreZ));
+		__m128 sphereRayDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, directionX), _mm_mul_ps(toCentreY, directionY)), _mm_mul_ps(toCentreZ, directionZ));
+
+		// Calculate the squared half-length of the chord through each sphere, then the distance to the first intersection.
+		__m128 radiusSquared = _mm_loadu_ps(&arrays.m_radiusSquared[i]);
+		__m128 chordSquared = _mm_sub_ps(radiusSquared, _mm_sub_ps(toCentreSquared, _mm_mul_ps(sphereRayDot, sphereRayDot)));
+		__m128 distance = _mm_sub_ps(sphereRayDot, _mm_sqrt_ps(_mm_max_ps(chordSquared, zero)));
+
+		// A lane hits under the same rules as the closest hit, but only needs to be before the maximum distance.
+		__m128 hitMask = _mm_and_ps(_mm_cmpge_ps(toCentreSquared, radiusSquared), _mm_cmpgt_ps(sphereRayDot, zero));
+		hitMask = _mm_and_ps(hitMask, _mm_and_ps(_mm_cmpge_ps(chordSquared, zero), _mm_cmplt_ps(distance, maxDistance)));
+		__m128i validLane = _mm_andnot_si128(_mm_cmpeq_epi32(laneIndex, ignoreIndex), _mm_cmplt_epi32(laneIndex, endIndex));
+		int32_t hitLanes = _mm_movemask_ps(_mm_and_ps(hitMask, _mm_castsi128_ps(validLane)));
+
+		// Stop at the first lane that hit.
+		if (hitLanes != 0)
+		{
+			uint32_t lane = 0;
+			while ((hitLanes & (1 << lane)) == 0) { lane++; }
+			o_index = i + lane;
+			return true;
+		}
+		laneIndex = _mm_add_epi32(laneIndex, laneStep);
+	}
+#else
+	// Without SIMD, test each sphere in turn with the same maths as the kernel, stopping at the first hit.
+	for (uint32_t i = _begin; i < _end; i++)
+	{
+		if (i == _ignoreIndex) { continue; }
+
+		glm::vec3 toCentre = GetCentre(i) - _ray.m_origin;
+		float_t toCentreSquared = glm::dot(toCentre, toCentre);
+		float_t sphereRayDot = glm::dot(toCentre, _ray.m_direction);
+		float_t chordSquared = arrays.m_radiusSquared[i] - (toCentreSquared - sphereRayDot * sphereRayDot);
+		if (toCentreSquared < arrays.m_radiusSquared[i] || sphereRayDot <= 0 || chordSquared < 0) { continue; }
+
+		if (sphereRayDot - glm::sqrt(chordSquared) < _maxDistance) { o_index = i; return true; }
+	}
+#endif
+
+	return false;
+}
+
+/// <summary> Finds the closest sphere within the given range hit by each ray of the given packet, testing one sphere against several rays at once. </summary>
+/// <param name="io_packet"> The rays, whose hits are only replaced by closer hits. </param>
+/// <param name="_begin"> The index of the first sphere to test. </param>
+/// <param name="_end"> The index after the last sphere to test. </param>
+/// <param name="_laneMask"> A bit for each ray to test, the hits of any others are left as they are. </param>
+/// <returns> <c>true</c> if any ray hit a closer sphere; otherwise, <c>false</c>. </returns>
+/// <remarks> Uses exactly the same maths as the single ray kernels, so a ray tested against the same spheres finds the same hit whether it is traced alone or in a packet. </remarks>
+bool Shapes::SphereSet::IntersectClosest(RayPacket& io_packet, const uint32_t _begin, const uint32_t _end, const uint32_t _laneMask) const
+{
+	// A single ray is quicker through its own kernel, which tests several spheres at once instead.
+	if (RayPacket::CountLanes(_laneMask) == 1)
+	{
+		uint32_t lane = 0;
+		while ((_laneMask & (1u << lane)) == 0) { lane++; }
+		SphereHit hit;
+		hit.m_index = io_packet.m_index[lane];
+		hit.m_distance = io_packet.m_distance[lane];
+		if (!IntersectClosest(io_packet.GetRay(lane), _begin, _end, hit)) { return false; }
+		io_packet.m_index[lane] = hit.m_index;
+		io_packet.m_distance[lane] = hit.m_distance;
+		return true;
+	}
+
+	const SphereArrays arrays = GetArrays();
+	bool didHit = false;
+
+#if defined(SPHERESET_AVX2)
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	for (uint32_t lane = 0; lane < io_packet.m_size; lane += 8)
+	{
+		// Skip any group of rays with nothing to test, and spread the bit of each ray over its lane.
+		uint32_t groupMask = (_laneMask >> lane) & 0xFF;
+		if (groupMask == 0) { continue; }
+		const __m256 testMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int32_t)groupMask), laneBits), laneBits));
+
+		// Load this group of rays along with their closest hits so far.
+		const __m256 originX = _mm256_loadu_ps(&io_packet.m_originX[lane]), originY = _mm256_loadu_ps(&io_packet.m_originY[lane]), originZ = _mm256_loadu_ps(&io_packet.m_originZ[lane]);
+		const __m256 directionX = _mm256_loadu_ps(&io_packet.m_directionX[lane]), directionY = _mm256_loadu_ps(&io_packet.m_directionY[lane]), directionZ = _mm256_loadu_ps(&io_packet.m_directionZ[lane]);
+		__m256 bestDistance = _mm256_loadu_ps(&io_packet.m_distance[lane]);
+		__m256i bestIndex = _mm256_loadu_si256((const __m256i*)&io_packet.m_index[lane]);
+		__m256 anyHit = zero;
+
+		for (uint32_t i = _begin; i < _end; i++)
+		{
+			// Calculate the direction towards the centre from each ray's origin, and how far along each ray the centre is.
+			__m256 toCentreX = _mm256_sub_ps(_mm256_set1_ps(arrays.m_centreX[i]), originX);
+			__m256 toCentreY = _mm256_sub_ps(_mm256_set1_ps(arrays.m_centreY[i]), originY);
+			__m256 toCentreZ = _mm256_sub_ps(_mm256_set1_ps(arrays.m_centreZ[i]), originZ);
+			__m256 toCentreSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, toCentreX), _mm256_mul_ps(toCentreY, toCentreY)), _mm256_mul_ps(toCentreZ, toCentreZ));
+			__m256 sphereRayDot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, directionX), _mm256_mul_ps(toCentreY, directionY)), _mm256_mul_ps(toCentreZ, directionZ));
+
+			// Calculate the squared half-length of the chord through the sphere along each ray, then the distance to the first intersection.
+			__m256 radiusSquared = _mm256_set1_ps(arrays.m_radiusSquared[i]);
+			__m256 chordSquared = _mm256_sub_ps(radiusSquared, _mm256_sub_ps(toCentreSquared, _mm256_mul_ps(sphereRayDot, sphereRayDot)));
+			__m256 distance = _mm256_sub_ps(sphereRayDot, _mm256_sqrt_ps(_mm256_max_ps(chordSquared, zero)));
+
+			// A lane hits under the same rules as a single ray, as long as it is being tested.
+			__m256 hitMask = _mm256_and_ps(_mm256_cmp_ps(toCentreSquared, radiusSquared, _CMP_GE_OQ), _mm256_cmp_ps(sphereRayDot, zero, _CMP_GT_OQ));
+			hitMask = _mm256_and_ps(hitMask, _mm256_and_ps(_mm256_cmp_ps(chordSquared, zero, _CMP_GE_OQ), _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ)));
+			hitMask = _mm256_and_ps(hitMask, testMask);
+
+			// Keep the closer hits.
+			bestDistance = _mm256_blendv_ps(bestDistance, distance, hitMask);
+			bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(_mm256_set1_epi32((int32_t)i)), hitMask));
+			anyHit = _mm256_or_ps(anyHit, hitMask);
+		}
+
+		_mm256_storeu_ps(&io_packet.m_distance[lane], bestDistance);
+		_mm256_storeu_si256((__m256i*)&io_packet.m_index[lane], bestIndex);
+		didHit |= _mm256_movemask_ps(anyHit) != 0;
+	}
+#elif defined(SPHERESET_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+	for (uint32_t lane = 0; lane < io_packet.m_size; lane += 4)
+	{
+		// Skip any group of rays with nothing to test, and spread the bit of each ray over its lane.
+		uint32_t groupMask = (_laneMask >> lane) & 0xF;
+		if (groupMask == 0) { continue; }
+		const __m128 testMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int32_t)groupMask), laneBits), laneBits));
+
+		// Load this group of rays along with their closest hits so far.
+		const __m128 originX = _mm_loadu_ps(&io_packet.m_originX[lane]), originY = _mm_loadu_ps(&io_packet.m_originY[lane]), originZ = _mm_loadu_ps(&io_packet.m_originZ[lane]);
+		const __m128 directionX = _mm_loadu_ps(&io_packet.m_directionX[lane]), directionY = _mm_loadu_ps(&io_packet.m_directionY[lane]), directionZ = _mm_loadu_ps(&io_packet.m_directionZ[lane]);
+		__m128 bestDistance = _mm_loadu_ps(&io_packet.m_distance[lane]);
+		__m128i bestIndex = _mm_loadu_si128((const __m128i*)&io_packet.m_index[lane]);
+		__m128 anyHit = zero;
+
+		for (uint32_t i = _begin; i < _end; i++)
+		{
+			// Calculate the direction towards the centre from each ray's origin, and how far along each ray the centre is.
+			__m128 toCentreX = _mm_sub_ps(_mm_set1_ps(arrays.m_centreX[i]), originX);
+			__m128 toCentreY = _mm_sub_ps(_mm_set1_ps(arrays.m_centreY[i]), originY);
+			__m128 toCentreZ = _mm_sub_ps(_mm_set1_ps(arrays.m_centreZ[i]), originZ);
+			__m128 toCentreSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, toCentreX), _mm_mul_ps(toCentreY, toCentreY)), _mm_mul_ps(toCentreZ, toCentreZ));
+			__m128 sphereRayDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, directionX), _mm_mul_ps(toCentreY, directionY)), _mm_mul_ps(toCentreZ, directionZ));
+
+			// Calculate the squared half-length of the chord through the sphere along each ray, then the distance to the first intersection.
+			__m128 radiusSquared = _mm_set1_ps(arrays.m_radiusSquared[i]);
+			__m128 chordSquared = _mm_sub_ps(radiusSquared, _mm_sub_ps(toCentreSquared, _mm_mul_ps(sphereRayDot, sphereRayDot)));
+			__m128 distance = _mm_sub_ps(sphereRayDot, _mm_sqrt_ps(_mm_max_ps(chordSquared, zero)));
+
+			// A lane hits under the same rules as a single ray, as long as it is being tested.
+			__m128 hitMask = _mm_and_ps(_mm_cmpge_ps(toCentreSquared, radiusSquared), _mm_cmpgt_ps(sphereRayDot, zero));
+			hitMask = _mm_and_ps(hitMask, _mm_and_ps(_mm_cmpge_ps(chordSquared, zero), _mm_cmplt_ps(distance, bestDistance)));
+			hitMask = _mm_and_ps(hitMask, testMask);
+
+			// Keep the closer hits.
+			bestDistance = _mm_or_ps(_mm_and_ps(hitMask, distance), _mm_andnot_ps(hitMask, bestDistance));
+			__m128i hitIndexMask = _mm_castps_si128(hitMask);
+			bestIndex = _mm_or_si128(_mm_and_si128(hitIndexMask, _mm_set1_epi32((int32_t)i)), _mm_andnot_si128(hitIndexMask, bestIndex));
+			anyHit = _mm_or_ps(anyHit, hitMask);
+		}
+
+		_mm_storeu_ps(&io_packet.m_distance[lane], bestDistance);
+		_mm_storeu_si128((__m128i*)&io_packet.m_index[lane], bestIndex);
+		didHit |= _mm_movemask_ps(anyHit) != 0;
+	}
+#else
+	// Without SIMD, test each ray against each sphere in turn with the same maths as the kernel.
+	for (uint32_t lane = 0; lane < io_packet.m_size; lane++)
+	{
+		if ((_laneMask & (1u << lane)) == 0) { continue; }
+		Ray ray = io_packet.GetRay(lane);
+		for (uint32_t i = _begin; i < _end; i++)
+		{
+			glm::vec3 toCentre = GetCentre(i) - ray.m_origin;
+			float_t toCentreSquared = glm::dot(toCentre, toCentre);
+			float_t sphereRayDot = glm::dot(toCentre, ray.m_direction);
+			float_t chordSquared = arrays.m_radiusSquared[i] - (toCentreSquared - sphereRayDot * sphereRayDot);
+			if (toCentreSquared < arrays.m_radiusSquared[i] || sphereRayDot <= 0 || chordSquared < 0) { continue; }
+
+			float_t distance = sphereRayDot - glm::sqrt(chordSquared);
+			if (distance < io_packet.m_distance[lane]) { io_packet.m_distance[lane] = distance; io_packet.m_index[lane] = i; didHit = true; }
+		}
+	}
+#endif
+
+	return didHit;
+}
+
+/// <summary> Finds which rays of the given packet hit any sphere within the given range before their distances, testing one sphere against several rays at once. </summary>
+/// <param name="_packet"> The rays, each holding the distance beyond which hits are not counted and the index of a sphere to skip in place of its hit. </param>
+/// <param name="_begin"> The index of the first sphere to test. </param>
+/// <param name="_end"> The index after the last sphere to test. </param>
+/// <param name="_laneMask"> A bit for each ray to test, such as those not yet known to be blocked. </param>
+/// <param name="o_index"> The index of a hit sphere, which is only set if any ray hit. </param>
+/// <returns> A bit for each of the tested rays that hit a sphere. </returns>
+/// <remarks> Uses exactly the same maths as the single ray kernels, and stops as soon as every tested ray in a group has hit. </remarks>
+uint32_t Shapes::SphereSet::IntersectAny(const RayPacket& _packet, const uint32_t _begin, const uint32_t _end, const uint32_t _laneMask, uint32_t& o_index) const
+{
+	// A single ray is quicker through its own kernel, which tests several spheres at once instead.
+	if (RayPacket::CountLanes(_laneMask) == 1)
+	{
+		uint32_t lane = 0;
+		while ((_laneMask & (1u << lane)) == 0) { lane++; }
+		return IntersectAny(_packet.GetRay(lane), _begin, _end, _packet.m_distance[lane], o_index, _packet.m_index[lane]) ? (1u << lane) : 0;
+	}
+
+	const SphereArrays arrays = GetArrays();
+	uint32_t hitLanes = 0;
+
+#if defined(SPHERESET_AVX2)
+	const __m256 zero = _mm256_setzero_ps();
+	for (uint32_t lane = 0; lane < _packet.m_size; lane += 8)
+	{
+		// Skip any group of rays with nothing left to test.
+		uint32_t groupMask = (_laneMask >> lane) & 0xFF, groupHits = 0;
+		if (groupMask == 0) { continue; }
+
+		// Load this group of rays along with how far each may go and which sphere each skips.
+		const __m256 originX = _mm256_loadu_ps(&_packet.m_originX[lane]), originY = _mm256_loadu_ps(&_packet.m_originY[lane]), originZ = _mm256_loadu_ps(&_packet.m_originZ[lane]);
+		const __m256 directionX = _mm256_loadu_ps(&_packet.m_directionX[lane]), directionY = _mm256_loadu_ps(&_packet.m_directionY[lane]), directionZ = _mm256_loadu_ps(&_packet.m_directionZ[lane]);
+		const __m256 maxDistance = _mm256_loadu_ps(&_packet.m_distance[lane]);
+		const __m256i ignoreIndex = _mm256_loadu_si256((const __m256i*)&_packet.m_index[lane]);
+
+		for (uint32_t i = _begin; i < _end && groupHits != groupMask; i++)
+		{
+			// Calculate the direction towards the centre from each ray's origin, and how far along each ray the centre is.
+			__m256 toCentreX = _mm256_sub_ps(_mm256_set1_ps(arrays.m_centreX[i]), originX);
+			__m256 toCentreY = _mm256_sub_ps(_mm256_set1_ps(arrays.m_centreY[i]), originY);
+			__m256 toCentreZ = _mm256_sub_ps(_mm256_set1_ps(arrays.m_centreZ[i]), originZ);
+			__m256 toCentreSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, toCentreX), _mm256_mul_ps(toCentreY, toCentreY)), _mm256_mul_ps(toCentreZ, toCentreZ));
+			__m256 sphereRayDot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCentreX, directionX), _mm256_mul_ps(toCentreY, directionY)), _mm256_mul_ps(toCentreZ, directionZ));
+
+			// Calculate the squared half-length of the chord through the sphere along each ray, then the distance to the first intersection.
+			__m256 radiusSquared = _mm256_set1_ps(arrays.m_radiusSquared[i]);
+			__m256 chordSquared = _mm256_sub_ps(radiusSquared, _mm256_sub_ps(toCentreSquared, _mm256_mul_ps(sphereRayDot, sphereRayDot)));
+			__m256 distance = _mm256_sub_ps(sphereRayDot, _mm256_sqrt_ps(_mm256_max_ps(chordSquared, zero)));
+
+			// A lane hits under the same rules as a single ray, unless this is the sphere it skips.
+			__m256 hitMask = _mm256_and_ps(_mm256_cmp_ps(toCentreSquared, radiusSquared, _CMP_GE_OQ), _mm256_cmp_ps(sphereRayDot, zero, _CMP_GT_OQ));
+			hitMask = _mm256_and_ps(hitMask, _mm256_and_ps(_mm256_cmp_ps(chordSquared, zero, _CMP_GE_OQ), _mm256_cmp_ps(distance, maxDistance, _CMP_LT_OQ)));
+			hitMask = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(ignoreIndex, _mm256_set1_epi32((int32_t)i))), hitMask);
+
+			uint32_t newHits = (uint32_t)_mm256_movemask_ps(hitMask) & groupMask & ~groupHits;
+			if (newHits != 0) { groupHits |= newHits; o_index = i; }
+		}
+		hitLanes |= groupHits << lane;
+	}
+#elif defined(SPHERESET_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	for (uint32_t lane = 0; lane < _packet.m_size; lane += 4)
+	{
+		// Skip any group of rays with nothing left to test.
+		uint32_t groupMask = (_laneMask >> lane) & 0xF, groupHits = 0;
+		if (groupMask == 0) { continue; }
+
+		// Load this group of rays along with how far each may go and which sphere each skips.
+		const __m128 originX = _mm_loadu_ps(&_packet.m_originX[lane]), originY = _mm_loadu_ps(&_packet.m_originY[lane]), originZ = _mm_loadu_ps(&_packet.m_originZ[lane]);
+		const __m128 directionX = _mm_loadu_ps(&_packet.m_directionX[lane]), directionY = _mm_loadu_ps(&_packet.m_directionY[lane]), directionZ = _mm_loadu_ps(&_packet.m_directionZ[lane]);
+		const __m128 maxDistance = _mm_loadu_ps(&_packet.m_distance[lane]);
+		const __m128i ignoreIndex = _mm_loadu_si128((const __m128i*)&_packet.m_index[lane]);
+
+		for (uint32_t i = _begin; i < _end && groupHits != groupMask; i++)
+		{
+			// Calculate the direction towards the centre from each ray's origin, and how far along each ray the centre is.
+			__m128 toCentreX = _mm_sub_ps(_mm_set1_ps(arrays.m_centreX[i]), originX);
+			__m128 toCentreY = _mm_sub_ps(_mm_set1_ps(arrays.m_centreY[i]), originY);
+			__m128 toCentreZ = _mm_sub_ps(_mm_set1_ps(arrays.m_centreZ[i]), originZ);
+			__m128 toCentreSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, toCentreX), _mm_mul_ps(toCentreY, toCentreY)), _mm_mul_ps(toCentreZ, toCentreZ));
+			__m128 sphereRayDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCentreX, directionX), _mm_mul_ps(toCentreY, directionY)), _mm_mul_ps(toCentreZ, directionZ));
+
+			// Calculate the squared half-length of the chord through the sphere along each ray, then the distance to the first intersection.
+			__m128 radiusSquared = _mm_set1_ps(arrays.m_radiusSquared[i]);
+			__m128 chordSquared = _mm_sub_ps(radiusSquared, _mm_sub_ps(toCentreSquared, _mm_mul_ps(sphereRayDot, sphereRayDot)));
+			__m128 distance = _mm_sub_ps(sphereRayDot, _mm_sqrt_ps(_mm_max_ps(chordSquared, zero)));
+
+			// A lane hits under the same rules as a single ray, unless this is the sphere it skips.
+			__m128 hitMask = _mm_and_ps(_mm_cmpge_ps(toCentreSquared, radiusSquared), _mm_cmpgt_ps(sphereRayDot, zero));
+			hitMask = _mm_and_ps(hitMask, _mm_and_ps(_mm_cmpge_ps(chordSquared, zero), _mm_cmplt_ps(distance, maxDistance)));
+			hitMask = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(ignoreIndex, _mm_set1_epi32((int32_t)i))), hitMask);
+
+			uint32_t newHits = (uint32_t)_mm_movemask_ps(hitMask) & groupMask & ~groupHits;
+			if (newHits != 0) { groupHits |= newHits; o_index = i; }
+		}
+		hitLanes |= groupHits << lane;
+	}
+#else
+	// Without SIMD, test each ray on its own with the single ray kernel.
+	for (uint32_t lane = 0; lane < _packet.m_size; lane++)
+	{
+		uint32_t index;
+		if ((_laneMask & (1u << lane)) != 0 && IntersectAny(_packet.GetRay(lane), _begin, _end, _packet.m_distance[lane], index, _packet.m_index[lane])) { hitLanes |= 1u << lane; o_index = index; }
+	}
+#endif
+
+	return hitLanes;
+}
+
+/// <summary> Adds a full vector of padding spheres past the end of each array. </summary>
+void Shapes::SphereSet::pad()
+{
+	for (uint32_t i = 0; i < LaneCount; i++)
+	{
+		m_centreX.push_back(0);
+		m_centreY.push_back(0);
+		m_centreZ.push_back(0);
+		m_radiusSquared.push_back(-1);
+		m_radius.push_back(0);
+		m_materialIndex.push_back(0);
+		m_originalIndex.push_back(UINT32_MAX);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#ifndef SPHERESET_H
+#define SPHERESET_H
+
+// Framework includes.
+#include <glm.hpp>
+
+// Data includes.
+#include "Sphere.h"
+#include "ShapeProperties.h"
+#include "Ray.h"
+#include "RayPacket.h"
+
+// Utility includes.
+#include <vector>
+#include <memory>
+
+// Typedef includes.
+#include <stdint.h>
+#include <cmath>
+
+namespace Shapes
+{
+	/// <summary> Represents the closest sphere hit by a ray. </summary>
+	struct SphereHit
+	{
+		/// <summary> Creates an empty hit with no sphere and an infinite distance. </summary>
+		SphereHit() : m_index(UINT32_MAX), m_distance(INFINITY) { }
+
+		/// <summary> The index of the hit sphere within the set, or <c>UINT32_MAX</c> if nothing was hit. </summary>
+		uint32_t m_index;
+
+		/// <summary> The distance along the ray to the first intersection. </summary>
+		float_t m_distance;
+	};
+
+	/// <summary> Represents a new position and size for a sphere that has moved. </summary>
+	struct SphereUpdate
+	{
+		/// <summary> Creates an update for the given sphere. </summary>
+		/// <param name="_index"> The index of the sphere within the list the set was created from. </param>
+		/// <param name="_centre"> The new centre position. </param>
+		/// <param name="_radius"> The new radius. </param>
+		SphereUpdate(const uint32_t _index, const glm::vec3& _centre, const float_t _radius) : m_index(_index), m_centre(_centre), m_radius(_radius) { }
+
+		/// <summary> The index of the sphere within the list the set was created from. </summary>
+		uint32_t m_index;
+
+		/// <summary> The new centre position. </summary>
+		glm::vec3 m_centre;
+
+		/// <summary> The new radius. </summary>
+		float_t m_radius;
+	};
+
+	/// <summary> Points at each array of a sphere set, wherever they are held. </summary>
+	/// <remarks> Each array has <see cref="SphereSet::LaneCount"/> padding spheres past the end, exactly as a set holds them. </remarks>
+	struct SphereArrays
+	{
+		/// <summary> The x position of each centre. </summary>
+		const float_t* m_centreX;
+
+		/// <summary> The y position of each centre. </summary>
+		const float_t* m_centreY;
+
+		/// <summary> The z position of each centre. </summary>
+		const float_t* m_centreZ;
+
+		/// <summary> The squared radius of each sphere, which is negative for padding. </summary>
+		const float_t* m_radiusSquared;
+
+		/// <summary> The radius of each sphere. </summary>
+		const float_t* m_radius;
+
+		/// <summary> The index into the material table of each sphere. </summary>
+		const uint32_t* m_materialIndex;
+
+		/// <summary> The index of each sphere within the list the set was created from. </summary>
+		const uint32_t* m_originalIndex;
+	};
+
+	/// <summary> Represents every sphere within the world, stored as a structure of arrays so that several spheres can be tested against a ray at once. </summary>
+	/// <remarks> Each array has room for a full vector of padding spheres past the end, which can never be hit, so the kernel never needs a scalar tail. </remarks>
+	class SphereSet
+	{
+	public:
+		/// <summary> Creates an empty set. </summary>
+		SphereSet() : m_count(0), m_mapped(), m_mapping() { pad(); }
+
+		SphereSet(const std::vector<Sphere>&);
+
+		SphereSet(uint32_t, const SphereArrays&, const std::vector<ShapeProperties>&, std::shared_ptr<const void>);
+
+		/// <summary> Gets the number of spheres. </summary>
+		/// <returns> The number of spheres, not including padding. </returns>
+		inline uint32_t GetCount() const { return m_count; }
+
+		/// <summary> Gets the centre of the given sphere. </summary>
+		/// <param name="_index"> The index of the sphere. </param>
+		/// <returns> The centre of the sphere. </returns>
+		inline glm::vec3 GetCentre(const uint32_t _index) const { return IsMapped() ? glm::vec3(m_mapped.m_centreX[_index], m_mapped.m_centreY[_index], m_mapped.m_centreZ[_index]) : glm::vec3(m_centreX[_index], m_centreY[_index], m_centreZ[_index]); }
+
+		/// <summary> Gets the radius of the given sphere. </summary>
+		/// <param name="_index"> The index of the sphere. </param>
+		/// <returns> The radius of the sphere. </returns>
+		inline float_t GetRadius(const uint32_t _index) const { return IsMapped() ? m_mapped.m_radius[_index] : m_radius[_index]; }
+
+		/// <summary> Gets the surface properties of the given sphere. </summary>
+		/// <param name="_index"> The index of the sphere. </param>
+		/// <returns> The properties from the material table. </returns>
+		inline const ShapeProperties& GetProperties(const uint32_t _index) const { return m_materials[IsMapped() ? m_mapped.m_materialIndex[_index] : m_materialIndex[_index]]; }
+
+		/// <summary> Gets the given sphere as a single sphere. </summary>
+		/// <param name="_index"> The index of the sphere. </param>
+		/// <returns> The sphere. </returns>
+		inline Sphere GetSphere(const uint32_t _index) const { return Sphere(GetCentre(_index), GetRadius(_index), GetProperties(_index)); }
+
+		/// <summary> Gets the index the given sphere had in the list the set was created from, before any reordering. </summary>
+		/// <param name="_index"> The index of the sphere within the set. </param>
+		/// <returns> The original index of the sphere. </returns>
+		inline uint32_t GetOriginalIndex(const uint32_t _index) const { return IsMapped() ? m_mapped.m_originalIndex[_index] : m_originalIndex[_index]; }
+
+		/// <summary> Gets the index within the set of the sphere that had the given index in the list the set was created from. </summary>
+		/// <param name="_originalIndex"> The original index of the sphere. </param>
+		/// <returns> The current index of the sphere within the set. </returns>
+		/// <remarks> Mapped sets do not hold the reverse indices, as their spheres can never be moved. </remarks>
+		inline uint32_t GetSetIndex(const uint32_t _originalIndex) const { return m_setIndex[_originalIndex]; }
+
+		/// <summary> Gets the material table. </summary>
+		/// <returns> Every unique set of surface properties. </returns>
+		inline const std::vector<ShapeProperties>& GetMaterials() const { return m_materials; }
+
+		/// <summary> Gets each array, wherever they are held. </summary>
+		/// <returns> The arrays, which are only valid while the set is unchanged. </returns>
+		inline SphereArrays GetArrays() const { return IsMapped() ? m_mapped : SphereArrays{ m_centreX.data(), m_centreY.data(), m_centreZ.data(), m_radiusSquared.data(), m_radius.data(), m_materialIndex.data(), m_originalIndex.data() }; }
+
+		/// <summary> Finds if the arrays are held within a mapped file rather than by the set, in which case it cannot be reordered or moved. </summary>
+		/// <returns> <c>true</c> if the arrays are mapped; otherwise, <c>false</c>. </returns>
+		inline bool IsMapped() const { return m_mapped.m_centreX != nullptr; }
+
+		void Reorder(const std::vector<uint32_t>&);
+
+		void Move(uint32_t, const glm::vec3&, float_t);
+
+		bool IntersectClosest(const Ray&, uint32_t, uint32_t, SphereHit&, uint32_t _ignoreIndex = UINT32_MAX) const;
+
+		/// <summary> Finds the closest sphere hit by the given ray. </summary>
+		/// <param name="_ray"> The ray, with a normalised direction. </param>
+		/// <param name="io_hit"> The closest hit, only hits closer than its current distance are counted. </param>
+		/// <param name="_ignoreIndex"> The index of a sphere to skip, such as the one a ray is leaving. </param>
+		/// <returns> <c>true</c> if a closer sphere was hit; otherwise, <c>false</c>. </returns>
+		inline bool IntersectClosest(const Ray& _ray, SphereHit& io_hit, const uint32_t _ignoreIndex = UINT32_MAX) const { return IntersectClosest(_ray, 0, m_count, io_hit, _ignoreIndex); }
+
+		bool IntersectAny(const Ray&, uint32_t, uint32_t, float_t, uint32_t&, uint32_t _ignoreIndex = UINT32_MAX) const;
+
+		bool IntersectClosest(RayPacket&, uint32_t, uint32_t, uint32_t _laneMask = UINT32_MAX) const;
+
+		uint32_t IntersectAny(const RayPacket&, uint32_t, uint32_t, uint32_t, uint32_t&) const;
+
+		/// <summary> The number of spheres tested by each instruction of the kernel. </summary>
+		static const uint32_t LaneCount = 8;
+	private:
+		/// <summary> The number of spheres, not including padding. </summary>
+		uint32_t m_count;
+
+		/// <summary> The x position of each centre. </summary>
+		std::vector<float_t> m_centreX;
+
+		/// <summary> The y position of each centre. </summary>
+		std::vector<float_t> m_centreY;
+
+		/// <summary> The z position of each centre. </summary>
+		std::vector<float_t> m_centreZ;
+
+		/// <summary> The squared radius of each sphere, which is negative for padding so that it can never be hit. </summary>
+		std::vector<float_t> m_radiusSquared;
+
+		/// <summary> The radius of each sphere. </summary>
+		std::vector<float_t> m_radius;
+
+		/// <summary> The index into the material table of each sphere. </summary>
+		std::vector<uint32_t> m_materialIndex;
+
+		/// <summary> The index of each sphere within the list the set was created from. </summary>
+		std::vector<uint32_t> m_originalIndex;
+
+		/// <summary> The index within the set of each sphere from the list the set was created from, the reverse of the original indices. </summary>
+		std::vector<uint32_t> m_setIndex;
+
+		/// <summary> Every unique set of surface properties. </summary>
+		std::vector<ShapeProperties> m_materials;
+
+		/// <summary> The arrays held within a mapped file, which are used instead of the vectors above if set. </summary>
+		SphereArrays m_mapped;
+
+		/// <summary> Keeps the file holding the mapped arrays open for as long as the set uses them. </summary>
+		std::shared_ptr<const void> m_mapping;
+
+		void pad();
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "Telemetry.h"
+
+// Utility includes.
+#include <sstream>
+
+/// <summary> The ray stats of the calling thread. </summary>
+thread_local Telemetry::RayStats* Telemetry::Recorder::t_rayStats = nullptr;
+
+/// <summary> Adds the given stats to these. </summary>
+/// <param name="_other"> The stats to add. </param>
+/// <returns> These stats. </returns>
+Telemetry::RayStats& Telemetry::RayStats::operator+=(const RayStats& _other)
+{
+	for (size_t t = 0; t < (size_t)RayType::Count; t++) { m_rays[t] += _other.m_rays[t]; }
+	m_sphereTests += _other.m_sphereTests;
+	m_hits += _other.m_hits;
+	m_misses += _other.m_misses;
+	m_cutoffs += _other.m_cutoffs;
+	m_terminations += _other.m_terminations;
+	m_packetRays += _other.m_packetRays;
+	for (uint32_t d = 0; d < DepthCount; d++) { m_depths[d] += _other.m_depths[d]; }
+	return *this;
+}
+
+/// <summary> Gets the number of rays of every type traced per second spent rendering and sampling. </summary>
+/// <returns> The throughput in millions of rays per second, or <c>0</c> if no time was spent tracing. </returns>
+double Telemetry::FrameRecord::GetMegaraysPerSecond() const
+{
+	double tracingMilliseconds = GetMilliseconds(Phase::Render) + GetMilliseconds(Phase::Sample);
+	return (tracingMilliseconds > 0) ? m_rayStats.GetTotal() / (tracingMilliseconds * 1000) : 0;
+}
+
+/// <summary> Writes this record as a single line of JSON, without a line break. </summary>
+/// <returns> The JSON object. </returns>
+std::string Telemetry::FrameRecord::ToJSON() const
+{
+	std::ostringstream json;
+	json << "{\"frame\":" << m_frame << ",\"width\":" << m_width << ",\"height\":" << m_height << ",\"threads\":" << m_threadCount << ",\"samples\":" << (int)m_sampleLevel << ",\"frame_ms\":" << m_frameMilliseconds;
+
+	// Write each phase and counter by name.
+	json << ",\"phases_ms\":{";
+	for (size_t p = 0; p < (size_t)Phase::Count; p++) { json << ((p > 0) ? "," : "") << "\"" << GetName((Phase)p) << "\":" << m_phaseMilliseconds[p]; }
+	json << "},\"counters\":{";
+	for (size_t c = 0; c < (size_t)Counter::Count; c++) { json << ((c > 0) ? "," : "") << "\"" << GetName((Counter)c) << "\":" << m_counters[c]; }
+	json << "}";
+
+	// Write the rays by type, then the histogram of reflection depths.
+	const RayStats& rays = m_rayStats;
+	json << ",\"rays\":{\"primary\":" << rays.GetCount(RayType::Primary) << ",\"shadow\":" << rays.GetCount(RayType::Shadow) << ",\"reflection\":" << rays.GetCount(RayType::Reflection) << ",\"total\":" << rays.GetTotal()
+		<< ",\"sphere_tests\":" << rays.m_sphereTests << ",\"hits\":" << rays.m_hits << ",\"misses\":" << rays.m_misses << ",\"cutoffs\":" << rays.m_cutoffs << ",\"terminations\":" << rays.m_terminations << ",\"cutoff_rate\":" << rays.GetCutoffRate() << ",\"packet_rays\":" << rays.m_packetRays << ",\"depths\":[";
+	for (uint32_t d = 0; d < RayStats::DepthCount; d++) { json << ((d > 0) ? "," : "") << rays.m_depths[d]; }
+	json << "],\"mrays_per_second\":" << GetMegaraysPerSecond() << "}}";
+
+	return json.str();
+}
+
+/// <summary> Creates a disabled recorder with every phase and counter at zero. </summary>
+Telemetry::Recorder::Recorder() : m_enabled(false), m_frameStart(std::chrono::steady_clock::now()), m_frameCount(0), m_output(nullptr)
+{
+	for (std::atomic<uint64_t>& phase : m_phaseNanoseconds) { phase.store(0, std::memory_order_relaxed); }
+	for (std::atomic<uint64_t>& counter : m_counters) { counter.store(0, std::memory_order_relaxed); }
+}
+
+/// <summary> Marks the start of a frame. Anything recorded since the last frame ended, such as building the hierarchy, still counts towards this frame. </summary>
+void Telemetry::Recorder::BeginFrame()
+{
+	m_frameStart = std::chrono::steady_clock::now();
+}
+
+/// <summary> Marks the end of a frame, taking every phase and counter into a record and starting them again from zero. </summary>
+/// <param name="_width"> The width of the frame in pixels. </param>
+/// <param name="_height"> The height of the frame in pixels. </param>
+/// <param name="_threadCount"> The number of threads the frame was drawn with. </param>
+/// <param name="_sampleLevel"> The sample level the frame was drawn with. </param>
+/// <returns> The record of the frame, which is also kept in the history and written to the output if there is one. Empty if not recording. </returns>
+Telemetry::FrameRecord Telemetry::Recorder::EndFrame(const uint16_t _width, const uint16_t _height, const uint16_t _threadCount, const uint8_t _sampleLevel)
+{
+	FrameRecord record;
+	if (!IsEnabled()) { return record; }
+
+	// Take the value of everything recorded since the last frame.
+	record.m_width = _width;
+	record.m_height = _height;
+	record.m_threadCount = _threadCount;
+	record.m_sampleLevel = _sampleLevel;
+	record.m_frameMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_frameStart).count();
+	for (size_t p = 0; p < (size_t)Phase::Count; p++) { record.m_phaseMilliseconds[p] = m_phaseNanoseconds[p].exchange(0, std::memory_order_relaxed) / 1e6; }
+	for (size_t c = 0; c < (size_t)Counter::Count; c++) { record.m_counters[c] = m_counters[c].exchange(0, std::memory_order_relaxed); }
+
+	// Sum and clear the rays of every thread. Nothing is tracing now, so the stats can be read without each thread's help.
+	{
+		std::lock_guard<std::mutex> rayLock(m_rayStatsMutex);
+		for (std::unique_ptr<RayStats>& rayStats : m_rayStats) { record.m_rayStats += *rayStats; *rayStats = RayStats(); }
+	}
+
+	// Keep the record, dropping the oldest once the history is full, and write it out.
+	std::lock_guard<std::mutex> lock(m_historyMutex);
+	record.m_frame = m_frameCount++;
+	m_history.push_back(record);
+	if (m_history.size() > HistorySize) { m_history.pop_front(); }
+	if (m_output != nullptr) { *m_output << record.ToJSON() << '\n'; m_output->flush(); }
+
+	return record;
+}
+
+/// <summary> Creates ray stats for the calling thread and adds them to the list summed at the end of each frame. </summary>
+/// <returns> The calling thread's new stats. </returns>
+Telemetry::RayStats* Telemetry::Recorder::registerRayStats()
+{
+	std::lock_guard<std::mutex> lock(m_rayStatsMutex);
+	m_rayStats.push_back(std::unique_ptr<RayStats>(new RayStats()));
+	t_rayStats = m_rayStats.back().get();
+	return t_rayStats;
+}
+
+/// <summary> Gets the most recent frames. </summary>
+/// <returns> A copy of the history, oldest first. </returns>
+std::vector<Telemetry::FrameRecord> Telemetry::Recorder::GetFrames() const
+{
+	std::lock_guard<std::mutex> lock(m_historyMutex);
+	return std::vector<FrameRecord>(m_history.begin(), m_history.end());
+}
+
+/// <summary> Gets the process-wide recorder, which starts disabled. </summary>
+/// <returns> The process-wide recorder. </returns>
+Telemetry::Recorder& Telemetry::Recorder::Get()
+{
+	static Recorder recorder;
+	return recorder;
+}
+
+/// <summary> Gets the name of the given phase, as used in JSON. </summary>
+/// <param name="_phase"> The phase. </param>
+/// <returns> The name in lower case. </returns>
+const char* Telemetry::GetName(const Phase _phase)
+{
+	switch (_phase)
+	{
+	case Phase::Build: return "build";
+	case Phase::Refit: return "refit";
+	case Phase::Render: return "render";
+	case Phase::Sample: return "sample";
+	case Phase::Upload: return "upload";
+	default: return "unknown";
+	}
+}
+
+/// <summary> Gets the name of the given counter, as used in JSON. </summary>
+/// <param name="_counter"> The counter. </param>
+/// <returns> The name in lower case. </returns>
+const char* Telemetry::GetName(const Counter _counter)
+{
+	switch (_counter)
+	{
+	case Counter::PixelsWritten: return "pixels_written";
+	case Counter::RefinedPixels: return "refined_pixels";
+	default: return "unknown";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,301 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Threading includes.
+#include <atomic>
+#include <mutex>
+
+// Utility includes.
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <memory>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Telemetry
+{
+	/// <summary> The timed parts of the program. </summary>
+	enum class Phase : uint8_t
+	{
+		/// <summary> Building the hierarchy over the spheres. </summary>
+		Build,
+
+		/// <summary> Refitting the hierarchy after spheres have moved. </summary>
+		Refit,
+
+		/// <summary> Tracing every pixel. </summary>
+		Render,
+
+		/// <summary> Tracing or averaging the extra samples of each pixel when they are not resolved while rendering. </summary>
+		Sample,
+
+		/// <summary> Handing the finished frame over to be displayed, such as unlocking the texture or writing the image, but not waiting on the display itself. </summary>
+		Upload,
+
+		/// <summary> The number of phases. </summary>
+		Count
+	};
+
+	/// <summary> The counted events of the program. </summary>
+	enum class Counter : uint8_t
+	{
+		/// <summary> Finished pixels written to a buffer. </summary>
+		PixelsWritten,
+
+		/// <summary> Pixels that traced every sample after being found on an edge. </summary>
+		RefinedPixels,
+
+		/// <summary> The number of counters. </summary>
+		Count
+	};
+
+	/// <summary> The kinds of ray traced through the world. </summary>
+	enum class RayType : uint8_t
+	{
+		/// <summary> Rays from the camera through a pixel or sample. </summary>
+		Primary,
+
+		/// <summary> Rays from a hit towards the light source. </summary>
+		Shadow,
+
+		/// <summary> Rays bounced off a reflective sphere. </summary>
+		Reflection,
+
+		/// <summary> The number of ray types. </summary>
+		Count
+	};
+
+	/// <summary> Represents the rays traced by a single thread, or the sum over every thread once a frame ends. </summary>
+	/// <remarks> The fields are plain integers, as each thread only ever writes to its own stats. </remarks>
+	struct RayStats
+	{
+		/// <summary> The number of depths in the histogram, the last of which also holds every deeper path. </summary>
+		static const uint32_t DepthCount = 8;
+
+		/// <summary> Creates stats with everything at zero. </summary>
+		RayStats() : m_rays(), m_sphereTests(0), m_hits(0), m_misses(0), m_cutoffs(0), m_terminations(0), m_packetRays(0), m_depths() { }
+
+		/// <summary> The number of rays traced of each type, indexed by type. </summary>
+		uint64_t m_rays[(size_t)RayType::Count];
+
+		/// <summary> The number of spheres tested against a ray, including every sphere in any leaf a ray visited. </summary>
+		uint64_t m_sphereTests;
+
+		/// <summary> The number of rays of any type that hit a sphere, where a hit shadow ray is in shadow. </summary>
+		uint64_t m_hits;
+
+		/// <summary> The number of rays of any type that hit nothing. </summary>
+		uint64_t m_misses;
+
+		/// <summary> The number of reflections not traced because the path reached the reflection limit. </summary>
+		uint64_t m_cutoffs;
+
+		/// <summary> The number of reflections not traced because the path's throughput fell below the termination threshold, or it lost the roulette. </summary>
+		uint64_t m_terminations;
+
+		/// <summary> The number of rays whose hit was found as part of a packet rather than on their own. </summary>
+		uint64_t m_packetRays;
+
+		/// <summary> The number of paths that ended after each number of reflections, indexed by the number of reflections. </summary>
+		uint64_t m_depths[DepthCount];
+
+		/// <summary> Counts a path that ended after the given number of reflections. </summary>
+		/// <param name="_depth"> The number of reflections made before the path ended. </param>
+		inline void AddDepth(const uint32_t _depth) { m_depths[(_depth < DepthCount) ? _depth : DepthCount - 1]++; }
+
+		/// <summary> Gets the number of rays of the given type. </summary>
+		/// <param name="_type"> The type of ray. </param>
+		/// <returns> The number of rays traced. </returns>
+		inline uint64_t GetCount(const RayType _type) const { return m_rays[(size_t)_type]; }
+
+		/// <summary> Gets the number of rays of every type. </summary>
+		/// <returns> The number of rays traced. </returns>
+		inline uint64_t GetTotal() const { return m_rays[(size_t)RayType::Primary] + m_rays[(size_t)RayType::Shadow] + m_rays[(size_t)RayType::Reflection]; }
+
+		/// <summary> Gets the share of reflections that were not traced, either at the limit or because of a low throughput. </summary>
+		/// <returns> The cut off and terminated reflections over every reflection that was traced or not, or <c>0</c> if there were none. </returns>
+		inline double GetCutoffRate() const { uint64_t dropped = m_cutoffs + m_terminations, total = dropped + m_rays[(size_t)RayType::Reflection]; return (total > 0) ? (double)dropped / total : 0; }
+
+		RayStats& operator+=(const RayStats&);
+	};
+
+	/// <summary> Represents everything recorded over a single frame. </summary>
+	struct FrameRecord
+	{
+		/// <summary> Creates an empty record. </summary>
+		FrameRecord() : m_frame(0), m_width(0), m_height(0), m_threadCount(0), m_sampleLevel(0), m_frameMilliseconds(0), m_phaseMilliseconds(), m_counters(), m_rayStats() { }
+
+		/// <summary> The number of frames recorded before this one. </summary>
+		uint64_t m_frame;
+
+		/// <summary> The width of the frame in pixels. </summary>
+		uint16_t m_width;
+
+		/// <summary> The height of the frame in pixels. </summary>
+		uint16_t m_height;
+
+		/// <summary> The number of threads the frame was drawn with. </summary>
+		uint16_t m_threadCount;
+
+		/// <summary> The sample level the frame was drawn with. </summary>
+		uint8_t m_sampleLevel;
+
+		/// <summary> The time from the start of the frame to its end. </summary>
+		double m_frameMilliseconds;
+
+		/// <summary> The time spent in each phase since the last frame ended, indexed by phase. </summary>
+		double m_phaseMilliseconds[(size_t)Phase::Count];
+
+		/// <summary> The value of each counter since the last frame ended, indexed by counter. </summary>
+		uint64_t m_counters[(size_t)Counter::Count];
+
+		/// <summary> The rays traced by every thread since the last frame ended. </summary>
+		RayStats m_rayStats;
+
+		/// <summary> Gets the time spent in the given phase. </summary>
+		/// <param name="_phase"> The phase. </param>
+		/// <returns> The time in milliseconds. </returns>
+		inline double GetMilliseconds(const Phase _phase) const { return m_phaseMilliseconds[(size_t)_phase]; }
+
+		/// <summary> Gets the value of the given counter. </summary>
+		/// <param name="_counter"> The counter. </param>
+		/// <returns> The number of times the counted event happened. </returns>
+		inline uint64_t GetCount(const Counter _counter) const { return m_counters[(size_t)_counter]; }
+
+		double GetMegaraysPerSecond() const;
+
+		std::string ToJSON() const;
+	};
+
+	/// <summary> Collects the time spent in each phase and the value of each counter from any thread, and turns them into a record at the end of each frame. </summary>
+	/// <remarks> Recording is a relaxed atomic add, with no locks, and does nothing at all when disabled. Rays are counted into stats owned by each thread instead, as there are far too many to share a counter. Defining <c>MCG_GFX_NO_TELEMETRY</c> removes it entirely. </remarks>
+	class Recorder
+	{
+	public:
+		/// <summary> The number of frames kept in the history. </summary>
+		static const size_t HistorySize = 256;
+
+		Recorder();
+
+		/// <summary> Finds if recording is enabled. </summary>
+		/// <returns> <c>true</c> if times and counts are being recorded; otherwise, <c>false</c>. </returns>
+		inline bool IsEnabled() const
+		{
+#ifdef MCG_GFX_NO_TELEMETRY
+			return false;
+#else
+			return m_enabled.load(std::memory_order_relaxed);
+#endif
+		}
+
+		/// <summary> Starts or stops recording. </summary>
+		/// <param name="_enabled"> <c>true</c> to record times and counts; otherwise, <c>false</c>. </param>
+		inline void SetEnabled(const bool _enabled) { m_enabled.store(_enabled, std::memory_order_relaxed); }
+
+		/// <summary> Adds the given time to the given phase, if recording. </summary>
+		/// <param name="_phase"> The phase. </param>
+		/// <param name="_duration"> The time spent in the phase. </param>
+		inline void AddTime(const Phase _phase, const std::chrono::steady_clock::duration _duration)
+		{
+			if (IsEnabled()) { m_phaseNanoseconds[(size_t)_phase].fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(_duration).count(), std::memory_order_relaxed); }
+		}
+
+		/// <summary> Adds the given amount to the given counter, if recording. </summary>
+		/// <param name="_counter"> The counter. </param>
+		/// <param name="_amount"> The amount to add. </param>
+		inline void Add(const Counter _counter, const uint64_t _amount)
+		{
+			if (IsEnabled()) { m_counters[(size_t)_counter].fetch_add(_amount, std::memory_order_relaxed); }
+		}
+
+		/// <summary> Gets the ray stats of the calling thread, creating them on first use. </summary>
+		/// <returns> The calling thread's stats, or <c>nullptr</c> if not recording. </returns>
+		/// <remarks> Fetch these once per batch of rays, such as once per tile, rather than once per ray. </remarks>
+		inline RayStats* GetRayStats()
+		{
+			if (!IsEnabled()) { return nullptr; }
+			return (t_rayStats != nullptr) ? t_rayStats : registerRayStats();
+		}
+
+		void BeginFrame();
+
+		FrameRecord EndFrame(uint16_t, uint16_t, uint16_t, uint8_t);
+
+		std::vector<FrameRecord> GetFrames() const;
+
+		/// <summary> Sets the stream to which each frame's record is written as a line of JSON. </summary>
+		/// <param name="o_output"> The stream, or <c>nullptr</c> to only keep the records in the history. </param>
+		inline void SetOutput(std::ostream* o_output) { std::lock_guard<std::mutex> lock(m_historyMutex); m_output = o_output; }
+
+		static Recorder& Get();
+	private:
+		/// <summary> Whether times and counts are being recorded. </summary>
+		std::atomic<bool> m_enabled;
+
+		/// <summary> The time spent in each phase since the last frame ended, in nanoseconds. </summary>
+		std::atomic<uint64_t> m_phaseNanoseconds[(size_t)Phase::Count];
+
+		/// <summary> The value of each counter since the last frame ended. </summary>
+		std::atomic<uint64_t> m_counters[(size_t)Counter::Count];
+
+		/// <summary> The time at which the current frame began. </summary>
+		std::chrono::steady_clock::time_point m_frameStart;
+
+		/// <summary> The number of frames ended so far. </summary>
+		uint64_t m_frameCount;
+
+		/// <summary> Guards the history and output, which are only touched once per frame. </summary>
+		mutable std::mutex m_historyMutex;
+
+		/// <summary> The most recent frames, oldest first. </summary>
+		std::deque<FrameRecord> m_history;
+
+		/// <summary> The stream to which each frame's record is written, if any. </summary>
+		std::ostream* m_output;
+
+		/// <summary> Guards the list of ray stats, which is only touched when a thread first traces and when a frame ends. </summary>
+		std::mutex m_rayStatsMutex;
+
+		/// <summary> The ray stats of every thread that has traced a ray, summed and cleared when a frame ends. </summary>
+		std::vector<std::unique_ptr<RayStats>> m_rayStats;
+
+		/// <summary> The ray stats of the calling thread, or <c>nullptr</c> if it has not traced a ray yet. </summary>
+		static thread_local RayStats* t_rayStats;
+
+		RayStats* registerRayStats();
+	};
+
+	/// <summary> Adds the time from its creation to its destruction to a phase, only reading the clock if recording. </summary>
+	class ScopedTimer
+	{
+	public:
+		/// <summary> Starts timing the given phase. </summary>
+		/// <param name="_phase"> The phase to which the time is added. </param>
+		ScopedTimer(const Phase _phase) : m_phase(_phase), m_enabled(Recorder::Get().IsEnabled()) { if (m_enabled) { m_start = std::chrono::steady_clock::now(); } }
+
+		/// <summary> Adds the time since creation to the phase. </summary>
+		~ScopedTimer() { if (m_enabled) { Recorder::Get().AddTime(m_phase, std::chrono::steady_clock::now() - m_start); } }
+
+		ScopedTimer(const ScopedTimer&) = delete;
+
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+	private:
+		/// <summary> The phase to which the time is added. </summary>
+		Phase m_phase;
+
+		/// <summary> Whether recording was enabled when the timer started. </summary>
+		bool m_enabled;
+
+		/// <summary> The time at which the timer started. </summary>
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	const char* GetName(Phase);
+
+	const char* GetName(Counter);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "ThreadPool.h"
+
+namespace Threading
+{
+	/// <summary> The index of the worker running on the current thread, or <c>UINT32_MAX</c> if the thread is not a worker. </summary>
+	thread_local uint32_t t_workerIndex = UINT32_MAX;
+
+	/// <summary> The pool from which the current thread's worker index was taken, or <c>nullptr</c> if the thread is not a worker. </summary>
+	thread_local const ThreadPool* t_workerPool = nullptr;
+}
+
+/// <summary> Creates a pool with the given number of workers and starts them. </summary>
+/// <param name="_workerCount"> The number of worker threads, or <c>0</c> to use the number of hardware threads. </param>
+Threading::ThreadPool::ThreadPool(uint32_t _workerCount) : m_pendingTasks(0), m_nextQueue(0), m_running(true)
+{
+	// Default to one worker per hardware thread, making sure there is always at least one.
+	if (_workerCount == 0) { _workerCount = (std::thread::hardware_concurrency() > 0) ? std::thread::hardware_concurrency() : 1; }
+
+	// Create the queues first so that every worker can see every other queue as soon as it starts.
+	for (uint32_t w = 0; w < _workerCount; w++) { m_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue())); }
+
+	// Start each worker.
+	for (uint32_t w = 0; w < _workerCount; w++) { m_workers.push_back(std::thread(&ThreadPool::workerLoop, this, w)); }
+}
+
+/// <summary> Stops every worker once they have finished their current task, then waits for them to exit. </summary>
+Threading::ThreadPool::~ThreadPool()
+{
+	// Tell the workers to stop and wake any that are sleeping.
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_running = false;
+	}
+	m_wakeCondition.notify_all();
+
+	// Wait for each worker to exit.
+	for (size_t w = 0; w < m_workers.size(); w++) { m_workers[w].join(); }
+}
+
+/// <summary> Adds the given task to the pool to be run on any worker. </summary>
+/// <param name="_task"> The task to run. </param>
+/// <remarks> Tasks submitted from a worker go to the back of that worker's own queue, otherwise the queues are filled in turn. </remarks>
+void Threading::ThreadPool::Submit(Task _task)
+{
+	// Work out which queue to add the task to.
+	uint32_t queueIndex = (t_workerPool == this) ? t_workerIndex : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % GetWorkerCount();
+
+	// Count the task under the sleep lock before it can be taken, so that the count never drops below zero and a worker about to sleep cannot miss it.
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_pendingTasks++;
+	}
+
+	// Add the task to the queue, then wake a worker to take it.
+	{
+		std::lock_guard<std::mutex> lock(m_queues[queueIndex]->m_mutex);
+		m_queues[queueIndex]->m_tasks.push_back(std::move(_task));
+	}
+	m_wakeCondition.notify_one();
+}
+
+/// <summary> Runs the given function once for every index up to the given count across the pool, and returns once every call has finished. </summary>
+/// <param name="_taskCount"> The number of times to call the function. </param>
+/// <param name="_task"> The function to call, taking the index of the call. </param>
+/// <remarks> The calling thread runs tasks while it waits, so this may safely be called from within a task. </remarks>
+void Threading::ThreadPool::ParallelFor(const uint32_t _taskCount, const std::function<void(uint32_t)>& _task)
+{
+	// If there is nothing to split, just run it here.
+	if (_taskCount == 0) { return; }
+	if (_taskCount == 1) { _task(0); return; }
+
+	// Keep track of how many tasks are still to finish.
+	std::atomic<uint32_t> remainingTasks(_taskCount);
+
+	// Submit every task but the first, which this thread runs itself.
+	for (uint32_t t = 1; t < _taskCount; t++)
+	{
+		Submit([&_task, &remainingTasks, t]() { _task(t); remainingTasks.fetch_sub(1, std::memory_order_acq_rel); });
+	}
+	_task(0);
+	remainingTasks.fetch_sub(1, std::memory_order_acq_rel);
+
+	// Help with any work in the pool until every task has finished.
+	uint32_t helperIndex = (t_workerPool == this) ? t_workerIndex : 0;
+	while (remainingTasks.load(std::memory_order_acquire) > 0)
+	{
+		Task task;
+		if (tryTakeTask(helperIndex, task)) { task(); }
+		else { std::this_thread::yield(); }
+	}
+}
+
+/// <summary> Gets the process-wide pool, creating it with one worker per hardware thread on first use. </summary>
+/// <returns> The process-wide pool. </returns>
+Threading::ThreadPool& Threading::ThreadPool::Get()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+/// <summary> Runs tasks from the worker's own queue, stealing from the others when it is empty, and sleeps when there is no work at all. </summary>
+/// <param name="_workerIndex"> The index of this worker. </param>
+void Threading::ThreadPool::workerLoop(const uint32_t _workerIndex)
+{
+	// Mark this thread as a worker of this pool.
+	t_workerIndex = _workerIndex;
+	t_workerPool = this;
+
+	while (true)
+	{
+		// Run a task if one can be found.
+		Task task;
+		if (tryTakeTask(_workerIndex, task)) { task(); continue; }
+
+		// Otherwise, sleep until there is work or the pool is stopping.
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.wait(lock, [this]() { return m_pendingTasks > 0 || !m_running; });
+
+		// Only exit once stopped, never with work left over.
+		if (!m_running && m_pendingTasks == 0) { return; }
+	}
+}
+
+/// <summary> Takes a task from the back of the given worker's queue, or steals one from the front of another worker's queue. </summary>
+/// <param name="_workerIndex"> The index of the worker looking for a task. </param>
+/// <param name="o_task"> The found task. </param>
+/// <returns> <c>true</c> if a task was found; otherwise, <c>false</c>. </returns>
+bool Threading::ThreadPool::tryTakeTask(const uint32_t _workerIndex, Task& o_task)
+{
+	// Go over every queue, starting with the worker's own.
+	for (uint32_t offset = 0; offset < GetWorkerCount(); offset++)
+	{
+		uint32_t queueIndex = (_workerIndex + offset) % GetWorkerCount();
+		WorkerQueue& queue = *m_queues[queueIndex];
+
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		if (queue.m_tasks.empty()) { continue; }
+
+		// Take the newest task from the worker's own queue, or the oldest task from another's.
+		if (offset == 0) { o_task = std::move(queue.m_tasks.back()); queue.m_tasks.pop_back(); }
+		else { o_task = std::move(queue.m_tasks.front()); queue.m_tasks.pop_front(); }
+
+		m_pendingTasks--;
+		return true;
+	}
+
+	// No task was found.
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Threading includes.
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Utility includes.
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Threading
+{
+	/// <summary> Represents a persistent pool of worker threads, each with their own queue of tasks that other workers can steal from when idle. </summary>
+	/// <remarks> Threads are created once and live for as long as the pool, so submitting work never creates or joins a thread. </remarks>
+	class ThreadPool
+	{
+	public:
+		/// <summary> A single unit of work. </summary>
+		typedef std::function<void()> Task;
+
+		ThreadPool(uint32_t _workerCount = 0);
+
+		~ThreadPool();
+
+		/// <summary> Gets the number of worker threads within the pool. </summary>
+		/// <returns> The number of worker threads. </returns>
+		inline uint32_t GetWorkerCount() const { return (uint32_t)m_workers.size(); }
+
+		void Submit(Task);
+
+		void ParallelFor(uint32_t, const std::function<void(uint32_t)>&);
+
+		static ThreadPool& Get();
+	private:
+		/// <summary> Represents the double-ended queue of tasks owned by a single worker. </summary>
+		/// <remarks> The owner pushes and pops from the back, thieves take from the front so that they take the oldest and usually largest work. </remarks>
+		struct WorkerQueue
+		{
+			/// <summary> Guards the tasks. </summary>
+			std::mutex m_mutex;
+
+			/// <summary> The tasks waiting to be run. </summary>
+			std::deque<Task> m_tasks;
+		};
+
+		/// <summary> The queue of each worker, indexed by worker. </summary>
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+		/// <summary> The worker threads. </summary>
+		std::vector<std::thread> m_workers;
+
+		/// <summary> The number of tasks that have been submitted but not yet taken by a thread. </summary>
+		std::atomic<uint32_t> m_pendingTasks;
+
+		/// <summary> The queue into which the next task from a non-worker thread is placed. </summary>
+		std::atomic<uint32_t> m_nextQueue;
+
+		/// <summary> <c>true</c> while the workers should keep running; otherwise, <c>false</c>. </summary>
+		bool m_running;
+
+		/// <summary> Guards the sleeping of idle workers. </summary>
+		std::mutex m_sleepMutex;
+
+		/// <summary> Wakes idle workers when work is submitted or the pool is shutting down. </summary>
+		std::condition_variable m_wakeCondition;
+
+		void workerLoop(uint32_t);
+
+		bool tryTakeTask(uint32_t, Task&);
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "TileScheduler.h"
+
+// Framework includes.
+#include <glm.hpp>
+
+// Utility includes.
+#include <algorithm>
+
+/// <summary> Creates a scheduler covering a screen of the given size with tiles of roughly the given size, ordered by the given order. </summary>
+/// <param name="_width"> The width of the screen in pixels. </param>
+/// <param name="_height"> The height of the screen in pixels. </param>
+/// <param name="_tileSize"> The requested width and height of each tile in pixels. </param>
+/// <param name="_order"> The order in which tiles are handed out. </param>
+/// <param name="_pixelSize"> The size of a single pixel in bytes, used to round the tile width up to whole cache lines. </param>
+Rendering::TileScheduler::TileScheduler(const uint16_t _width, const uint16_t _height, const uint16_t _tileSize, const TileOrder _order, const uint16_t _pixelSize) : m_nextTile(0)
+{
+	// Find the smallest number of pixels whose size is a whole number of cache lines.
+	uint16_t lineCountPixels = CacheLineSize;
+	for (uint16_t pixels = 1; pixels <= CacheLineSize; pixels++) { if ((pixels * _pixelSize) % CacheLineSize == 0) { lineCountPixels = pixels; break; } }
+
+	// Round the width up to a whole number of cache lines, so that no two tiles write to the same line when the rows are aligned.
+	m_tileWidth = (uint16_t)(((glm::max(_tileSize, (uint16_t)1) + lineCountPixels - 1) / lineCountPixels) * lineCountPixels);
+	m_tileHeight = glm::max(_tileSize, (uint16_t)1);
+
+	// Calculate how many tiles are needed in each direction.
+	uint16_t tilesX = (uint16_t)((_width + m_tileWidth - 1) / m_tileWidth);
+	uint16_t tilesY = (uint16_t)((_height + m_tileHeight - 1) / m_tileHeight);
+
+	// The Hilbert curve works over a square with a power of two side, so find the smallest one covering every tile.
+	uint16_t curveSize = 1;
+	while (curveSize < tilesX || curveSize < tilesY) { curveSize *= 2; }
+
+	// Create each tile along with its index along the curve.
+	std::vector<std::pair<uint32_t, Tile>> orderedTiles;
+	orderedTiles.reserve(tilesX * tilesY);
+	for (uint16_t tileY = 0; tileY < tilesY; tileY++)
+	{
+		for (uint16_t tileX = 0; tileX < tilesX; tileX++)
+		{
+			// Clip the tile to the edge of the screen.
+			Tile tile;
+			tile.m_x = tileX * m_tileWidth;
+			tile.m_y = tileY * m_tileHeight;
+			tile.m_width = glm::min(m_tileWidth, (uint16_t)(_width - tile.m_x));
+			tile.m_height = glm::min(m_tileHeight, (uint16_t)(_height - tile.m_y));
+
+			// Calculate the index of the tile based on the order.
+			uint32_t index = tileY * tilesX + tileX;
+			if (_order == TileOrder::Morton) { index = MortonIndex(tileX, tileY); }
+			else if (_order == TileOrder::Hilbert) { index = HilbertIndex(tileX, tileY, curveSize); }
+
+			orderedTiles.push_back(std::make_pair(index, tile));
+		}
+	}
+
+	// Sort the tiles by their index and save them.
+	std::sort(orderedTiles.begin(), orderedTiles.end(), [](const std::pair<uint32_t, Tile>& _a, const std::pair<uint32_t, Tile>& _b) { return _a.first < _b.first; });
+	m_tiles.reserve(orderedTiles.size());
+	for (size_t t = 0; t < orderedTiles.size(); t++) { m_tiles.push_back(orderedTiles[t].second); }
+}
+
+/// <summary> Takes the next tile to be drawn. </summary>
+/// <param name="o_tile"> The taken tile. </param>
+/// <returns> <c>true</c> if a tile was taken; otherwise, <c>false</c> if every tile has already been taken. </returns>
+bool Rendering::TileScheduler::NextTile(Tile& o_tile)
+{
+	// Take the next index, if it is past the end then every tile has been taken.
+	uint32_t index = m_nextTile.fetch_add(1, std::memory_order_relaxed);
+	if (index >= m_tiles.size()) { return false; }
+
+	o_tile = m_tiles[index];
+	return true;
+}
+
+/// <summary> Calculates the index along a Z-order curve of the given position by interleaving the bits of each axis. </summary>
+/// <param name="_x"> The x position. </param>
+/// <param name="_y"> The y position. </param>
+/// <returns> The index along the curve. </returns>
+uint32_t Rendering::TileScheduler::MortonIndex(const uint16_t _x, const uint16_t _y)
+{
+	// Spread the bits of each axis out so that there is a gap between each one.
+	uint32_t x = _x, y = _y;
+	x = (x | (x << 8)) & 0x00FF00FF; y = (y | (y << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F; y = (y | (y << 4)) & 0x0F0F0F0F;
+	x = (x | (x << 2)) & 0x33333333; y = (y | (y << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555; y = (y | (y << 1)) & 0x55555555;
+
+	// Fill the gaps of one with the other.
+	return x | (y << 1);
+}
+
+/// <summary> Calculates the index along a Hilbert curve of the given position. </summary>
+/// <param name="_x"> The x position. </param>
+/// <param name="_y"> The y position. </param>
+/// <param name="_size"> The width and height of the square covered by the curve, must be a power of two. </param>
+/// <returns> The index along the curve. </returns>
+uint32_t Rendering::TileScheduler::HilbertIndex(const uint16_t _x, const uint16_t _y, const uint16_t _size)
+{
+	uint32_t x = _x, y = _y, index = 0;
+
+	// Go from the largest quadrant to the smallest, adding the position within each one.
+	for (uint32_t quadrantSize = _size / 2; quadrantSize > 0; quadrantSize /= 2)
+	{
+		uint32_t quadrantX = (x & quadrantSize) > 0 ? 1 : 0;
+		uint32_t quadrantY = (y & quadrantSize) > 0 ? 1 : 0;
+		index += quadrantSize * quadrantSize * ((3 * quadrantX) ^ quadrantY);
+
+		// Rotate the quadrant so that the curve inside of it lines up with the ones either side.
+		if (quadrantY == 0)
+		{
+			if (quadrantX == 1) { x = _size - 1 - x; y = _size - 1 - y; }
+			uint32_t temp = x; x = y; y = temp;
+		}
+	}
+
+	return index;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef TILESCHEDULER_H
+#define TILESCHEDULER_H
+
+// Threading includes.
+#include <atomic>
+
+// Utility includes.
+#include <vector>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Rendering
+{
+	/// <summary> The order in which tiles are handed out. </summary>
+	enum class TileOrder : uint8_t
+	{
+		/// <summary> Left to right, then top to bottom. </summary>
+		RowMajor,
+
+		/// <summary> Along a Z-order curve, keeping consecutive tiles close together. </summary>
+		Morton,
+
+		/// <summary> Along a Hilbert curve, where every consecutive tile shares an edge. </summary>
+		Hilbert
+	};
+
+	/// <summary> Represents a rectangular section of the screen. </summary>
+	struct Tile
+	{
+		/// <summary> The x position of the left edge in pixels. </summary>
+		uint16_t m_x;
+
+		/// <summary> The y position of the top edge in pixels. </summary>
+		uint16_t m_y;
+
+		/// <summary> The width in pixels. </summary>
+		uint16_t m_width;
+
+		/// <summary> The height in pixels. </summary>
+		uint16_t m_height;
+	};
+
+	/// <summary> Splits the screen into tiles and hands them out to any thread that asks, in a set order, until there are none left. </summary>
+	/// <remarks> Tiles are taken from a single atomic counter, so threads that draw cheap tiles simply take more of them. </remarks>
+	class TileScheduler
+	{
+	public:
+		TileScheduler(uint16_t, uint16_t, uint16_t, TileOrder, uint16_t _pixelSize = 1);
+
+		bool NextTile(Tile&);
+
+		/// <summary> Gets the number of tiles. </summary>
+		/// <returns> The total number of tiles covering the screen. </returns>
+		inline uint32_t GetTileCount() const { return (uint32_t)m_tiles.size(); }
+
+		/// <summary> Gets the width of every tile not on the right edge. </summary>
+		/// <returns> The width of a tile in pixels. </returns>
+		inline uint16_t GetTileWidth() const { return m_tileWidth; }
+
+		/// <summary> Gets the height of every tile not on the bottom edge. </summary>
+		/// <returns> The height of a tile in pixels. </returns>
+		inline uint16_t GetTileHeight() const { return m_tileHeight; }
+
+		/// <summary> The size of a cache line in bytes, tile widths are rounded so that no two tiles share a line. </summary>
+		static const uint16_t CacheLineSize = 64;
+
+		static uint32_t MortonIndex(uint16_t, uint16_t);
+
+		static uint32_t HilbertIndex(uint16_t, uint16_t, uint16_t);
+	private:
+		/// <summary> The width of a tile in pixels. </summary>
+		uint16_t m_tileWidth;
+
+		/// <summary> The height of a tile in pixels. </summary>
+		uint16_t m_tileHeight;
+
+		/// <summary> Every tile, in the order they are handed out. </summary>
+		std::vector<Tile> m_tiles;
+
+		/// <summary> The index of the next tile to hand out. </summary>
+		std::atomic<uint32_t> m_nextTile;
+	};
+}
+#endif
\ No newline at end of file
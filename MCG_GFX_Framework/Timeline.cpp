@@ -0,0 +1,82 @@
+#include "Timeline.h"
+
+// Utility includes.
+#include <fstream>
+#include <iomanip>
+
+/// <summary> The spans of the calling thread. </summary>
+thread_local Telemetry::Timeline::ThreadSpans* Telemetry::Timeline::t_spans = nullptr;
+
+/// <summary> Creates a disabled timeline that does not write anything, measured from now. </summary>
+Telemetry::Timeline::Timeline() : m_enabled(false), m_epoch(std::chrono::steady_clock::now()), m_frameCount(0), m_outputPrefix(), m_threads() { }
+
+/// <summary> Marks the end of a frame, writing its spans to the output prefix followed by the frame's number if there is one, then starting again with none. </summary>
+/// <returns> <c>false</c> if the trace could not be written; otherwise, <c>true</c>. </returns>
+bool Telemetry::Timeline::EndFrame()
+{
+	if (!IsEnabled()) { return true; }
+
+	// Take the path while nothing else can change it.
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(m_threadsMutex);
+		if (!m_outputPrefix.empty()) { path = m_outputPrefix + std::to_string(m_frameCount) + ".json"; }
+		m_frameCount++;
+	}
+
+	// Write the spans if there is somewhere to write them, otherwise just throw them away.
+	if (!path.empty()) { return WriteFrame(path); }
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+	for (std::unique_ptr<ThreadSpans>& thread : m_threads) { thread->m_spans.clear(); }
+	return true;
+}
+
+/// <summary> Writes every span recorded since the last frame ended to the given file as a Chrome trace, then starts again with none. </summary>
+/// <param name="_path"> The path of the file, which is replaced if it exists. </param>
+/// <returns> <c>true</c> if the whole file was written; otherwise, <c>false</c>. </returns>
+/// <remarks> Must only be called while no thread is recording, such as between frames. </remarks>
+bool Telemetry::Timeline::WriteFrame(const std::string& _path)
+{
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+	std::ofstream file(_path, std::ios::trunc);
+
+	// Name each thread, then write each of its spans as a complete event in microseconds since the epoch.
+	file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool isFirst = true;
+	for (std::unique_ptr<ThreadSpans>& thread : m_threads)
+	{
+		file << (isFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->m_threadIndex << ",\"args\":{\"name\":\"thread " << thread->m_threadIndex << "\"}}";
+		isFirst = false;
+
+		for (const Span& span : thread->m_spans)
+		{
+			file << ",\n{\"name\":\"" << span.m_name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->m_threadIndex
+				<< ",\"ts\":" << std::chrono::duration<double, std::micro>(span.m_start - m_epoch).count() << ",\"dur\":" << std::chrono::duration<double, std::micro>(span.m_end - span.m_start).count();
+			if (span.m_tile.m_width > 0) { file << ",\"args\":{\"x\":" << span.m_tile.m_x << ",\"y\":" << span.m_tile.m_y << ",\"width\":" << span.m_tile.m_width << ",\"height\":" << span.m_tile.m_height << "}"; }
+			file << "}";
+		}
+		thread->m_spans.clear();
+	}
+	file << "\n]}\n";
+
+	return (bool)file;
+}
+
+/// <summary> Gets the process-wide timeline, which starts disabled. </summary>
+/// <returns> The process-wide timeline. </returns>
+Telemetry::Timeline& Telemetry::Timeline::Get()
+{
+	static Timeline timeline;
+	return timeline;
+}
+
+/// <summary> Creates a list of spans for the calling thread and adds it to the list of threads written at the end of each frame. </summary>
+/// <returns> The calling thread's new list. </returns>
+Telemetry::Timeline::ThreadSpans* Telemetry::Timeline::registerThread()
+{
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+	m_threads.push_back(std::unique_ptr<ThreadSpans>(new ThreadSpans()));
+	m_threads.back()->m_threadIndex = (uint32_t)m_threads.size() - 1;
+	t_spans = m_threads.back().get();
+	return t_spans;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+// Data includes.
+#include "TileScheduler.h"
+
+// Threading includes.
+#include <atomic>
+#include <mutex>
+
+// Utility includes.
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Telemetry
+{
+	/// <summary> Represents a span of time that a thread spent on one piece of work. </summary>
+	struct Span
+	{
+		/// <summary> The name of the work, which must outlive the timeline, such as a string literal. </summary>
+		const char* m_name;
+
+		/// <summary> The time at which the work started. </summary>
+		std::chrono::steady_clock::time_point m_start;
+
+		/// <summary> The time at which the work finished. </summary>
+		std::chrono::steady_clock::time_point m_end;
+
+		/// <summary> The tile the work covered, or an empty tile if it did not cover one. </summary>
+		Rendering::Tile m_tile;
+	};
+
+	/// <summary> Collects spans of work from every thread, and writes each frame's spans as a Chrome trace that can be opened in <c>chrome://tracing</c> or Perfetto. </summary>
+	/// <remarks> Each thread adds to its own list of spans without locking. Defining <c>MCG_GFX_NO_TELEMETRY</c> removes it entirely. </remarks>
+	class Timeline
+	{
+	public:
+		Timeline();
+
+		/// <summary> Finds if spans are being recorded. </summary>
+		/// <returns> <c>true</c> if spans are being recorded; otherwise, <c>false</c>. </returns>
+		inline bool IsEnabled() const
+		{
+#ifdef MCG_GFX_NO_TELEMETRY
+			return false;
+#else
+			return m_enabled.load(std::memory_order_relaxed);
+#endif
+		}
+
+		/// <summary> Starts or stops recording spans. </summary>
+		/// <param name="_enabled"> <c>true</c> to record spans; otherwise, <c>false</c>. </param>
+		inline void SetEnabled(const bool _enabled) { m_enabled.store(_enabled, std::memory_order_relaxed); }
+
+		/// <summary> Adds the given span to the calling thread's list, if recording. </summary>
+		/// <param name="_span"> The span. </param>
+		inline void Add(const Span& _span)
+		{
+			if (!IsEnabled()) { return; }
+			((t_spans != nullptr) ? t_spans : registerThread())->m_spans.push_back(_span);
+		}
+
+		/// <summary> Sets the start of the path that each frame's trace is written to, followed by the frame's number and <c>.json</c>. </summary>
+		/// <param name="_prefix"> The start of the path, or empty to throw each frame's spans away. </param>
+		inline void SetOutputPrefix(const std::string& _prefix) { std::lock_guard<std::mutex> lock(m_threadsMutex); m_outputPrefix = _prefix; }
+
+		bool EndFrame();
+
+		bool WriteFrame(const std::string&);
+
+		static Timeline& Get();
+	private:
+		/// <summary> Represents the spans recorded by one thread. </summary>
+		struct ThreadSpans
+		{
+			/// <summary> The order in which the thread first recorded a span, used as its id within the trace. </summary>
+			uint32_t m_threadIndex;
+
+			/// <summary> The spans recorded since the last frame ended, which keep their memory between frames. </summary>
+			std::vector<Span> m_spans;
+		};
+
+		/// <summary> Whether spans are being recorded. </summary>
+		std::atomic<bool> m_enabled;
+
+		/// <summary> The time from which every span in the trace is measured. </summary>
+		std::chrono::steady_clock::time_point m_epoch;
+
+		/// <summary> The number of frames ended so far. </summary>
+		uint64_t m_frameCount;
+
+		/// <summary> The start of the path each frame's trace is written to, or empty for none. </summary>
+		std::string m_outputPrefix;
+
+		/// <summary> Guards the list of threads and the output, which are only touched when a thread first records and when a frame ends. </summary>
+		std::mutex m_threadsMutex;
+
+		/// <summary> The spans of every thread that has recorded one. </summary>
+		std::vector<std::unique_ptr<ThreadSpans>> m_threads;
+
+		/// <summary> The spans of the calling thread, or <c>nullptr</c> if it has not recorded one yet. </summary>
+		static thread_local ThreadSpans* t_spans;
+
+		ThreadSpans* registerThread();
+	};
+
+	/// <summary> Adds the time from its creation to its destruction to the timeline as a span, only reading the clock if recording. </summary>
+	class ScopedSpan
+	{
+	public:
+		/// <summary> Starts a span of the given work. </summary>
+		/// <param name="_name"> The name of the work, such as a string literal. </param>
+		ScopedSpan(const char* _name) : ScopedSpan(_name, { 0, 0, 0, 0 }) { }
+
+		/// <summary> Starts a span of the given work over the given tile. </summary>
+		/// <param name="_name"> The name of the work, such as a string literal. </param>
+		/// <param name="_tile"> The tile the work covers. </param>
+		ScopedSpan(const char* _name, const Rendering::Tile& _tile) : m_enabled(Timeline::Get().IsEnabled())
+		{
+			if (!m_enabled) { return; }
+			m_span.m_name = _name;
+			m_span.m_tile = _tile;
+			m_span.m_start = std::chrono::steady_clock::now();
+		}
+
+		/// <summary> Ends the span and adds it to the timeline. </summary>
+		~ScopedSpan() { if (m_enabled) { m_span.m_end = std::chrono::steady_clock::now(); Timeline::Get().Add(m_span); } }
+
+		ScopedSpan(const ScopedSpan&) = delete;
+
+		ScopedSpan& operator=(const ScopedSpan&) = delete;
+	private:
+		/// <summary> The span being timed. </summary>
+		Span m_span;
+
+		/// <summary> Whether recording was enabled when the span started. </summary>
+		bool m_enabled;
+	};
+}
+#endif
\ No newline at end of file
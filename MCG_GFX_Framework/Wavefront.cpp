@@ -0,0 +1,413 @@
+#include "Wavefront.h"
+
+// SIMD includes.
+#if defined(__AVX2__)
+#define WAVEFRONT_AVX2
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define WAVEFRONT_SSE2
+#include <emmintrin.h>
+#endif
+
+// Utility includes.
+#include <algorithm>
+#include <utility>
+
+/// <summary> Makes sure the queue has room for at least the given number of rays. </summary>
+/// <param name="_capacity"> The number of rays. </param>
+void Rendering::RayQueue::Reserve(const uint32_t _capacity)
+{
+	if (m_path.size() >= _capacity) { return; }
+	m_originX.resize(_capacity); m_originY.resize(_capacity); m_originZ.resize(_capacity);
+	m_directionX.resize(_capacity); m_directionY.resize(_capacity); m_directionZ.resize(_capacity);
+	m_distance.resize(_capacity);
+	m_sphereIndex.resize(_capacity);
+	m_path.resize(_capacity);
+}
+
+/// <summary> Makes sure the queue has room for the surfaces of at least the given number of rays. </summary>
+/// <param name="_capacity"> The number of rays. </param>
+void Rendering::SurfaceQueue::Reserve(const uint32_t _capacity)
+{
+	if (m_facing.size() >= _capacity) { return; }
+	m_positionX.resize(_capacity); m_positionY.resize(_capacity); m_positionZ.resize(_capacity);
+	m_normalX.resize(_capacity); m_normalY.resize(_capacity); m_normalZ.resize(_capacity);
+	m_facing.resize(_capacity);
+}
+
+/// <summary> Points the tracer at the given world, and empties its occluder cache as the spheres may have changed since it last drew. </summary>
+/// <param name="_camera"> The camera from which the primary rays are cast. </param>
+/// <param name="_spheres"> The spheres within the world. </param>
+/// <param name="_hierarchy"> The hierarchy built over the spheres. </param>
+/// <param name="_lightSource"> The world's light source. </param>
+void Rendering::WavefrontTracer::Bind(const Camera& _camera, const Shapes::SphereSet& _spheres, const Shapes::BoundingVolumeHierarchy& _hierarchy, const PointLight& _lightSource)
+{
+	m_camera = &_camera;
+	m_spheres = &_spheres;
+	m_hierarchy = &_hierarchy;
+	m_lightSource = &_lightSource;
+	m_occluderCache = Shapes::OccluderCache();
+}
+
+/// <summary> Draws the given tile of the screen onto the given buffer, averaging a grid of samples within each pixel, one wave of paths at a time. </summary>
+/// <param name="_tile"> The tile to draw. </param>
+/// <param name="_sampleLevel"> The width and height of the grid of samples within each pixel. </param>
+/// <param name="_packetSize"> The number of neighbouring rays of each queue to intersect together, or <c>1</c> to intersect each alone. </param>
+/// <param name="_termination"> When each path stops reflecting. </param>
+/// <param name="o_buffer"> The buffer object to which the output is drawn. </param>
+/// <param name="io_rayStats"> If given, every ray traced is counted here. </param>
+/// <param name="o_sphereIndices"> If given, the index of the sphere seen by each pixel is saved here, row by row, which is only meaningful with a single sample. </param>
+void Rendering::WavefrontTracer::DrawTile(const Tile& _tile, const uint8_t _sampleLevel, const uint8_t _packetSize, const PathTermination& _termination, Buffer& o_buffer, Telemetry::RayStats* io_rayStats, uint32_t* o_sphereIndices)
+{
+	// Group the pixels into blocks the shape of a packet, so that consecutive primary rays are close together.
+	uint32_t sampleLevel = glm::max(_sampleLevel, (uint8_t)1), sampleCount = sampleLevel * sampleLevel;
+	uint32_t blockWidth = (_packetSize > 1) ? Camera::GetPacketWidth(_packetSize) : 1, blockHeight = (_packetSize > 1) ? _packetSize / blockWidth : 1;
+	uint32_t blocksX = (_tile.m_width + blockWidth - 1) / blockWidth, blockCount = blocksX * ((_tile.m_height + blockHeight - 1) / blockHeight);
+	uint32_t tileRight = (uint32_t)_tile.m_x + _tile.m_width, tileBottom = (uint32_t)_tile.m_y + _tile.m_height;
+
+	// Each wave holds as many whole blocks as fit, with every sample of each block.
+	uint32_t blockPathCount = blockWidth * blockHeight * sampleCount;
+	uint32_t waveSize = glm::max(WaveSize, blockPathCount), blocksPerWave = waveSize / blockPathCount;
+	uint32_t tilePixelCount = (uint32_t)_tile.m_width * _tile.m_height;
+	reserve(waveSize, (sampleCount > 1) ? tilePixelCount : 0);
+	if (sampleCount > 1) { std::fill(m_squaredSums.begin(), m_squaredSums.begin() + tilePixelCount, glm::vec3(0.0f)); }
+
+	for (uint32_t firstBlock = 0; firstBlock < blockCount; firstBlock += blocksPerWave)
+	{
+		// Generate the primary ray of every sample within the wave's blocks, with each sample of a block laid out like a packet.
+		m_rays.Clear();
+		uint32_t lastBlock = glm::min(firstBlock + blocksPerWave, blockCount);
+		for (uint32_t block = firstBlock; block < lastBlock; block++)
+		{
+			uint32_t blockX = _tile.m_x + (block % blocksX) * blockWidth, blockY = _tile.m_y + (block / blocksX) * blockHeight;
+			for (uint32_t sampleY = 0; sampleY < sampleLevel; sampleY++)
+			{
+				for (uint32_t sampleX = 0; sampleX < sampleLevel; sampleX++)
+				{
+					for (uint32_t lane = 0; lane < blockWidth * blockHeight; lane++)
+					{
+						uint32_t x = blockX + lane % blockWidth, y = blockY + lane / blockWidth;
+						if (x >= tileRight || y >= tileBottom) { continue; }
+
+						uint32_t path = m_rays.m_count;
+						m_pathX[path] = (uint16_t)x;
+						m_pathY[path] = (uint16_t)y;
+						m_radiance[path] = glm::vec3(0.0f);
+						m_throughput[path] = 1.0f;
+						m_rays.Push(m_camera->CreateRay(glm::vec2(x + sampleX / (float_t)sampleLevel, y + sampleY / (float_t)sampleLevel)), path);
+					}
+				}
+			}
+		}
+		uint32_t pathCount = m_rays.m_count;
+		if (io_rayStats != nullptr) { io_rayStats->m_rays[(size_t)Telemetry::RayType::Primary] += pathCount; }
+
+		// Trace every ray of each bounce together, until no path has a reflection left to trace.
+		for (uint32_t depth = 0; m_rays.m_count > 0; depth++)
+		{
+			intersect(depth, _packetSize, io_rayStats);
+			if (depth == 0 && o_sphereIndices != nullptr) { for (uint32_t ray = 0; ray < m_rays.m_count; ray++) { o_sphereIndices[(size_t)m_pathY[m_rays.m_path[ray]] * o_buffer.GetWidth() + m_pathX[m_rays.m_path[ray]]] = m_rays.m_sphereIndex[ray]; } }
+			traceShadows(depth, _packetSize, io_rayStats);
+			shade(depth, _termination, io_rayStats);
+
+			// The reflections become the next bounce.
+			std::swap(m_rays, m_reflectionRays);
+			m_reflectionRays.Clear();
+		}
+
+		// Either save each path's radiance straight to its pixel or add it to the pixel's samples, which are summed in the same order as a pixel traced alone.
+		for (uint32_t path = 0; path < pathCount; path++)
+		{
+			const glm::vec3& sample = m_radiance[path];
+			if (sampleCount == 1) { o_buffer.SetPixel(m_pathX[path], m_pathY[path], sample); }
+			else { m_squaredSums[(uint32_t)(m_pathY[path] - _tile.m_y) * _tile.m_width + (m_pathX[path] - _tile.m_x)] += sample * sample; }
+		}
+	}
+
+	// With more than one sample, every pixel has all of its samples once every wave is done.
+	if (sampleCount > 1)
+	{
+		for (uint32_t y = 0; y < _tile.m_height; y++)
+		{
+			for (uint32_t x = 0; x < _tile.m_width; x++) { o_buffer.SetPixel((uint16_t)(_tile.m_x + x), (uint16_t)(_tile.m_y + y), glm::sqrt(m_squaredSums[y * _tile.m_width + x] / (float_t)sampleCount)); }
+		}
+	}
+}
+
+/// <summary> Makes sure every queue and path array has room for the given number of paths. </summary>
+/// <param name="_pathCount"> The number of paths within a wave. </param>
+/// <param name="_pixelCount"> The number of pixels whose samples are summed. </param>
+void Rendering::WavefrontTracer::reserve(const uint32_t _pathCount, const uint32_t _pixelCount)
+{
+	m_rays.Reserve(_pathCount);
+	m_shadowRays.Reserve(_pathCount);
+	m_reflectionRays.Reserve(_pathCount);
+	m_surfaces.Reserve(_pathCount);
+	if (m_pathX.size() < _pathCount)
+	{
+		m_isShadowed.resize(_pathCount);
+		m_pathX.resize(_pathCount);
+		m_pathY.resize(_pathCount);
+		m_radiance.resize(_pathCount);
+		m_throughput.resize(_pathCount);
+	}
+	if (m_squaredSums.size() < _pixelCount) { m_squaredSums.resize(_pixelCount); }
+}
+
+/// <summary> Finds the closest sphere hit by every ray of the current bounce. </summary>
+/// <param name="_depth"> The number of reflections made before this bounce. </param>
+/// <param name="_packetSize"> The number of neighbouring rays to intersect together, or <c>1</c> to intersect each alone. </param>
+/// <param name="io_rayStats"> If given, the tests, hits, and misses are counted here. </param>
+void Rendering::WavefrontTracer::intersect(const uint32_t _depth, const uint8_t _packetSize, Telemetry::RayStats* io_rayStats)
+{
+	uint64_t* testCount = (io_rayStats != nullptr) ? &io_rayStats->m_sphereTests : nullptr;
+	uint32_t first = 0;
+
+	// Primary rays were generated in the shape of packets, so trace them together, falling back to each ray alone if a packet diverges.
+	if (_depth == 0 && _packetSize > 1)
+	{
+		RayPacket packet;
+		packet.m_size = _packetSize;
+		packet.m_activeMask = (1u << _packetSize) - 1;
+		for (; first + _packetSize <= m_rays.m_count; first += _packetSize)
+		{
+			for (uint32_t lane = 0; lane < _packetSize; lane++) { packet.SetRay(lane, m_rays.GetRay(first + lane)); }
+			if (!m_hierarchy->IntersectPacket(*m_spheres, packet, testCount))
+			{
+				for (uint32_t lane = 0; lane < _packetSize; lane++) { Shapes::SphereHit hit; m_hierarchy->IntersectClosest(*m_spheres, m_rays.GetRay(first + lane), hit, UINT32_MAX, testCount); packet.m_distance[lane] = hit.m_distance; packet.m_index[lane] = hit.m_index; }
+			}
+			else if (io_rayStats != nullptr) { io_rayStats->m_packetRays += _packetSize; }
+
+			std::copy(packet.m_distance, packet.m_distance + _packetSize, m_rays.m_distance.begin() + first);
+			std::copy(packet.m_index, packet.m_index + _packetSize, m_rays.m_sphereIndex.begin() + first);
+		}
+	}
+
+	// Reflections scatter too far to bound together, but each is queued in the order of the ray it came from, so trace neighbouring reflections together with each testing every box on its own, falling back to each ray alone if they head different ways.
+	else if (_packetSize > 1)
+	{
+		RayPacket packet;
+		packet.m_size = _packetSize;
+		for (; first < m_rays.m_count; first += _packetSize)
+		{
+			uint32_t laneCount = glm::min((uint32_t)_packetSize, m_rays.m_count - first);
+			packet.m_activeMask = (1u << laneCount) - 1;
+			for (uint32_t lane = 0; lane < laneCount; lane++) { packet.SetRay(lane, m_rays.GetRay(first + lane)); }
+			if (!m_hierarchy->IntersectClosest(*m_spheres, packet, testCount))
+			{
+				for (uint32_t lane = 0; lane < laneCount; lane++) { Shapes::SphereHit hit; m_hierarchy->IntersectClosest(*m_spheres, m_rays.GetRay(first + lane), hit, UINT32_MAX, testCount); packet.m_distance[lane] = hit.m_distance; packet.m_index[lane] = hit.m_index; }
+			}
+			else if (io_rayStats != nullptr) { io_rayStats->m_packetRays += laneCount; }
+
+			std::copy(packet.m_distance, packet.m_distance + laneCount, m_rays.m_distance.begin() + first);
+			std::copy(packet.m_index, packet.m_index + laneCount, m_rays.m_sphereIndex.begin() + first);
+		}
+	}
+
+	// Trace any remaining rays alone.
+	for (uint32_t ray = first; ray < m_rays.m_count; ray++)
+	{
+		Shapes::SphereHit hit;
+		m_hierarchy->IntersectClosest(*m_spheres, m_rays.GetRay(ray), hit, UINT32_MAX, testCount);
+		m_rays.m_distance[ray] = hit.m_distance;
+		m_rays.m_sphereIndex[ray] = hit.m_index;
+	}
+
+	if (io_rayStats != nullptr) { for (uint32_t ray = 0; ray < m_rays.m_count; ray++) { if (m_rays.m_sphereIndex[ray] != UINT32_MAX) { io_rayStats->m_hits++; } else { io_rayStats->m_misses++; } } }
+}
+
+/// <summary> Queues a ray towards the light from every hit of the current bounce, then finds which are blocked. </summary>
+/// <param name="_depth"> The number of reflections made before this bounce. </param>
+/// <param name="_packetSize"> The number of neighbouring shadow rays to test together, or <c>1</c> to test each alone. </param>
+/// <param name="io_rayStats"> If given, every shadow ray is counted here, along with the depth of each path that ends in shadow. </param>
+void Rendering::WavefrontTracer::traceShadows(const uint32_t _depth, const uint8_t _packetSize, Telemetry::RayStats* io_rayStats)
+{
+	// Queue a shadow ray from each hit, remembering which ray it was cast from.
+	m_shadowRays.Clear();
+	for (uint32_t ray = 0; ray < m_rays.m_count; ray++)
+	{
+		m_isShadowed[ray] = 0;
+		if (m_rays.m_sphereIndex[ray] == UINT32_MAX) { continue; }
+
+		glm::vec3 intersection = glm::vec3(m_rays.m_originX[ray], m_rays.m_originY[ray], m_rays.m_originZ[ray]) + m_rays.m_distance[ray] * glm::vec3(m_rays.m_directionX[ray], m_rays.m_directionY[ray], m_rays.m_directionZ[ray]);
+		glm::vec3 toLight = m_lightSource->m_position - intersection;
+		float_t lightDistance = glm::length(toLight);
+		m_shadowRays.Push(Ray(intersection, toLight / lightDistance), ray, lightDistance, m_rays.m_sphereIndex[ray]);
+	}
+
+	// Neighbouring hits all cast towards the same light, so test their shadow rays together, with each testing every box on its own.
+	uint64_t* testCount = (io_rayStats != nullptr) ? &io_rayStats->m_sphereTests : nullptr;
+	if (_packetSize > 1)
+	{
+		RayPacket packet;
+		packet.m_size = _packetSize;
+		for (uint32_t first = 0; first < m_shadowRays.m_count; first += _packetSize)
+		{
+			// Each ray stops at the light and skips the sphere it leaves.
+			uint32_t laneCount = glm::min((uint32_t)_packetSize, m_shadowRays.m_count - first);
+			packet.m_activeMask = (1u << laneCount) - 1;
+			for (uint32_t lane = 0; lane < laneCount; lane++)
+			{
+				packet.SetRay(lane, m_shadowRays.GetRay(first + lane));
+				packet.m_distance[lane] = m_shadowRays.m_distance[first + lane];
+				packet.m_index[lane] = m_shadowRays.m_sphereIndex[first + lane];
+			}
+
+			uint32_t hitMask = m_hierarchy->IntersectAny(*m_spheres, packet, m_occluderCache, testCount);
+			for (uint32_t lane = 0; lane < laneCount; lane++) { setShadowed(first + lane, (hitMask & (1u << lane)) != 0, _depth, io_rayStats); }
+			if (io_rayStats != nullptr) { io_rayStats->m_packetRays += laneCount; }
+		}
+		return;
+	}
+
+	// Otherwise, test each shadow ray alone.
+	for (uint32_t shadowRay = 0; shadowRay < m_shadowRays.m_count; shadowRay++)
+	{
+		setShadowed(shadowRay, m_hierarchy->IntersectAny(*m_spheres, m_shadowRays.GetRay(shadowRay), m_shadowRays.m_distance[shadowRay], m_occluderCache, m_shadowRays.m_sphereIndex[shadowRay], testCount), _depth, io_rayStats);
+	}
+}
+
+/// <summary> Saves whether the hit a shadow ray was cast from is in shadow. </summary>
+/// <param name="_shadowRay"> The index of the shadow ray. </param>
+/// <param name="_isShadowed"> Whether the shadow ray was blocked before reaching the light. </param>
+/// <param name="_depth"> The number of reflections made before this bounce. </param>
+/// <param name="io_rayStats"> If given, the shadow ray is counted here, along with the depth of its path if it ends in shadow. </param>
+void Rendering::WavefrontTracer::setShadowed(const uint32_t _shadowRay, const bool _isShadowed, const uint32_t _depth, Telemetry::RayStats* io_rayStats)
+{
+	m_isShadowed[m_shadowRays.m_path[_shadowRay]] = _isShadowed ? 1 : 0;
+	if (io_rayStats != nullptr)
+	{
+		io_rayStats->m_rays[(size_t)Telemetry::RayType::Shadow]++;
+		if (_isShadowed) { io_rayStats->m_hits++; io_rayStats->AddDepth(_depth); } else { io_rayStats->m_misses++; }
+	}
+}
+
+/// <summary> Finds the position, normal, and facing towards the light of the hit of every ray of the current bounce, several rays at a time. </summary>
+/// <remarks>
+/// Uses exactly the same maths in the same order as <see cref="Shapes::Sphere::Shade"/>, so each surface matches the one a single ray would find.
+/// Rays that hit nothing are given meaningless surfaces rather than being skipped, so that every group of rays can be found at once.
+/// </remarks>
+void Rendering::WavefrontTracer::findSurfaces()
+{
+	// Gather the centre of each hit sphere into the normals, which the normals are then found from.
+	for (uint32_t ray = 0; ray < m_rays.m_count; ray++)
+	{
+		glm::vec3 centre = (m_rays.m_sphereIndex[ray] != UINT32_MAX) ? m_spheres->GetCentre(m_rays.m_sphereIndex[ray]) : glm::vec3(0.0f);
+		m_surfaces.m_normalX[ray] = centre.x; m_surfaces.m_normalY[ray] = centre.y; m_surfaces.m_normalZ[ray] = centre.z;
+	}
+
+	uint32_t ray = 0;
+#if defined(WAVEFRONT_AVX2)
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 lightX = _mm256_set1_ps(m_lightSource->m_position.x), lightY = _mm256_set1_ps(m_lightSource->m_position.y), lightZ = _mm256_set1_ps(m_lightSource->m_position.z);
+	for (; ray + 8 <= m_rays.m_count; ray += 8)
+	{
+		// Find each hit position along its ray.
+		__m256 distance = _mm256_loadu_ps(&m_rays.m_distance[ray]);
+		__m256 positionX = _mm256_add_ps(_mm256_loadu_ps(&m_rays.m_originX[ray]), _mm256_mul_ps(distance, _mm256_loadu_ps(&m_rays.m_directionX[ray])));
+		__m256 positionY = _mm256_add_ps(_mm256_loadu_ps(&m_rays.m_originY[ray]), _mm256_mul_ps(distance, _mm256_loadu_ps(&m_rays.m_directionY[ray])));
+		__m256 positionZ = _mm256_add_ps(_mm256_loadu_ps(&m_rays.m_originZ[ray]), _mm256_mul_ps(distance, _mm256_loadu_ps(&m_rays.m_directionZ[ray])));
+
+		// Normalise the direction from each centre to its hit.
+		__m256 normalX = _mm256_sub_ps(positionX, _mm256_loadu_ps(&m_surfaces.m_normalX[ray]));
+		__m256 normalY = _mm256_sub_ps(positionY, _mm256_loadu_ps(&m_surfaces.m_normalY[ray]));
+		__m256 normalZ = _mm256_sub_ps(positionZ, _mm256_loadu_ps(&m_surfaces.m_normalZ[ray]));
+		__m256 inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalX, normalX), _mm256_mul_ps(normalY, normalY)), _mm256_mul_ps(normalZ, normalZ))));
+		normalX = _mm256_mul_ps(normalX, inverseLength); normalY = _mm256_mul_ps(normalY, inverseLength); normalZ = _mm256_mul_ps(normalZ, inverseLength);
+
+		// Normalise the direction from each hit to the light, and find how much each normal faces it.
+		__m256 toLightX = _mm256_sub_ps(lightX, positionX), toLightY = _mm256_sub_ps(lightY, positionY), toLightZ = _mm256_sub_ps(lightZ, positionZ);
+		inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toLightX, toLightX), _mm256_mul_ps(toLightY, toLightY)), _mm256_mul_ps(toLightZ, toLightZ))));
+		toLightX = _mm256_mul_ps(toLightX, inverseLength); toLightY = _mm256_mul_ps(toLightY, inverseLength); toLightZ = _mm256_mul_ps(toLightZ, inverseLength);
+		__m256 facing = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalX, toLightX), _mm256_mul_ps(normalY, toLightY)), _mm256_mul_ps(normalZ, toLightZ));
+
+		_mm256_storeu_ps(&m_surfaces.m_positionX[ray], positionX); _mm256_storeu_ps(&m_surfaces.m_positionY[ray], positionY); _mm256_storeu_ps(&m_surfaces.m_positionZ[ray], positionZ);
+		_mm256_storeu_ps(&m_surfaces.m_normalX[ray], normalX); _mm256_storeu_ps(&m_surfaces.m_normalY[ray], normalY); _mm256_storeu_ps(&m_surfaces.m_normalZ[ray], normalZ);
+		_mm256_storeu_ps(&m_surfaces.m_facing[ray], facing);
+	}
+#elif defined(WAVEFRONT_SSE2)
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 lightX = _mm_set1_ps(m_lightSource->m_position.x), lightY = _mm_set1_ps(m_lightSource->m_position.y), lightZ = _mm_set1_ps(m_lightSource->m_position.z);
+	for (; ray + 4 <= m_rays.m_count; ray += 4)
+	{
+		// Find each hit position along its ray.
+		__m128 distance = _mm_loadu_ps(&m_rays.m_distance[ray]);
+		__m128 positionX = _mm_add_ps(_mm_loadu_ps(&m_rays.m_originX[ray]), _mm_mul_ps(distance, _mm_loadu_ps(&m_rays.m_directionX[ray])));
+		__m128 positionY = _mm_add_ps(_mm_loadu_ps(&m_rays.m_originY[ray]), _mm_mul_ps(distance, _mm_loadu_ps(&m_rays.m_directionY[ray])));
+		__m128 positionZ = _mm_add_ps(_mm_loadu_ps(&m_rays.m_originZ[ray]), _mm_mul_ps(distance, _mm_loadu_ps(&m_rays.m_directionZ[ray])));
+
+		// Normalise the direction from each centre to its hit.
+		__m128 normalX = _mm_sub_ps(positionX, _mm_loadu_ps(&m_surfaces.m_normalX[ray]));
+		__m128 normalY = _mm_sub_ps(positionY, _mm_loadu_ps(&m_surfaces.m_normalY[ray]));
+		__m128 normalZ = _mm_sub_ps(positionZ, _mm_loadu_ps(&m_surfaces.m_normalZ[ray]));
+		__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, normalX), _mm_mul_ps(normalY, normalY)), _mm_mul_ps(normalZ, normalZ))));
+		normalX = _mm_mul_ps(normalX, inverseLength); normalY = _mm_mul_ps(normalY, inverseLength); normalZ = _mm_mul_ps(normalZ, inverseLength);
+
+		// Normalise the direction from each hit to the light, and find how much each normal faces it.
+		__m128 toLightX = _mm_sub_ps(lightX, positionX), toLightY = _mm_sub_ps(lightY, positionY), toLightZ = _mm_sub_ps(lightZ, positionZ);
+		inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toLightX, toLightX), _mm_mul_ps(toLightY, toLightY)), _mm_mul_ps(toLightZ, toLightZ))));
+		toLightX = _mm_mul_ps(toLightX, inverseLength); toLightY = _mm_mul_ps(toLightY, inverseLength); toLightZ = _mm_mul_ps(toLightZ, inverseLength);
+		__m128 facing = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, toLightX), _mm_mul_ps(normalY, toLightY)), _mm_mul_ps(normalZ, toLightZ));
+
+		_mm_storeu_ps(&m_surfaces.m_positionX[ray], positionX); _mm_storeu_ps(&m_surfaces.m_positionY[ray], positionY); _mm_storeu_ps(&m_surfaces.m_positionZ[ray], positionZ);
+		_mm_storeu_ps(&m_surfaces.m_normalX[ray], normalX); _mm_storeu_ps(&m_surfaces.m_normalY[ray], normalY); _mm_storeu_ps(&m_surfaces.m_normalZ[ray], normalZ);
+		_mm_storeu_ps(&m_surfaces.m_facing[ray], facing);
+	}
+#endif
+
+	// Find any remaining surfaces, or every surface without SIMD, one at a time.
+	for (; ray < m_rays.m_count; ray++)
+	{
+		Ray currentRay = m_rays.GetRay(ray);
+		glm::vec3 intersection = currentRay.m_origin + m_rays.m_distance[ray] * currentRay.m_direction;
+		glm::vec3 intersectionNormal = glm::normalize(intersection - m_surfaces.GetNormal(ray));
+		glm::vec3 directionToLight = glm::normalize(m_lightSource->m_position - intersection);
+		m_surfaces.m_positionX[ray] = intersection.x; m_surfaces.m_positionY[ray] = intersection.y; m_surfaces.m_positionZ[ray] = intersection.z;
+		m_surfaces.m_normalX[ray] = intersectionNormal.x; m_surfaces.m_normalY[ray] = intersectionNormal.y; m_surfaces.m_normalZ[ray] = intersectionNormal.z;
+		m_surfaces.m_facing[ray] = glm::dot(intersectionNormal, directionToLight);
+	}
+}
+
+/// <summary> Shades every ray of the current bounce, ending each path that misses, is in shadow, or has reached the reflection limit, and queuing a reflection ray for the rest. </summary>
+/// <param name="_depth"> The number of reflections made before this bounce. </param>
+/// <param name="_termination"> When each path stops reflecting. </param>
+/// <param name="io_rayStats"> If given, every reflection ray, dropped reflection, and ended path is counted here. </param>
+/// <remarks> Each hit adds to its path's radiance exactly as <see cref="Camera::TraceRay"/> would, scaled by the path's throughput. </remarks>
+void Rendering::WavefrontTracer::shade(const uint32_t _depth, const PathTermination& _termination, Telemetry::RayStats* io_rayStats)
+{
+	// Find every surface at once, then finish each path on its own.
+	findSurfaces();
+	for (uint32_t ray = 0; ray < m_rays.m_count; ray++)
+	{
+		uint32_t path = m_rays.m_path[ray];
+
+		// A ray that hit nothing ends with the background, and one in shadow ends with nothing more added.
+		if (m_rays.m_sphereIndex[ray] == UINT32_MAX) { m_radiance[path] += Camera::GetBackgroundRadiance() * m_throughput[path]; if (io_rayStats != nullptr) { io_rayStats->AddDepth(_depth); } continue; }
+		if (m_isShadowed[ray] != 0) { continue; }
+
+		// Shade the hit once from its surface, exactly as a single ray would.
+		Ray currentRay = m_rays.GetRay(ray);
+		Shapes::Sphere intersectedSphere = m_spheres->GetSphere(m_rays.m_sphereIndex[ray]);
+		glm::vec3 intersection = m_surfaces.GetPosition(ray);
+		glm::vec3 intersectionNormal = m_surfaces.GetNormal(ray);
+		glm::vec3 shade = intersectedSphere.Shade(m_surfaces.m_facing[ray], *m_lightSource);
+
+		// If the sphere is reflective and the limit has not been reached, keep the inverse reflectiveness of the shade and queue the reflection if the path survives it.
+		float_t reflectiveness = intersectedSphere.m_properties.m_reflectiveness;
+		if (reflectiveness > 0.0f && _depth < _termination.m_reflectionLimit)
+		{
+			m_radiance[path] += shade * (m_throughput[path] * (1.0f - reflectiveness));
+
+			glm::vec3 reflectionNormal = 2.0f * glm::dot(-currentRay.m_direction, intersectionNormal) * intersectionNormal + currentRay.m_direction;
+			m_throughput[path] *= reflectiveness;
+			if (!_termination.Survives(m_throughput[path], reflectionNormal, _depth)) { if (io_rayStats != nullptr) { io_rayStats->m_terminations++; io_rayStats->AddDepth(_depth); } continue; }
+			m_reflectionRays.Push(Ray(intersection, reflectionNormal), path);
+			if (io_rayStats != nullptr) { io_rayStats->m_rays[(size_t)Telemetry::RayType::Reflection]++; }
+			continue;
+		}
+
+		// Otherwise, the path ends with the full shade, counting a reflection that was cut off by the limit.
+		if (io_rayStats != nullptr) { if (reflectiveness > 0.0f) { io_rayStats->m_cutoffs++; } io_rayStats->AddDepth(_depth); }
+		m_radiance[path] += shade * m_throughput[path];
+	}
+}
\ No newline at end of file
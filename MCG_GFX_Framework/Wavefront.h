@@ -0,0 +1,213 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+// Framework includes.
+#include <glm.hpp>
+
+// Data includes.
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Camera.h"
+#include "SphereSet.h"
+#include "BoundingVolumeHierarchy.h"
+#include "PointLight.h"
+#include "Buffer.h"
+#include "TileScheduler.h"
+#include "RenderSettings.h"
+
+// Diagnostic includes.
+#include "Telemetry.h"
+
+// Utility includes.
+#include <vector>
+
+// Typedef includes.
+#include <stdint.h>
+#include <cmath>
+
+namespace Rendering
+{
+	/// <summary> Represents a queue of rays stored as a structure of arrays, each belonging to a path. </summary>
+	/// <remarks> The arrays are sized once and reused, so pushing never allocates. </remarks>
+	struct RayQueue
+	{
+		/// <summary> Creates an empty queue with no room. </summary>
+		RayQueue() : m_count(0) { }
+
+		/// <summary> The x position of each origin. </summary>
+		std::vector<float_t> m_originX;
+
+		/// <summary> The y position of each origin. </summary>
+		std::vector<float_t> m_originY;
+
+		/// <summary> The z position of each origin. </summary>
+		std::vector<float_t> m_originZ;
+
+		/// <summary> The x component of each normalised direction. </summary>
+		std::vector<float_t> m_directionX;
+
+		/// <summary> The y component of each normalised direction. </summary>
+		std::vector<float_t> m_directionY;
+
+		/// <summary> The z component of each normalised direction. </summary>
+		std::vector<float_t> m_directionZ;
+
+		/// <summary> The distance to the closest hit of each ray, or for a shadow ray the distance to the light. </summary>
+		std::vector<float_t> m_distance;
+
+		/// <summary> The index within the set of the closest sphere hit by each ray, or for a shadow ray the sphere it leaves. </summary>
+		std::vector<uint32_t> m_sphereIndex;
+
+		/// <summary> The path each ray belongs to, or for a shadow ray the index of the ray it was cast from. </summary>
+		std::vector<uint32_t> m_path;
+
+		/// <summary> The number of rays within the queue. </summary>
+		uint32_t m_count;
+
+		void Reserve(uint32_t);
+
+		/// <summary> Empties the queue, keeping its room. </summary>
+		inline void Clear() { m_count = 0; }
+
+		/// <summary> Adds the given ray to the end of the queue. </summary>
+		/// <param name="_ray"> The ray, with a normalised direction. </param>
+		/// <param name="_path"> The path the ray belongs to. </param>
+		/// <param name="_distance"> The starting distance, <c>INFINITY</c> for a ray that has not been traced. </param>
+		/// <param name="_sphereIndex"> The starting sphere index, <c>UINT32_MAX</c> for a ray that has not been traced. </param>
+		inline void Push(const Ray& _ray, const uint32_t _path, const float_t _distance = INFINITY, const uint32_t _sphereIndex = UINT32_MAX)
+		{
+			m_originX[m_count] = _ray.m_origin.x; m_originY[m_count] = _ray.m_origin.y; m_originZ[m_count] = _ray.m_origin.z;
+			m_directionX[m_count] = _ray.m_direction.x; m_directionY[m_count] = _ray.m_direction.y; m_directionZ[m_count] = _ray.m_direction.z;
+			m_distance[m_count] = _distance;
+			m_sphereIndex[m_count] = _sphereIndex;
+			m_path[m_count] = _path;
+			m_count++;
+		}
+
+		/// <summary> Gets the given ray on its own. </summary>
+		/// <param name="_index"> The index of the ray within the queue. </param>
+		/// <returns> The ray. </returns>
+		inline Ray GetRay(const uint32_t _index) const { return Ray(glm::vec3(m_originX[_index], m_originY[_index], m_originZ[_index]), glm::vec3(m_directionX[_index], m_directionY[_index], m_directionZ[_index])); }
+	};
+
+	/// <summary> Represents the surface at the hit of each ray of a bounce, stored as a structure of arrays so that several can be found at once. </summary>
+	/// <remarks> The arrays are sized once and reused, and are indexed the same as the rays they belong to. </remarks>
+	struct SurfaceQueue
+	{
+		/// <summary> The x position of each hit. </summary>
+		std::vector<float_t> m_positionX;
+
+		/// <summary> The y position of each hit. </summary>
+		std::vector<float_t> m_positionY;
+
+		/// <summary> The z position of each hit. </summary>
+		std::vector<float_t> m_positionZ;
+
+		/// <summary> The x component of each normal, which holds the centre of the hit sphere until the normal is found. </summary>
+		std::vector<float_t> m_normalX;
+
+		/// <summary> The y component of each normal, which holds the centre of the hit sphere until the normal is found. </summary>
+		std::vector<float_t> m_normalY;
+
+		/// <summary> The z component of each normal, which holds the centre of the hit sphere until the normal is found. </summary>
+		std::vector<float_t> m_normalZ;
+
+		/// <summary> The dot product of each normal and the direction towards the light. </summary>
+		std::vector<float_t> m_facing;
+
+		void Reserve(uint32_t);
+
+		/// <summary> Gets the given position on its own. </summary>
+		/// <param name="_index"> The index of the ray whose hit it is. </param>
+		/// <returns> The position. </returns>
+		inline glm::vec3 GetPosition(const uint32_t _index) const { return glm::vec3(m_positionX[_index], m_positionY[_index], m_positionZ[_index]); }
+
+		/// <summary> Gets the given normal on its own. </summary>
+		/// <param name="_index"> The index of the ray whose hit it is. </param>
+		/// <returns> The normalised normal. </returns>
+		inline glm::vec3 GetNormal(const uint32_t _index) const { return glm::vec3(m_normalX[_index], m_normalY[_index], m_normalZ[_index]); }
+	};
+
+	/// <summary> Draws tiles as a stream of rays, tracing every ray of one bounce before any ray of the next rather than following each path to its end. </summary>
+	/// <remarks>
+	/// Each wave of paths runs in stages: the primary rays are generated into a queue, the whole queue is intersected, a shadow ray is queued for every hit and tested,
+	/// and then every hit is shaded in bulk, queuing a reflection ray for each reflective one. The reflections become the next queue, until no rays remain.
+	/// Neighbouring primary rays are traced through the hierarchy as packets bounded as a whole. Shadow and reflection rays scatter too far for that, so neighbouring ones share
+	/// each traversal with every box tested against each ray on its own, and reflections heading different ways are traced alone. The position, normal, and lighting of every hit
+	/// are then found several at a time with SIMD before each path is shaded.
+	/// Each path carries its radiance and throughput between bounces, adding to them in the same order as <see cref="Camera::TraceRay"/>, so the image is identical when each ray is traced alone, and within the tolerance of <see cref="Camera::TracePacket"/> when packets are used.
+	/// Each thread keeps its own tracer from frame to frame, binding it to the world before each frame, so the queues are only allocated once.
+	/// </remarks>
+	class WavefrontTracer
+	{
+	public:
+		/// <summary> Creates a tracer with empty queues, which must be bound to a world before it draws. </summary>
+		WavefrontTracer() : m_camera(nullptr), m_spheres(nullptr), m_hierarchy(nullptr), m_lightSource(nullptr), m_occluderCache(), m_rays(), m_shadowRays(), m_reflectionRays(),
+			m_surfaces(), m_isShadowed(), m_pathX(), m_pathY(), m_radiance(), m_throughput(), m_squaredSums() { }
+
+		void Bind(const Camera&, const Shapes::SphereSet&, const Shapes::BoundingVolumeHierarchy&, const PointLight&);
+
+		void DrawTile(const Tile&, uint8_t, uint8_t, const PathTermination&, Buffer&, Telemetry::RayStats* io_rayStats = nullptr, uint32_t* o_sphereIndices = nullptr);
+
+		/// <summary> The number of paths traced together in each wave, unless a single block of pixels needs more. </summary>
+		static const uint32_t WaveSize = 4096;
+	private:
+		/// <summary> The camera from which the primary rays are cast. </summary>
+		const Camera* m_camera;
+
+		/// <summary> The spheres within the world. </summary>
+		const Shapes::SphereSet* m_spheres;
+
+		/// <summary> The hierarchy built over the spheres. </summary>
+		const Shapes::BoundingVolumeHierarchy* m_hierarchy;
+
+		/// <summary> The world's light source. </summary>
+		const PointLight* m_lightSource;
+
+		/// <summary> The last sphere to block a shadow ray, kept between waves. </summary>
+		Shapes::OccluderCache m_occluderCache;
+
+		/// <summary> The rays of the current bounce. </summary>
+		RayQueue m_rays;
+
+		/// <summary> The shadow rays cast from the hits of the current bounce. </summary>
+		RayQueue m_shadowRays;
+
+		/// <summary> The reflection rays cast from the hits of the current bounce, which become the next bounce. </summary>
+		RayQueue m_reflectionRays;
+
+		/// <summary> The surface at the hit of each ray of the current bounce. </summary>
+		SurfaceQueue m_surfaces;
+
+		/// <summary> Whether the hit of each ray of the current bounce is in shadow. </summary>
+		std::vector<uint8_t> m_isShadowed;
+
+		/// <summary> The x position of the pixel of each path. </summary>
+		std::vector<uint16_t> m_pathX;
+
+		/// <summary> The y position of the pixel of each path. </summary>
+		std::vector<uint16_t> m_pathY;
+
+		/// <summary> The radiance gathered so far along each path. </summary>
+		std::vector<glm::vec3> m_radiance;
+
+		/// <summary> The product of the reflectiveness of every surface along each path so far, which scales the radiance of the next hit. </summary>
+		std::vector<float_t> m_throughput;
+
+		/// <summary> The summed squared radiance of the samples of each pixel within the tile, row by row. </summary>
+		std::vector<glm::vec3> m_squaredSums;
+
+		void reserve(uint32_t, uint32_t);
+
+		void intersect(uint32_t, uint8_t, Telemetry::RayStats*);
+
+		void traceShadows(uint32_t, uint8_t, Telemetry::RayStats*);
+
+		void setShadowed(uint32_t, bool, uint32_t, Telemetry::RayStats*);
+
+		void findSurfaces();
+
+		void shade(uint32_t, const PathTermination&, Telemetry::RayStats*);
+	};
+}
+#endif
\ No newline at end of file
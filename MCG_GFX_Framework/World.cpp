@@ -1,73 +1,381 @@
 #include "World.h"
 
-// Framework includes.
-#include "MCG_GFX_Lib.h"
-
 // Threading includes.
-#include <thread>
+#include "ThreadPool.h"
+#include <atomic>
 
 // Utility includes.
-#include <iostream>
+#include <chrono>
+
+// Diagnostic includes.
+#include "Telemetry.h"
+#include "Timeline.h"
+
+/// <summary> Creates a world of the given scene with the given window size for the camera. </summary>
+/// <param name="_windowSize"> The size of the camera's viewport in pixels. </param>
+/// <param name="_scene"> The scene holding the camera, light, and spheres. </param>
+/// <param name="_buildMethod"> The method with which to build the hierarchy over the spheres. </param>
+World::World(const glm::vec2 _windowSize, const Scenes::Scene& _scene, const Shapes::BuildMethod _buildMethod) : m_lightSource(_scene.m_light), m_spheres(), m_camera(Rendering::Camera::FromLookAt(_windowSize, _scene.m_camera.m_position, _scene.m_camera.m_lookAt, _scene.m_camera.m_fieldOfView)), m_drawStats()
+{
+	initialiseSpheres(_scene, _buildMethod);
+}
+
+/// <summary> Creates a world that traces straight from the given mapped scene, with the given window size for the camera. </summary>
+/// <remarks> If the scene was saved without a hierarchy, its spheres are copied out and one is built over them. </remarks>
+/// <param name="_windowSize"> The size of the camera's viewport in pixels. </param>
+/// <param name="_scene"> The mapped scene holding the camera, light, spheres, and hierarchy, which stays mapped for as long as the world uses it. </param>
+/// <param name="_buildMethod"> The method with which to build the hierarchy if the scene has none. </param>
+World::World(const glm::vec2 _windowSize, const Scenes::MappedScene& _scene, const Shapes::BuildMethod _buildMethod) : m_lightSource(_scene.GetLight()), m_spheres(), m_camera(Rendering::Camera::FromLookAt(_windowSize, _scene.GetCamera().m_position, _scene.GetCamera().m_lookAt, _scene.GetCamera().m_fieldOfView)), m_drawStats()
+{
+	m_sphereSet = _scene.CreateSphereSet();
+	m_hierarchy = _scene.CreateHierarchy();
+	if (!_scene.HasHierarchy()) { unmapSpheres(_buildMethod); }
+}
+
+/// <summary> Draws everything in the world, split into tiles across the given number of threads from the thread pool. </summary>
+/// <param name="_settings"> The settings controlling the threads, tiles, and samples used. </param>
+/// <param name="o_target"> If given, the target to which each tile is also copied as soon as it is drawn. </param>
+/// <param name="o_costMap"> If given, cleared and then filled with the cost of each pixel. Must be the same size as the camera. </param>
+/// <returns> A radiance buffer with the rendered scene. </returns>
+Buffer& World::Draw(const Rendering::RenderSettings& _settings, Rendering::FrameTarget* o_target, Telemetry::CostMap* o_costMap)
+{
+	Telemetry::ScopedSpan drawSpan("draw");
+	if (o_costMap != nullptr) { o_costMap->Clear(); }
+
+	// Adaptive sampling needs every first sample before it can find the edges, so it is drawn in two passes.
+	if (_settings.m_sampleMode == Rendering::SampleMode::Adaptive && _settings.m_sampleLevel > 1) { return drawAdaptive(_settings, o_target, o_costMap); }
+	m_drawStats.m_refinedPixelCount = (_settings.m_sampleLevel > 1) ? m_camera.GetWidth() * m_camera.GetHeight() : 0;
+	m_drawStats.m_sampleMilliseconds = 0;
+	std::chrono::steady_clock::time_point renderTimer = std::chrono::steady_clock::now();
+
+	// Create a buffer to hold the radiance.
+	Buffer* buffer = new Buffer(m_camera.GetWidth(), m_camera.GetHeight());
+
+	// Split the screen into tiles.
+	Rendering::TileScheduler scheduler(buffer->GetWidth(), buffer->GetHeight(), _settings.m_tileSize, _settings.m_tileOrder, sizeof(glm::vec3));
+
+	// Have each thread keep drawing tiles until there are none left, returning once they have all finished.
+	Rendering::WavefrontTracer* tracers = bindTracers(_settings);
+	Threading::ThreadPool::Get().ParallelFor(_settings.GetThreadCount(), [this, &scheduler, &_settings, buffer, o_target, o_costMap, tracers](uint32_t _thread)
+	{
+		Rendering::Tile tile;
+		Telemetry::RayStats* rayStats = Telemetry::Recorder::Get().GetRayStats();
+		Rendering::WavefrontTracer* tracer = (tracers != nullptr) ? &tracers[_thread] : nullptr;
+		while (scheduler.NextTile(tile))
+		{
+			Telemetry::ScopedSpan tileSpan("tile", tile);
+			drawTile(tile, _settings.m_sampleLevel, _settings.m_packetSize, _settings.m_termination, *buffer, rayStats, o_costMap, nullptr, tracer);
+			if (o_target != nullptr) { buffer->CopyTile(tile, *o_target, _settings.m_toneMapping); }
+		}
+	});
+	std::chrono::steady_clock::duration renderTime = std::chrono::steady_clock::now() - renderTimer;
+	m_drawStats.m_renderMilliseconds = std::chrono::duration<double, std::milli>(renderTime).count();
+
+	// Record the time taken and the work done.
+	uint64_t pixelCount = (uint64_t)buffer->GetWidth() * buffer->GetHeight();
+	Telemetry::Recorder& telemetry = Telemetry::Recorder::Get();
+	telemetry.AddTime(Telemetry::Phase::Render, renderTime);
+	telemetry.Add(Telemetry::Counter::PixelsWritten, pixelCount);
+	telemetry.Add(Telemetry::Counter::RefinedPixels, m_drawStats.m_refinedPixelCount);
+
+	// Dereference and return the buffer.
+	return *buffer;
+}
 
-/// <summary> Draws everything in the world using the given number of threads. </summary>
-/// <param name="_threadAmount"> The amount of threads to use. </param>
-/// <returns> A colour buffer with the rendered scene. </returns>
-Buffer& World::Draw(const uint8_t _threadAmount)
-{	
-	// Track each thread.
-	std::vector<std::thread> threads(_threadAmount);
+/// <summary> Makes sure there is a wavefront tracer for each thread of the given settings, and binds each to this world as it may have been copied since the last draw. </summary>
+/// <param name="_settings"> The settings controlling the threads and how paths are traced. </param>
+/// <returns> The tracer of each thread, indexed by its task, or <c>nullptr</c> if each path is followed to its end in turn. </returns>
+Rendering::WavefrontTracer* World::bindTracers(const Rendering::RenderSettings& _settings)
+{
+	if (_settings.m_traceMode != Rendering::TraceMode::Wavefront) { return nullptr; }
+	if (m_tracers.size() < _settings.GetThreadCount()) { m_tracers.resize(_settings.GetThreadCount()); }
+	for (Rendering::WavefrontTracer& tracer : m_tracers) { tracer.Bind(m_camera, m_sphereSet, m_hierarchy, m_lightSource); }
+	return m_tracers.data();
+}
 
-	// Create a buffer to hold the colours.
+/// <summary> Draws everything in the world with one sample per pixel, then traces the rest of the samples only for the pixels that differ from their neighbours. </summary>
+/// <param name="_settings"> The settings controlling the threads, tiles, samples, and edge threshold used. </param>
+/// <param name="o_target"> If given, the target to which each tile is also copied as soon as it is refined. </param>
+/// <param name="o_costMap"> If given, the cost of each pixel over both passes is added here. </param>
+/// <returns> A radiance buffer with the rendered scene. </returns>
+Buffer& World::drawAdaptive(const Rendering::RenderSettings& _settings, Rendering::FrameTarget* o_target, Telemetry::CostMap* o_costMap)
+{
+	// Create a buffer for the first sample of each pixel along with the sphere it saw, and a buffer for the output.
+	std::chrono::steady_clock::time_point renderTimer = std::chrono::steady_clock::now();
+	Buffer* firstSamples = new Buffer(m_camera.GetWidth(), m_camera.GetHeight());
+	std::vector<uint32_t> sphereIndices((size_t)firstSamples->GetWidth() * firstSamples->GetHeight());
 	Buffer* buffer = new Buffer(m_camera.GetWidth(), m_camera.GetHeight());
 
-	// Begin each thread and add them to the vector.
-	for (uint8_t t = 0; t < _threadAmount; t++)
+	// Trace the first sample of every pixel.
+	Rendering::TileScheduler firstScheduler(buffer->GetWidth(), buffer->GetHeight(), _settings.m_tileSize, _settings.m_tileOrder, sizeof(glm::vec3));
+	Rendering::WavefrontTracer* tracers = bindTracers(_settings);
+	Threading::ThreadPool::Get().ParallelFor(_settings.GetThreadCount(), [this, &firstScheduler, &_settings, firstSamples, &sphereIndices, o_costMap, tracers](uint32_t _thread)
+	{
+		Rendering::Tile tile;
+		Telemetry::RayStats* rayStats = Telemetry::Recorder::Get().GetRayStats();
+		Rendering::WavefrontTracer* tracer = (tracers != nullptr) ? &tracers[_thread] : nullptr;
+		while (firstScheduler.NextTile(tile)) { Telemetry::ScopedSpan tileSpan("first sample tile", tile); drawTile(tile, 1, _settings.m_packetSize, _settings.m_termination, *firstSamples, rayStats, o_costMap, sphereIndices.data(), tracer); }
+	});
+	std::chrono::steady_clock::duration renderTime = std::chrono::steady_clock::now() - renderTimer;
+	m_drawStats.m_renderMilliseconds = std::chrono::duration<double, std::milli>(renderTime).count();
+
+	// Refine the edges, counting how many pixels were refined.
+	std::chrono::steady_clock::time_point sampleTimer = std::chrono::steady_clock::now();
+	std::atomic<uint32_t> refinedPixelCount(0);
+	Rendering::TileScheduler refineScheduler(buffer->GetWidth(), buffer->GetHeight(), _settings.m_tileSize, _settings.m_tileOrder, sizeof(glm::vec3));
+	Threading::ThreadPool::Get().ParallelFor(_settings.GetThreadCount(), [this, &refineScheduler, &_settings, firstSamples, &sphereIndices, buffer, o_target, o_costMap, &refinedPixelCount](uint32_t)
+	{
+		Rendering::Tile tile;
+		Telemetry::RayStats* rayStats = Telemetry::Recorder::Get().GetRayStats();
+		while (refineScheduler.NextTile(tile))
+		{
+			Telemetry::ScopedSpan tileSpan("refine tile", tile);
+			refinedPixelCount += refineTile(tile, _settings, *firstSamples, sphereIndices, *buffer, rayStats, o_costMap);
+			if (o_target != nullptr) { buffer->CopyTile(tile, *o_target, _settings.m_toneMapping); }
+		}
+	});
+	std::chrono::steady_clock::duration sampleTime = std::chrono::steady_clock::now() - sampleTimer;
+	m_drawStats.m_refinedPixelCount = refinedPixelCount;
+	m_drawStats.m_sampleMilliseconds = std::chrono::duration<double, std::milli>(sampleTime).count();
+
+	// Record the time taken and the work done.
+	uint64_t pixelCount = (uint64_t)buffer->GetWidth() * buffer->GetHeight();
+	Telemetry::Recorder& telemetry = Telemetry::Recorder::Get();
+	telemetry.AddTime(Telemetry::Phase::Render, renderTime);
+	telemetry.AddTime(Telemetry::Phase::Sample, sampleTime);
+	telemetry.Add(Telemetry::Counter::PixelsWritten, pixelCount);
+	telemetry.Add(Telemetry::Counter::RefinedPixels, m_drawStats.m_refinedPixelCount);
+
+	// Now that the edges have been found, delete the first samples and return the output.
+	delete firstSamples;
+	return *buffer;
+}
+
+/// <summary> Moves and resizes the given spheres, then refits the hierarchy around them, rebuilding it if it has degraded too far. </summary>
+/// <param name="_updates"> The new centre and radius of each changed sphere, indexed as they were created. Updates to an index past the last sphere are ignored. </param>
+/// <param name="_rebuildRatio"> How many times the cost of the freshly built hierarchy the refit hierarchy may cost before it is rebuilt, or <c>0</c> to never rebuild. </param>
+/// <returns> The time taken to refit, the number of nodes refit, and whether the hierarchy was rebuilt. </returns>
+Shapes::RefitStats World::UpdateSpheres(const std::vector<Shapes::SphereUpdate>& _updates, const float_t _rebuildRatio)
+{
+	// Mapped spheres cannot be changed, so they are copied out first.
+	if (m_sphereSet.IsMapped()) { unmapSpheres(m_hierarchy.GetBuildStats().m_method); }
+
+	// Change each sphere, and save where it is within the set.
+	m_changedSpheres.clear();
+	for (uint32_t i = 0; i < _updates.size(); i++)
 	{
-		threads[t] = std::thread(&World::drawSection, this, t, _threadAmount, std::ref(*buffer));
+		const Shapes::SphereUpdate& update = _updates[i];
+		if (update.m_index >= m_spheres.size()) { continue; }
+		m_spheres[update.m_index].m_centre = update.m_centre;
+		m_spheres[update.m_index].m_radius = update.m_radius;
+
+		uint32_t setIndex = m_sphereSet.GetSetIndex(update.m_index);
+		m_sphereSet.Move(setIndex, update.m_centre, update.m_radius);
+		m_changedSpheres.push_back(setIndex);
 	}
 
-	// Wait for each thread to be done before returning.
-	for (uint8_t t = 0; t < _threadAmount; t++)
+	// Refit the hierarchy around the changed spheres.
+	return m_hierarchy.Refit(m_sphereSet, m_changedSpheres, _rebuildRatio);
+}
+
+/// <summary> Draws the given tile of the screen onto the given buffer, averaging a grid of samples within each pixel. </summary>
+/// <param name="_tile"> The tile to draw. </param>
+/// <param name="_sampleLevel"> The width and height of the grid of samples within each pixel. </param>
+/// <param name="_packetSize"> The number of neighbouring rays to trace together with a single sample, or <c>1</c> to trace each alone. </param>
+/// <param name="_termination"> When each path stops reflecting. </param>
+/// <param name="o_buffer"> The buffer object to which the output is drawn. </param>
+/// <param name="io_rayStats"> The calling thread's ray stats, or <c>nullptr</c> if rays are not being counted. </param>
+/// <param name="o_costMap"> If given, the cost of each pixel is added here, which traces each ray alone and each path to its end in turn so that pixels can be measured apart. </param>
+/// <param name="o_sphereIndices"> If given, the index of the sphere seen by the first sample of each pixel is saved here, row by row. </param>
+/// <param name="io_tracer"> If given, the calling thread's wavefront tracer, which draws the whole tile one bounce at a time instead of following each path to its end in turn. </param>
+void World::drawTile(const Rendering::Tile& _tile, const uint8_t _sampleLevel, const uint8_t _packetSize, const Rendering::PathTermination& _termination, Buffer& o_buffer, Telemetry::RayStats* io_rayStats, Telemetry::CostMap* o_costMap, uint32_t* o_sphereIndices, Rendering::WavefrontTracer* io_tracer)
+{
+	// A wavefront traces every path within the tile at once, so it cannot measure pixels apart.
+	if (io_tracer != nullptr && o_costMap == nullptr) { io_tracer->DrawTile(_tile, _sampleLevel, _packetSize, _termination, o_buffer, io_rayStats, o_sphereIndices); return; }
+
+	// With a single sample, neighbouring primary rays are coherent enough to trace together.
+	if (_sampleLevel <= 1 && _packetSize > 1 && o_costMap == nullptr) { drawPackets(_tile, _packetSize, _termination, o_buffer, io_rayStats, o_sphereIndices); return; }
+
+	// Keep the last sphere to block a shadow ray within this tile, as neighbouring pixels are usually shadowed by the same sphere.
+	Shapes::OccluderCache occluderCache;
+
+	// When measuring the cost of each pixel, count its rays on their own before adding them to the thread's stats.
+	Telemetry::RayStats pixelStats;
+	Telemetry::RayStats* rayStats = (o_costMap != nullptr) ? &pixelStats : io_rayStats;
+	std::chrono::steady_clock::time_point pixelTimer;
+
+	// Go over each covered pixel row by row and cast a ray, save the result to the buffer.
+	for (uint16_t y = _tile.m_y; y < _tile.m_y + _tile.m_height; y++)
 	{
-		// Wait for the thread to finish.
-		threads[t].join();
-		
-		// Output the progress.
-		std::cout << ((100.0f / _threadAmount) * (t + 1)) << "% rendered." << std::endl;
+		for (uint16_t x = _tile.m_x; x < _tile.m_x + _tile.m_width; x++)
+		{
+			if (o_costMap != nullptr) { pixelStats = Telemetry::RayStats(); pixelTimer = std::chrono::steady_clock::now(); }
+
+			// With a single sample, trace the pixel itself.
+			if (_sampleLevel <= 1) { o_buffer.SetPixel(x, y, m_camera.TraceRay(glm::vec2(x, y), m_sphereSet, m_hierarchy, m_lightSource, occluderCache, _termination, (o_sphereIndices != nullptr) ? &o_sphereIndices[(size_t)y * o_buffer.GetWidth() + x] : nullptr, rayStats)); }
+			else { o_buffer.SetPixel(x, y, traceSamples(x, y, _sampleLevel, _termination, occluderCache, rayStats)); }
+
+			if (o_costMap != nullptr) { addPixelCost(x, y, pixelTimer, pixelStats, io_rayStats, *o_costMap); }
+		}
 	}
+}
 
-	// Dereference and return the buffer.
-	return *buffer;
+/// <summary> Draws the given tile of the screen onto the given buffer with one sample per pixel, tracing blocks of neighbouring pixels together as packets. </summary>
+/// <param name="_tile"> The tile to draw. </param>
+/// <param name="_packetSize"> The number of rays in each packet, either <c>4</c>, <c>8</c>, or <c>16</c>. </param>
+/// <param name="_termination"> When each path stops reflecting. </param>
+/// <param name="o_buffer"> The buffer object to which the output is drawn. </param>
+/// <param name="io_rayStats"> The calling thread's ray stats, or <c>nullptr</c> if rays are not being counted. </param>
+/// <param name="o_sphereIndices"> If given, the index of the sphere seen by each pixel is saved here, row by row. </param>
+void World::drawPackets(const Rendering::Tile& _tile, const uint8_t _packetSize, const Rendering::PathTermination& _termination, Buffer& o_buffer, Telemetry::RayStats* io_rayStats, uint32_t* o_sphereIndices)
+{
+	// Keep the last sphere to block a shadow ray within this tile, as neighbouring pixels are usually shadowed by the same sphere.
+	Shapes::OccluderCache occluderCache;
+
+	RayPacket packet;
+	glm::vec3 radiance[RayPacket::MaxSize];
+	uint32_t sphereIndices[RayPacket::MaxSize];
+	uint32_t packetWidth = Rendering::Camera::GetPacketWidth(_packetSize), packetHeight = _packetSize / packetWidth;
+	uint32_t tileRight = (uint32_t)_tile.m_x + _tile.m_width, tileBottom = (uint32_t)_tile.m_y + _tile.m_height;
+
+	// Go over each block of pixels row by row and trace them as a packet, only keeping the rays that fall within the tile.
+	for (uint32_t y = _tile.m_y; y < tileBottom; y += packetHeight)
+	{
+		for (uint32_t x = _tile.m_x; x < tileRight; x += packetWidth)
+		{
+			uint32_t activeMask = 0;
+			for (uint32_t lane = 0; lane < _packetSize; lane++) { if (x + lane % packetWidth < tileRight && y + lane / packetWidth < tileBottom) { activeMask |= 1u << lane; } }
+
+			m_camera.CreatePacket(glm::vec2(x, y), _packetSize, activeMask, packet);
+			m_camera.TracePacket(packet, m_sphereSet, m_hierarchy, m_lightSource, occluderCache, _termination, radiance, (o_sphereIndices != nullptr) ? sphereIndices : nullptr, io_rayStats);
+
+			// Save each active ray's radiance to its pixel.
+			for (uint32_t lane = 0; lane < _packetSize; lane++)
+			{
+				if (!packet.IsActive(lane)) { continue; }
+				uint16_t pixelX = (uint16_t)(x + lane % packetWidth), pixelY = (uint16_t)(y + lane / packetWidth);
+				o_buffer.SetPixel(pixelX, pixelY, radiance[lane]);
+				if (o_sphereIndices != nullptr) { o_sphereIndices[(size_t)pixelY * o_buffer.GetWidth() + pixelX] = sphereIndices[lane]; }
+			}
+		}
+	}
 }
 
-/// <summary> Draws the given section of the screen onto the given buffer. </summary>
-/// <param name="_threadNumber"> The number of this thread within the list. </param>
-/// <param name="_threadCount"> The number of threads. </param>
+/// <summary> Refines the given tile, tracing every sample for pixels whose first sample saw a different sphere or colour to any of their neighbours, and keeping the first sample for the rest. </summary>
+/// <param name="_tile"> The tile to refine. </param>
+/// <param name="_settings"> The settings holding the sample level and edge threshold. </param>
+/// <param name="_firstSamples"> The first sample of every pixel. </param>
+/// <param name="_sphereIndices"> The index of the sphere seen by the first sample of every pixel, row by row. </param>
 /// <param name="o_buffer"> The buffer object to which the output is drawn. </param>
-void World::drawSection(const uint8_t _threadNumber, const uint8_t _threadCount, Buffer& o_buffer)
+/// <param name="io_rayStats"> The calling thread's ray stats, or <c>nullptr</c> if rays are not being counted. </param>
+/// <param name="o_costMap"> If given, the cost of refining each pixel is added here. </param>
+/// <returns> The number of pixels that were refined. </returns>
+uint32_t World::refineTile(const Rendering::Tile& _tile, const Rendering::RenderSettings& _settings, const Buffer& _firstSamples, const std::vector<uint32_t>& _sphereIndices, Buffer& o_buffer, Telemetry::RayStats* io_rayStats, Telemetry::CostMap* o_costMap)
 {
-	// Go over each covered pixel and cast a ray, save the result to the buffer.
-	for (uint16_t x = _threadNumber; x < m_camera.GetWidth(); x += _threadCount)
+	// Keep the last sphere to block a shadow ray within this tile, as neighbouring pixels are usually shadowed by the same sphere.
+	Shapes::OccluderCache occluderCache;
+
+	// When measuring the cost of each pixel, count its rays on their own before adding them to the thread's stats.
+	Telemetry::RayStats pixelStats;
+	Telemetry::RayStats* rayStats = (o_costMap != nullptr) ? &pixelStats : io_rayStats;
+	std::chrono::steady_clock::time_point pixelTimer;
+
+	uint32_t refinedPixelCount = 0;
+	uint16_t width = _firstSamples.GetWidth(), height = _firstSamples.GetHeight();
+	for (uint16_t y = _tile.m_y; y < _tile.m_y + _tile.m_height; y++)
 	{
-		for (uint16_t y = 0; y < m_camera.GetHeight(); y++)
+		for (uint16_t x = _tile.m_x; x < _tile.m_x + _tile.m_width; x++)
 		{
-		    o_buffer.SetPixel(x, y, m_camera.TraceRay(glm::vec2(x, y), m_spheres, m_lightSource));
+			glm::vec3 firstSample = _firstSamples.AtPixel(x, y);
+			uint32_t sphereIndex = _sphereIndices[(size_t)y * width + x];
+
+			// Compare the pixel against each of its eight neighbours, stopping at the first that differs.
+			bool isEdge = false;
+			for (int32_t neighbourY = glm::max(y - 1, 0); neighbourY <= glm::min(y + 1, height - 1) && !isEdge; neighbourY++)
+			{
+				for (int32_t neighbourX = glm::max(x - 1, 0); neighbourX <= glm::min(x + 1, width - 1) && !isEdge; neighbourX++)
+				{
+					glm::vec3 difference = glm::abs(glm::min(firstSample, 1.0f) - glm::min(_firstSamples.AtPixel(neighbourX, neighbourY), 1.0f));
+					float_t contrast = (difference.r + difference.g + difference.b) * UINT8_MAX;
+					isEdge = _sphereIndices[(size_t)neighbourY * width + neighbourX] != sphereIndex || contrast > _settings.m_edgeThreshold;
+				}
+			}
+
+			// Trace the rest of the samples for edges, reusing the first.
+			if (isEdge)
+			{
+				if (o_costMap != nullptr) { pixelStats = Telemetry::RayStats(); pixelTimer = std::chrono::steady_clock::now(); }
+				o_buffer.SetPixel(x, y, traceSamples(x, y, _settings.m_sampleLevel, _settings.m_termination, occluderCache, rayStats, &firstSample));
+				if (o_costMap != nullptr) { addPixelCost(x, y, pixelTimer, pixelStats, io_rayStats, *o_costMap); }
+				refinedPixelCount++;
+			}
+			else { o_buffer.SetPixel(x, y, firstSample); }
 		}
 	}
+
+	return refinedPixelCount;
 }
 
-/// <summary> Creates every sphere needed in the world. </summary>
-void World::initialiseSpheres()
+/// <summary> Traces a grid of samples within the given pixel and averages them. </summary>
+/// <param name="_x"> The x position of the pixel. </param>
+/// <param name="_y"> The y position of the pixel. </param>
+/// <param name="_sampleLevel"> The width and height of the grid of samples. </param>
+/// <param name="_termination"> When each path stops reflecting. </param>
+/// <param name="io_occluderCache"> The last sphere to block a shadow ray on this thread. </param>
+/// <param name="io_rayStats"> The calling thread's ray stats, or <c>nullptr</c> if rays are not being counted. </param>
+/// <param name="_firstSample"> If given, the already traced radiance of the first sample, which is at the pixel's own position. </param>
+/// <returns> The root mean square of every sample. </returns>
+/// <remarks> Each sample is placed where a pixel would be if the camera were the sample level times larger, matching <see cref="Buffer::SuperSample"/> without ever storing the larger image. </remarks>
+glm::vec3 World::traceSamples(const uint16_t _x, const uint16_t _y, const uint8_t _sampleLevel, const Rendering::PathTermination& _termination, Shapes::OccluderCache& io_occluderCache, Telemetry::RayStats* io_rayStats, const glm::vec3* _firstSample)
 {
-	m_spheres.push_back(Shapes::Sphere(glm::vec3(0, 0, 0), 6.0f, Shapes::ShapeProperties(Colour::Red(), 0.5f)));
+	// Trace each sample and add up its squared radiance.
+	glm::vec3 squaredSum(0.0f);
+	for (uint8_t sampleY = 0; sampleY < _sampleLevel; sampleY++)
+	{
+		for (uint8_t sampleX = 0; sampleX < _sampleLevel; sampleX++)
+		{
+			glm::vec3 sample = (_firstSample != nullptr && sampleX == 0 && sampleY == 0) ? *_firstSample : m_camera.TraceRay(glm::vec2(_x + sampleX / (float_t)_sampleLevel, _y + sampleY / (float_t)_sampleLevel), m_sphereSet, m_hierarchy, m_lightSource, io_occluderCache, _termination, nullptr, io_rayStats);
+			squaredSum += sample * sample;
+		}
+	}
+
+	return glm::sqrt(squaredSum / (float_t)(_sampleLevel * _sampleLevel));
+}
 
-	m_spheres.push_back(Shapes::Sphere(glm::vec3(-8, 0, -8), 2.5f, Shapes::ShapeProperties::MatteGrey()));
+/// <summary> Adds the cost of a pixel that has just been traced to the cost map, and its rays to the thread's stats. </summary>
+/// <param name="_x"> The x position of the pixel. </param>
+/// <param name="_y"> The y position of the pixel. </param>
+/// <param name="_pixelTimer"> The time at which tracing the pixel started. </param>
+/// <param name="_pixelStats"> The rays traced for the pixel alone. </param>
+/// <param name="io_rayStats"> The calling thread's ray stats, or <c>nullptr</c> if rays are not being counted. </param>
+/// <param name="o_costMap"> The cost map. </param>
+void World::addPixelCost(const uint16_t _x, const uint16_t _y, const std::chrono::steady_clock::time_point _pixelTimer, const Telemetry::RayStats& _pixelStats, Telemetry::RayStats* io_rayStats, Telemetry::CostMap& o_costMap)
+{
+	o_costMap.Add(_x, _y, std::chrono::steady_clock::now() - _pixelTimer, _pixelStats);
+	if (io_rayStats != nullptr) { *io_rayStats += _pixelStats; }
+}
 
-	m_spheres.push_back(Shapes::Sphere(glm::vec3(-5.5f, -10, -8), 2.5f, Shapes::ShapeProperties(Colour(255, 215, 0), 0)));
+/// <summary> Creates every sphere in the given scene, then builds the hierarchy over them. </summary>
+/// <param name="_scene"> The scene holding the spheres and their materials. </param>
+/// <param name="_buildMethod"> The method with which to build the hierarchy. </param>
+void World::initialiseSpheres(const Scenes::Scene& _scene, const Shapes::BuildMethod _buildMethod)
+{
+	// Give each sphere a copy of its material.
+	m_spheres.reserve(_scene.m_spheres.size());
+	for (const Scenes::SceneSphere& sphere : _scene.m_spheres) { m_spheres.push_back(Shapes::Sphere(sphere.m_centre, sphere.m_radius, _scene.m_materials[sphere.m_material])); }
 
-	m_spheres.push_back(Shapes::Sphere(glm::vec3(0, 9, -15), 1.75f, Shapes::ShapeProperties(Colour(255, 0, 255), 0)));
+	// Lay the spheres out for intersection tests, and build the hierarchy over them.
+	m_sphereSet = Shapes::SphereSet(m_spheres);
+	m_hierarchy.Build(m_sphereSet, _buildMethod);
+}
 
-	m_spheres.push_back(Shapes::Sphere(glm::vec3(8, 8, -8), 5.0f, Shapes::ShapeProperties(Colour::Green(), 0.85f)));
+/// <summary> Copies each sphere out of the mapped set in the order they were created, then lays them out again and builds the hierarchy over them, so that they can be changed. </summary>
+/// <param name="_buildMethod"> The method with which to build the hierarchy. </param>
+void World::unmapSpheres(const Shapes::BuildMethod _buildMethod)
+{
+	m_spheres.resize(m_sphereSet.GetCount());
+	for (uint32_t i = 0; i < m_sphereSet.GetCount(); i++) { m_spheres[m_sphereSet.GetOriginalIndex(i)] = m_sphereSet.GetSphere(i); }
 
-	m_spheres.push_back(Shapes::Sphere(glm::vec3(-20, 9.5f, 25), 20.0f, Shapes::ShapeProperties(Colour(235, 243, 246), 0.35f)));
+	m_sphereSet = Shapes::SphereSet(m_spheres);
+	m_hierarchy.Build(m_sphereSet, _buildMethod);
 }
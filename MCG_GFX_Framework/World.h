@@ -6,34 +6,126 @@
 
 // Data includes
 #include "Sphere.h"
+#include "SphereSet.h"
+#include "BoundingVolumeHierarchy.h"
 #include "Camera.h"
+#include "Wavefront.h"
 #include "PointLight.h"
 #include "Buffer.h"
+#include "FrameTarget.h"
+#include "RenderSettings.h"
+#include "TileScheduler.h"
+#include "Scene.h"
+#include "MappedScene.h"
+
+// Diagnostic includes.
+#include "CostMap.h"
 
 // Utility includes.
 #include <vector>
+#include <chrono>
+
+/// <summary> Represents how long each pass of a draw took. </summary>
+struct DrawStats
+{
+	/// <summary> Creates empty stats. </summary>
+	DrawStats() : m_renderMilliseconds(0), m_sampleMilliseconds(0), m_refinedPixelCount(0) { }
+
+	/// <summary> The time taken to trace every pixel, including every sample when sampling uniformly as they are resolved while tracing. </summary>
+	double m_renderMilliseconds;
+
+	/// <summary> The time taken to find the edges and trace their extra samples when sampling adaptively, otherwise <c>0</c>. </summary>
+	double m_sampleMilliseconds;
+
+	/// <summary> The number of pixels that traced every sample. </summary>
+	uint32_t m_refinedPixelCount;
+};
 
 /// <summary> Represents a world with spheres, a camera, and a light source. </summary>
 class World
 {
 public:
-	/// <summary> Creates a world with the given window size for the camera. </summary>
+	/// <summary> Creates a world of the default scene with the given window size for the camera. </summary>
 	/// <param name="_windowSize"> The size of the camera's viewport in pixels. </param>
-	World(const glm::vec2 _windowSize) : m_spheres(), m_camera(Rendering::Camera::FromLookAt(_windowSize, glm::vec3(0, 0, -50), glm::vec3(0, 0, 0))), m_lightSource(glm::vec3(-20, 0, -20), 2.0f, Colour(94, 85, 64)) { initialiseSpheres(); }
+	/// <param name="_buildMethod"> The method with which to build the hierarchy over the spheres. Defaults to the binned surface area heuristic. </param>
+	World(const glm::vec2 _windowSize, const Shapes::BuildMethod _buildMethod = Shapes::BuildMethod::BinnedSAH) : World(_windowSize, Scenes::Scene::Default(), _buildMethod) { }
+
+	World(glm::vec2, const Scenes::Scene&, Shapes::BuildMethod _buildMethod = Shapes::BuildMethod::BinnedSAH);
+
+	World(glm::vec2, const Scenes::MappedScene&, Shapes::BuildMethod _buildMethod = Shapes::BuildMethod::BinnedSAH);
+
+	Buffer& Draw(const Rendering::RenderSettings&, Rendering::FrameTarget* o_target = nullptr, Telemetry::CostMap* o_costMap = nullptr);
+
+	/// <summary> Gets the stats from building the hierarchy over the spheres. </summary>
+	/// <returns> The time taken to build, the size of the tree, and its quality. </returns>
+	inline const Shapes::BuildStats& GetBuildStats() const { return m_hierarchy.GetBuildStats(); }
+
+	Shapes::RefitStats UpdateSpheres(const std::vector<Shapes::SphereUpdate>&, float_t _rebuildRatio = 1.5f);
+
+	/// <summary> Gets the number of pixels that traced every sample in the last draw. </summary>
+	/// <returns> The number of edge pixels when sampling adaptively, otherwise every pixel if there is more than one sample. </returns>
+	inline uint32_t GetRefinedPixelCount() const { return m_drawStats.m_refinedPixelCount; }
+
+	/// <summary> Gets the stats from the last draw. </summary>
+	/// <returns> The time taken by each pass, and the number of pixels that traced every sample. </returns>
+	inline const DrawStats& GetDrawStats() const { return m_drawStats; }
+
+	/// <summary> Gets the camera used to draw the world. </summary>
+	/// <returns> The camera. </returns>
+	inline const Rendering::Camera& GetCamera() const { return m_camera; }
 
-	Buffer& Draw(uint8_t);
+	/// <summary> Gets the spheres laid out for intersection tests. </summary>
+	/// <returns> The sphere set. </returns>
+	inline const Shapes::SphereSet& GetSphereSet() const { return m_sphereSet; }
+
+	/// <summary> Gets the hierarchy built over the sphere set. </summary>
+	/// <returns> The hierarchy. </returns>
+	inline const Shapes::BoundingVolumeHierarchy& GetHierarchy() const { return m_hierarchy; }
+
+	/// <summary> Gets the source of light. </summary>
+	/// <returns> The light source. </returns>
+	inline const PointLight& GetLightSource() const { return m_lightSource; }
 private:
 	/// <summary> The source of light. </summary>
 	PointLight m_lightSource;
 
-	/// <summary> Every sphere that exists within the world. </summary>
+	/// <summary> Every sphere that exists within the world, which is empty while the spheres are mapped. </summary>
 	std::vector<Shapes::Sphere> m_spheres;
 
+	/// <summary> Every sphere that exists within the world, laid out for fast intersection tests. </summary>
+	Shapes::SphereSet m_sphereSet;
+
+	/// <summary> The hierarchy built over the sphere set, used to only test the spheres near each ray. </summary>
+	Shapes::BoundingVolumeHierarchy m_hierarchy;
+
 	/// <summary> The camera used to draw the world. </summary>
 	Rendering::Camera m_camera;
 
-	void drawSection(const uint8_t _threadNumber, const uint8_t _threadCount, Buffer& o_buffer);
+	/// <summary> The index within the sphere set of each sphere changed by the last update, kept between updates to avoid allocating. </summary>
+	std::vector<uint32_t> m_changedSpheres;
+
+	/// <summary> The wavefront tracer of each thread, kept between draws so that their queues are only allocated once. </summary>
+	std::vector<Rendering::WavefrontTracer> m_tracers;
+
+	/// <summary> The time taken by each pass of the last draw, and the number of pixels that traced every sample. </summary>
+	DrawStats m_drawStats;
+
+	Buffer& drawAdaptive(const Rendering::RenderSettings&, Rendering::FrameTarget*, Telemetry::CostMap*);
+
+	Rendering::WavefrontTracer* bindTracers(const Rendering::RenderSettings&);
+
+	void drawTile(const Rendering::Tile& _tile, uint8_t _sampleLevel, uint8_t _packetSize, const Rendering::PathTermination& _termination, Buffer& o_buffer, Telemetry::RayStats* io_rayStats, Telemetry::CostMap* o_costMap, uint32_t* o_sphereIndices = nullptr, Rendering::WavefrontTracer* io_tracer = nullptr);
+
+	void drawPackets(const Rendering::Tile& _tile, uint8_t _packetSize, const Rendering::PathTermination& _termination, Buffer& o_buffer, Telemetry::RayStats* io_rayStats, uint32_t* o_sphereIndices);
+
+	uint32_t refineTile(const Rendering::Tile& _tile, const Rendering::RenderSettings& _settings, const Buffer& _firstSamples, const std::vector<uint32_t>& _sphereIndices, Buffer& o_buffer, Telemetry::RayStats* io_rayStats, Telemetry::CostMap* o_costMap);
+
+	static void addPixelCost(uint16_t, uint16_t, std::chrono::steady_clock::time_point, const Telemetry::RayStats&, Telemetry::RayStats*, Telemetry::CostMap&);
+
+	glm::vec3 traceSamples(uint16_t _x, uint16_t _y, uint8_t _sampleLevel, const Rendering::PathTermination& _termination, Shapes::OccluderCache& io_occluderCache, Telemetry::RayStats* io_rayStats, const glm::vec3* _firstSample = nullptr);
+
+	void initialiseSpheres(const Scenes::Scene&, Shapes::BuildMethod);
 
-	void initialiseSpheres();
+	void unmapSpheres(Shapes::BuildMethod);
 };
 #endif
\ No newline at end of file
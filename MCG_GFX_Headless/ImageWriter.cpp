@@ -0,0 +1,188 @@
+#include "ImageWriter.h"
+
+// Utility includes.
+#include <fstream>
+#include <algorithm>
+#include <array>
+
+namespace
+{
+	/// <summary> Appends the given value to the given bytes, most significant byte first. </summary>
+	/// <param name="io_bytes"> The bytes to append to. </param>
+	/// <param name="_value"> The value to append. </param>
+	inline void appendBigEndian(std::vector<uint8_t>& io_bytes, const uint32_t _value)
+	{
+		io_bytes.push_back((uint8_t)(_value >> 24));
+		io_bytes.push_back((uint8_t)(_value >> 16));
+		io_bytes.push_back((uint8_t)(_value >> 8));
+		io_bytes.push_back((uint8_t)_value);
+	}
+
+	/// <summary> Calculates the CRC-32 of every possible byte. </summary>
+	/// <returns> The table of CRCs, indexed by byte. </returns>
+	std::array<uint32_t, 256> createCrcTable()
+	{
+		std::array<uint32_t, 256> table;
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t value = n;
+			for (uint32_t bit = 0; bit < 8; bit++) { value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1; }
+			table[n] = value;
+		}
+		return table;
+	}
+}
+
+/// <summary> Writes the given buffer to the given file in the given format. </summary>
+/// <param name="_buffer"> The buffer to write. </param>
+/// <param name="_path"> The path of the file, which is replaced if it exists. </param>
+/// <param name="_format"> The format of the file. </param>
+/// <param name="_toneMapping"> How radiance brighter than full brightness is brought into range as each pixel is quantised. </param>
+/// <returns> <c>true</c> if the whole file was written; otherwise, <c>false</c>. </returns>
+bool Output::ImageWriter::Write(const Buffer& _buffer, const std::string& _path, const ImageFormat _format, const ToneMapping _toneMapping)
+{
+	// Encode the whole file in memory, so that it can be written in one go.
+	std::vector<uint8_t> bytes;
+	switch (_format)
+	{
+	case ImageFormat::PPM:
+	{
+		std::string header = "P6\n" + std::to_string(_buffer.GetWidth()) + " " + std::to_string(_buffer.GetHeight()) + "\n255\n";
+		bytes.assign(header.begin(), header.end());
+		packPixels(_buffer, _toneMapping, bytes);
+		break;
+	}
+	case ImageFormat::PNG: { encodePNG(_buffer, _toneMapping, bytes); break; }
+	case ImageFormat::Raw: { packPixels(_buffer, _toneMapping, bytes); break; }
+	}
+
+	// Write the file.
+	std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+	if (!file) { return false; }
+	file.write((const char*)bytes.data(), bytes.size());
+	return (bool)file;
+}
+
+/// <summary> Finds the format to use from the extension of the given path. </summary>
+/// <param name="_path"> The path of the file. </param>
+/// <param name="o_format"> The format matching the extension. </param>
+/// <returns> <c>true</c> if the extension is <c>.ppm</c>, <c>.png</c>, or <c>.raw</c>; otherwise, <c>false</c>. </returns>
+bool Output::ImageWriter::FormatFromPath(const std::string& _path, ImageFormat& o_format)
+{
+	// Get the extension in lower case.
+	size_t dot = _path.find_last_of('.');
+	if (dot == std::string::npos) { return false; }
+	std::string extension = _path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char _character) { return (char)tolower(_character); });
+
+	if (extension == "ppm") { o_format = ImageFormat::PPM; return true; }
+	if (extension == "png") { o_format = ImageFormat::PNG; return true; }
+	if (extension == "raw" || extension == "rgb") { o_format = ImageFormat::Raw; return true; }
+	return false;
+}
+
+/// <summary> Quantises and appends every pixel of the given buffer to the given bytes, three bytes each and row by row, without the buffer's row padding. </summary>
+/// <param name="_buffer"> The buffer to pack. </param>
+/// <param name="_toneMapping"> How radiance brighter than full brightness is brought into range. </param>
+/// <param name="io_bytes"> The bytes to append to. </param>
+void Output::ImageWriter::packPixels(const Buffer& _buffer, const ToneMapping _toneMapping, std::vector<uint8_t>& io_bytes)
+{
+	io_bytes.reserve(io_bytes.size() + (size_t)_buffer.GetWidth() * _buffer.GetHeight() * 3);
+	for (uint16_t y = 0; y < _buffer.GetHeight(); y++)
+	{
+		for (uint16_t x = 0; x < _buffer.GetWidth(); x++)
+		{
+			Colour pixel = _buffer.ColourAtPixel(x, y, _toneMapping);
+			io_bytes.push_back(pixel.r);
+			io_bytes.push_back(pixel.g);
+			io_bytes.push_back(pixel.b);
+		}
+	}
+}
+
+/// <summary> Encodes the given buffer as a PNG file, storing the pixels without compression. </summary>
+/// <param name="_buffer"> The buffer to encode. </param>
+/// <param name="_toneMapping"> How radiance brighter than full brightness is brought into range. </param>
+/// <param name="o_bytes"> The bytes of the whole file. </param>
+void Output::ImageWriter::encodePNG(const Buffer& _buffer, const ToneMapping _toneMapping, std::vector<uint8_t>& o_bytes)
+{
+	// Start with the signature.
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	o_bytes.assign(signature, signature + 8);
+
+	// Describe the image as 8-bit RGB, with no interlacing.
+	std::vector<uint8_t> header;
+	appendBigEndian(header, _buffer.GetWidth());
+	appendBigEndian(header, _buffer.GetHeight());
+	header.push_back(8); header.push_back(2); header.push_back(0); header.push_back(0); header.push_back(0);
+	appendChunk(o_bytes, "IHDR", header);
+
+	// Lay the pixels out as PNG expects, with each row starting with a filter type of none.
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve(((size_t)_buffer.GetWidth() * 3 + 1) * _buffer.GetHeight());
+	for (uint16_t y = 0; y < _buffer.GetHeight(); y++)
+	{
+		scanlines.push_back(0);
+		for (uint16_t x = 0; x < _buffer.GetWidth(); x++)
+		{
+			Colour pixel = _buffer.ColourAtPixel(x, y, _toneMapping);
+			scanlines.push_back(pixel.r);
+			scanlines.push_back(pixel.g);
+			scanlines.push_back(pixel.b);
+		}
+	}
+
+	// Wrap the scanlines in a zlib stream made of stored deflate blocks, which can each hold up to 65535 bytes.
+	std::vector<uint8_t> stream;
+	stream.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+	stream.push_back(0x78); stream.push_back(0x01);
+	size_t offset = 0;
+	do
+	{
+		uint16_t blockSize = (uint16_t)std::min<size_t>(scanlines.size() - offset, 65535);
+		stream.push_back((offset + blockSize == scanlines.size()) ? 1 : 0);
+		stream.push_back((uint8_t)blockSize); stream.push_back((uint8_t)(blockSize >> 8));
+		stream.push_back((uint8_t)~blockSize); stream.push_back((uint8_t)(~blockSize >> 8));
+		stream.insert(stream.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < scanlines.size());
+
+	// End the stream with the Adler-32 checksum of the scanlines.
+	uint32_t sumA = 1, sumB = 0;
+	for (size_t i = 0; i < scanlines.size(); i++) { sumA = (sumA + scanlines[i]) % 65521; sumB = (sumB + sumA) % 65521; }
+	appendBigEndian(stream, (sumB << 16) | sumA);
+
+	appendChunk(o_bytes, "IDAT", stream);
+	appendChunk(o_bytes, "IEND", std::vector<uint8_t>());
+}
+
+/// <summary> Appends a PNG chunk with the given type and data to the given bytes. </summary>
+/// <param name="io_bytes"> The bytes to append to. </param>
+/// <param name="_type"> The four letter type of the chunk. </param>
+/// <param name="_data"> The data of the chunk. </param>
+void Output::ImageWriter::appendChunk(std::vector<uint8_t>& io_bytes, const char* _type, const std::vector<uint8_t>& _data)
+{
+	appendBigEndian(io_bytes, (uint32_t)_data.size());
+	io_bytes.insert(io_bytes.end(), _type, _type + 4);
+	io_bytes.insert(io_bytes.end(), _data.begin(), _data.end());
+
+	// The checksum covers the type and the data.
+	uint32_t crc = crc32((const uint8_t*)_type, 4);
+	crc = crc32(_data.data(), _data.size(), crc);
+	appendBigEndian(io_bytes, crc);
+}
+
+/// <summary> Calculates the CRC-32 used by PNG over the given bytes, continuing from the given CRC. </summary>
+/// <param name="_bytes"> The bytes. </param>
+/// <param name="_count"> The number of bytes. </param>
+/// <param name="_crc"> The CRC of the bytes before these, or <c>0</c> to start a new one. </param>
+/// <returns> The CRC of every byte so far. </returns>
+uint32_t Output::ImageWriter::crc32(const uint8_t* _bytes, const size_t _count, const uint32_t _crc)
+{
+	// Build the table of every byte's CRC the first time it is needed.
+	static const std::array<uint32_t, 256> table = createCrcTable();
+
+	uint32_t crc = ~_crc;
+	for (size_t i = 0; i < _count; i++) { crc = table[(crc ^ _bytes[i]) & 0xFF] ^ (crc >> 8); }
+	return ~crc;
+}
\ No newline at end of file
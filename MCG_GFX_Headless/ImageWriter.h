@@ -0,0 +1,46 @@
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+// Data includes.
+#include "Buffer.h"
+
+// Utility includes.
+#include <string>
+#include <vector>
+
+// Typedef includes.
+#include <stdint.h>
+
+namespace Output
+{
+	/// <summary> The file formats a buffer can be written as. </summary>
+	enum class ImageFormat : uint8_t
+	{
+		/// <summary> Binary portable pixmap, a tiny header followed by the pixels. </summary>
+		PPM,
+
+		/// <summary> Portable network graphics, with the pixels in stored deflate blocks so that no compression library is needed. </summary>
+		PNG,
+
+		/// <summary> Just the pixels, three bytes each, row by row with no padding. </summary>
+		Raw
+	};
+
+	/// <summary> Writes buffers to image files without any windowing or graphics library. </summary>
+	class ImageWriter
+	{
+	public:
+		static bool Write(const Buffer&, const std::string&, ImageFormat, ToneMapping _toneMapping = ToneMapping::Clamp);
+
+		static bool FormatFromPath(const std::string&, ImageFormat&);
+	private:
+		static void packPixels(const Buffer&, ToneMapping, std::vector<uint8_t>&);
+
+		static void encodePNG(const Buffer&, ToneMapping, std::vector<uint8_t>&);
+
+		static void appendChunk(std::vector<uint8_t>&, const char*, const std::vector<uint8_t>&);
+
+		static uint32_t crc32(const uint8_t*, size_t, uint32_t _crc = 0);
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,331 @@
+// Data includes.
+#include "World.h"
+#include "Buffer.h"
+#include "RenderSettings.h"
+#include "ImageWriter.h"
+#include "SceneFile.h"
+#include "MappedScene.h"
+#include "SceneGenerator.h"
+
+// Diagnostic includes.
+#include "Telemetry.h"
+#include "Timeline.h"
+#include "CostMap.h"
+
+// Utility includes.
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <memory>
+
+/// <summary> Represents everything that can be set from the command line. </summary>
+struct Options
+{
+	/// <summary> Creates the default options, a 1920x1000 image of the default scene written to <c>render.png</c> without telemetry, a trace, or cost maps. </summary>
+	Options() : m_width(1920), m_height(1000), m_scene("default"), m_validateScene(false), m_generator(Scenes::GeneratorType::Count), m_sphereCount(1000), m_seed(1), m_saveScenePath(), m_outputPath("render.png"), m_format(Output::ImageFormat::PNG), m_telemetryPath(), m_tracePath(), m_writeCostMaps(false), m_settings() { }
+
+	/// <summary> The width of the image in pixels. </summary>
+	uint16_t m_width;
+
+	/// <summary> The height of the image in pixels. </summary>
+	uint16_t m_height;
+
+	/// <summary> The path of the scene file to render, or <c>default</c> for the built in scene. </summary>
+	std::string m_scene;
+
+	/// <summary> Whether to check every sphere and node of a mapped scene before rendering it, rather than trusting the file. </summary>
+	bool m_validateScene;
+
+	/// <summary> The kind of scene to generate instead of loading one, or <see cref="Scenes::GeneratorType::Count"/> to load the scene. </summary>
+	Scenes::GeneratorType m_generator;
+
+	/// <summary> The number of spheres to generate. </summary>
+	uint32_t m_sphereCount;
+
+	/// <summary> The seed to generate the scene from. </summary>
+	uint32_t m_seed;
+
+	/// <summary> The path to which the scene is saved before rendering, in the format given by its extension, or empty to not save it. </summary>
+	std::string m_saveScenePath;
+
+	/// <summary> The path of the image to write. </summary>
+	std::string m_outputPath;
+
+	/// <summary> The format of the image to write. </summary>
+	Output::ImageFormat m_format;
+
+	/// <summary> The path of the file to which the frame's telemetry is written as a line of JSON, <c>-</c> for the console, or empty for none. </summary>
+	std::string m_telemetryPath;
+
+	/// <summary> The path of the file to which the frame's Chrome trace is written, or empty for none. </summary>
+	std::string m_tracePath;
+
+	/// <summary> Whether to write a false colour image of each pixel's cost alongside the output. </summary>
+	bool m_writeCostMaps;
+
+	/// <summary> The settings with which to render. </summary>
+	Rendering::RenderSettings m_settings;
+};
+
+/// <summary> Prints how to use the program. </summary>
+/// <param name="_program"> The name the program was run with. </param>
+void printUsage(const char* _program)
+{
+	std::cout << "Usage: " << _program << " [options]" << std::endl
+		<< "  -w, --width <pixels>      Width of the image. Defaults to 1920." << std::endl
+		<< "  -h, --height <pixels>     Height of the image. Defaults to 1000." << std::endl
+		<< "  -s, --samples <level>     Width and height of the grid of samples in each pixel. Defaults to 1." << std::endl
+		<< "  -a, --adaptive            Only trace every sample for pixels on an edge." << std::endl
+		<< "  -t, --threads <count>     Threads to render with, 0 uses every worker. Defaults to 0." << std::endl
+		<< "      --packet <size>       Rays traced together, primary rays with one sample or every ray with --wavefront: 4, 8, or 16, or 1 to trace each alone. Defaults to 8." << std::endl
+		<< "      --wavefront           Trace each tile one bounce at a time as queues of rays, rather than following each path to its end in turn." << std::endl
+		<< "      --terminate <mode>    End reflections whose throughput is below the threshold early: none, threshold, or roulette. Defaults to none." << std::endl
+		<< "      --threshold <value>   Throughput below which --terminate ends reflections, between 0 and 1. Defaults to 1/255, a single colour step." << std::endl
+		<< "      --scene <path>        Scene file to render, text or binary, or \"default\". Binary scenes are mapped and traced from directly. Defaults to default." << std::endl
+		<< "      --validate-scene      Check every sphere and node of a mapped scene before rendering, for files that cannot be trusted." << std::endl
+		<< "      --generate <kind>     Generate the scene instead: random, grid, sphereflake, mirrors, or subpixel." << std::endl
+		<< "      --count <spheres>     Spheres to generate, up to " << Scenes::SceneGenerator::MaxSphereCount << ". Defaults to 1000." << std::endl
+		<< "      --seed <number>       Seed to generate from. Defaults to 1." << std::endl
+		<< "      --save-scene <path>   Save the scene as .scene text or .sceneb binary, such as to convert it." << std::endl
+		<< "  -o, --output <path>       Image to write, as .ppm, .png, or .raw. Defaults to render.png." << std::endl
+		<< "      --tone-map <mapping>  How radiance brighter than white is written: clamp or reinhard. Defaults to clamp." << std::endl
+		<< "  -f, --format <format>     Format to write, overriding the extension: ppm, png, or raw." << std::endl
+		<< "      --telemetry <path>    Append the frame's telemetry to the file as a line of JSON, or - for the console." << std::endl
+		<< "      --trace <path>        Write a Chrome trace of what each thread did to the file." << std::endl
+		<< "      --cost-map            Also write the time, sphere tests, and rays of each pixel as false colour images." << std::endl;
+}
+
+/// <summary> Parses a whole number within the given range. </summary>
+/// <param name="_text"> The text to parse. </param>
+/// <param name="_min"> The smallest allowed value. </param>
+/// <param name="_max"> The largest allowed value. </param>
+/// <param name="o_value"> The parsed value. </param>
+/// <returns> <c>true</c> if the text was a whole number within range; otherwise, <c>false</c>. </returns>
+bool parseNumber(const char* _text, const long _min, const long _max, long& o_value)
+{
+	char* end = nullptr;
+	o_value = strtol(_text, &end, 10);
+	return end != _text && *end == '\0' && o_value >= _min && o_value <= _max;
+}
+
+/// <summary> Parses a whole number from <c>0</c> to <c>UINT32_MAX</c>, which does not fit in a <c>long</c> on every platform. </summary>
+/// <param name="_text"> The text to parse. </param>
+/// <param name="o_value"> The parsed value. </param>
+/// <returns> <c>true</c> if the text was a whole number within range; otherwise, <c>false</c>. </returns>
+bool parseUnsigned(const char* _text, uint32_t& o_value)
+{
+	char* end = nullptr;
+	unsigned long long value = strtoull(_text, &end, 10);
+	if (end == _text || *end != '\0' || _text[0] == '-' || value > UINT32_MAX) { return false; }
+	o_value = (uint32_t)value;
+	return true;
+}
+
+/// <summary> Parses the name of a way to end paths early. </summary>
+/// <param name="_text"> The name, either none, threshold, or roulette. </param>
+/// <param name="o_mode"> The parsed mode. </param>
+/// <returns> <c>true</c> if the name was known; otherwise, <c>false</c>. </returns>
+bool parseTermination(const std::string& _text, Rendering::TerminationMode& o_mode)
+{
+	if (_text == "none") { o_mode = Rendering::TerminationMode::None; }
+	else if (_text == "threshold") { o_mode = Rendering::TerminationMode::Threshold; }
+	else if (_text == "roulette") { o_mode = Rendering::TerminationMode::RussianRoulette; }
+	else { return false; }
+	return true;
+}
+
+/// <summary> Parses the name of a way to bring radiance into the range of a colour. </summary>
+/// <param name="_text"> The name, either clamp or reinhard. </param>
+/// <param name="o_toneMapping"> The parsed tone mapping. </param>
+/// <returns> <c>true</c> if the name was known; otherwise, <c>false</c>. </returns>
+bool parseToneMapping(const std::string& _text, ToneMapping& o_toneMapping)
+{
+	if (_text == "clamp") { o_toneMapping = ToneMapping::Clamp; }
+	else if (_text == "reinhard") { o_toneMapping = ToneMapping::Reinhard; }
+	else { return false; }
+	return true;
+}
+
+/// <summary> Parses the command line into the given options. </summary>
+/// <param name="_argumentCount"> The number of arguments, including the program name. </param>
+/// <param name="_arguments"> The arguments. </param>
+/// <param name="o_options"> The parsed options. </param>
+/// <returns> <c>true</c> if every argument was valid; otherwise, <c>false</c>. </returns>
+bool parseOptions(const int _argumentCount, char* _arguments[], Options& o_options)
+{
+	bool formatGiven = false;
+	for (int i = 1; i < _argumentCount; i++)
+	{
+		std::string argument = _arguments[i];
+
+		// Flags that take no value.
+		if (argument == "-a" || argument == "--adaptive") { o_options.m_settings.m_sampleMode = Rendering::SampleMode::Adaptive; continue; }
+		if (argument == "--cost-map") { o_options.m_writeCostMaps = true; continue; }
+		if (argument == "--validate-scene") { o_options.m_validateScene = true; continue; }
+		if (argument == "--wavefront") { o_options.m_settings.m_traceMode = Rendering::TraceMode::Wavefront; continue; }
+
+		// Every other option takes the argument after it as its value.
+		const char* value = nullptr;
+		auto nextValue = [&]() { if (i + 1 < _argumentCount) { value = _arguments[++i]; return true; } std::cerr << "Missing value for " << argument << std::endl; return false; };
+		long number = 0;
+
+		if (argument == "-w" || argument == "--width") { if (!nextValue()) { return false; } if (!parseNumber(value, 1, UINT16_MAX, number)) { std::cerr << "Invalid width: " << value << std::endl; return false; } o_options.m_width = (uint16_t)number; }
+		else if (argument == "-h" || argument == "--height") { if (!nextValue()) { return false; } if (!parseNumber(value, 1, UINT16_MAX, number)) { std::cerr << "Invalid height: " << value << std::endl; return false; } o_options.m_height = (uint16_t)number; }
+		else if (argument == "-s" || argument == "--samples") { if (!nextValue()) { return false; } if (!parseNumber(value, 1, 16, number)) { std::cerr << "Invalid sample level: " << value << std::endl; return false; } o_options.m_settings.m_sampleLevel = (uint8_t)number; }
+		else if (argument == "-t" || argument == "--threads") { if (!nextValue()) { return false; } if (!parseNumber(value, 0, 1024, number)) { std::cerr << "Invalid thread count: " << value << std::endl; return false; } o_options.m_settings.m_threadAmount = (uint16_t)number; }
+		else if (argument == "--packet") { if (!nextValue()) { return false; } if (!parseNumber(value, 1, 16, number) || (number != 1 && number != 4 && number != 8 && number != 16)) { std::cerr << "Invalid packet size: " << value << std::endl; return false; } o_options.m_settings.m_packetSize = (uint8_t)number; }
+		else if (argument == "--terminate") { if (!nextValue()) { return false; } if (!parseTermination(value, o_options.m_settings.m_termination.m_mode)) { std::cerr << "Unknown termination: " << value << std::endl; return false; } }
+		else if (argument == "--threshold")
+		{
+			if (!nextValue()) { return false; }
+			char* end = nullptr;
+			float_t threshold = strtof(value, &end);
+			if (end == value || *end != '\0' || !(threshold >= 0.0f && threshold <= 1.0f)) { std::cerr << "Invalid threshold: " << value << std::endl; return false; }
+			o_options.m_settings.m_termination.m_threshold = threshold;
+		}
+		else if (argument == "--scene") { if (!nextValue()) { return false; } o_options.m_scene = value; }
+		else if (argument == "--generate") { if (!nextValue()) { return false; } if (!Scenes::SceneGenerator::TypeFromName(value, o_options.m_generator)) { std::cerr << "Unknown scene kind: " << value << std::endl; return false; } }
+		else if (argument == "--count") { if (!nextValue()) { return false; } if (!parseNumber(value, 1, Scenes::SceneGenerator::MaxSphereCount, number)) { std::cerr << "Invalid sphere count: " << value << std::endl; return false; } o_options.m_sphereCount = (uint32_t)number; }
+		else if (argument == "--seed") { if (!nextValue()) { return false; } if (!parseUnsigned(value, o_options.m_seed)) { std::cerr << "Invalid seed: " << value << std::endl; return false; } }
+		else if (argument == "--save-scene") { if (!nextValue()) { return false; } o_options.m_saveScenePath = value; }
+		else if (argument == "--telemetry") { if (!nextValue()) { return false; } o_options.m_telemetryPath = value; }
+		else if (argument == "--trace") { if (!nextValue()) { return false; } o_options.m_tracePath = value; }
+		else if (argument == "-o" || argument == "--output") { if (!nextValue()) { return false; } o_options.m_outputPath = value; }
+		else if (argument == "--tone-map") { if (!nextValue()) { return false; } if (!parseToneMapping(value, o_options.m_settings.m_toneMapping)) { std::cerr << "Unknown tone mapping: " << value << std::endl; return false; } }
+		else if (argument == "-f" || argument == "--format")
+		{
+			if (!nextValue()) { return false; }
+			if (!Output::ImageWriter::FormatFromPath(std::string(".") + value, o_options.m_format)) { std::cerr << "Unknown format: " << value << std::endl; return false; }
+			formatGiven = true;
+		}
+		else { std::cerr << "Unknown option: " << argument << std::endl; return false; }
+	}
+
+	// Take the format from the output's extension if it was not given.
+	if (!formatGiven && !Output::ImageWriter::FormatFromPath(o_options.m_outputPath, o_options.m_format)) { std::cerr << "Cannot tell the format of " << o_options.m_outputPath << ", use --format." << std::endl; return false; }
+
+	// A scene is either loaded or generated.
+	if (o_options.m_generator != Scenes::GeneratorType::Count && o_options.m_scene != "default") { std::cerr << "Use either --scene or --generate, not both." << std::endl; return false; }
+
+	// Make sure the scene can be saved before doing any work.
+	Scenes::SceneFormat sceneFormat;
+	if (!o_options.m_saveScenePath.empty() && !Scenes::SceneFile::FormatFromPath(o_options.m_saveScenePath, sceneFormat)) { std::cerr << "Cannot tell the format of " << o_options.m_saveScenePath << ", use .scene or .sceneb." << std::endl; return false; }
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	// Read the options from the command line.
+	Options options;
+	if (argc > 1 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-?")) { printUsage(argv[0]); return 0; }
+	if (!parseOptions(argc, argv, options)) { printUsage(argv[0]); return 1; }
+
+	// Record the frame's telemetry if asked to, starting before the scene is built so the hierarchy build is included.
+	std::ofstream telemetryFile;
+	Telemetry::Recorder& telemetry = Telemetry::Recorder::Get();
+	if (!options.m_telemetryPath.empty())
+	{
+		if (options.m_telemetryPath != "-")
+		{
+			telemetryFile.open(options.m_telemetryPath, std::ios::app);
+			if (!telemetryFile) { std::cerr << "Could not open " << options.m_telemetryPath << std::endl; return 1; }
+		}
+		telemetry.SetOutput((options.m_telemetryPath == "-") ? &std::cout : &telemetryFile);
+		telemetry.SetEnabled(true);
+	}
+	telemetry.BeginFrame();
+	if (!options.m_tracePath.empty()) { Telemetry::Timeline::Get().SetEnabled(true); }
+
+	// Generate the scene if asked to, otherwise map it if it is binary or load it, saving it again if asked to.
+	std::chrono::steady_clock::time_point loadTimer = std::chrono::steady_clock::now();
+	Scenes::Scene scene = Scenes::Scene::Default();
+	Scenes::MappedScene mappedScene;
+	std::string sceneError;
+	bool isMapped = options.m_scene != "default" && Scenes::MappedScene::IsMappedScene(options.m_scene);
+	if (isMapped && !mappedScene.Open(options.m_scene, sceneError)) { std::cerr << sceneError << std::endl; return 1; }
+	if (isMapped && options.m_validateScene && !mappedScene.Validate(sceneError)) { std::cerr << sceneError << std::endl; return 1; }
+	if (!isMapped && options.m_scene != "default" && !Scenes::SceneFile::Load(options.m_scene, scene, sceneError)) { std::cerr << sceneError << std::endl; return 1; }
+	bool isGenerated = options.m_generator != Scenes::GeneratorType::Count;
+	if (isGenerated) { scene = Scenes::SceneGenerator::Generate(options.m_generator, options.m_sphereCount, options.m_seed); }
+	double loadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadTimer).count();
+	if (isGenerated) { std::cout << "Generated " << Scenes::SceneGenerator::GetName(options.m_generator) << " scene from seed " << options.m_seed << " with " << scene.m_spheres.size() << " spheres and " << scene.m_materials.size() << " materials in " << loadTime << "ms" << std::endl; }
+	else if (isMapped) { std::cout << "Mapped scene \"" << options.m_scene << "\" with " << mappedScene.GetSphereCount() << " spheres and " << mappedScene.GetMaterials().size() << " materials in " << loadTime << "ms" << std::endl; }
+	else { std::cout << "Loaded scene \"" << options.m_scene << "\" with " << scene.m_spheres.size() << " spheres and " << scene.m_materials.size() << " materials in " << loadTime << "ms" << std::endl; }
+
+	Scenes::SceneFormat sceneFormat;
+	if (!options.m_saveScenePath.empty() && Scenes::SceneFile::FormatFromPath(options.m_saveScenePath, sceneFormat))
+	{
+		if (isMapped) { mappedScene.CopyTo(scene); }
+		if (!Scenes::SceneFile::Save(scene, options.m_saveScenePath, sceneFormat)) { std::cerr << "Could not write " << options.m_saveScenePath << std::endl; return 1; }
+		std::cout << "Saved scene to " << options.m_saveScenePath << std::endl;
+	}
+
+	// Create the world, which builds the hierarchy over the scene unless it was mapped with one.
+	std::chrono::steady_clock::time_point sceneTimer = std::chrono::steady_clock::now();
+	World world = isMapped ? World(glm::vec2(options.m_width, options.m_height), mappedScene) : World(glm::vec2(options.m_width, options.m_height), scene);
+	double sceneTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sceneTimer).count();
+	std::cout << "Built world in " << sceneTime << "ms (hierarchy " << world.GetBuildStats().m_milliseconds << "ms)" << std::endl;
+
+	// Render it, measuring the cost of each pixel if asked to.
+	std::unique_ptr<Telemetry::CostMap> costMap(options.m_writeCostMaps ? new Telemetry::CostMap(options.m_width, options.m_height) : nullptr);
+	std::chrono::steady_clock::time_point renderTimer = std::chrono::steady_clock::now();
+	Buffer& buffer = world.Draw(options.m_settings, nullptr, costMap.get());
+	double renderTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderTimer).count();
+	std::cout << "Rendered " << options.m_width << "x" << options.m_height << " at " << (int)options.m_settings.m_sampleLevel << "x" << (int)options.m_settings.m_sampleLevel << " samples with " << options.m_settings.GetThreadCount() << " threads in " << renderTime << "ms" << std::endl;
+
+	// Write it to disk, which takes the place of uploading it to the display.
+	std::chrono::steady_clock::time_point writeTimer = std::chrono::steady_clock::now();
+	bool didWrite;
+	{
+		Telemetry::ScopedSpan writeSpan("write image");
+		didWrite = Output::ImageWriter::Write(buffer, options.m_outputPath, options.m_format, options.m_settings.m_toneMapping);
+	}
+	std::chrono::steady_clock::duration writeDuration = std::chrono::steady_clock::now() - writeTimer;
+	double writeTime = std::chrono::duration<double, std::milli>(writeDuration).count();
+	delete &buffer;
+
+	// End the frame's record, which writes it out.
+	telemetry.AddTime(Telemetry::Phase::Upload, writeDuration);
+	Telemetry::FrameRecord record = telemetry.EndFrame(options.m_width, options.m_height, options.m_settings.GetThreadCount(), options.m_settings.m_sampleLevel);
+	telemetry.SetOutput(nullptr);
+	if (telemetry.IsEnabled())
+	{
+		const Telemetry::RayStats& rays = record.m_rayStats;
+		std::cout << "Traced " << rays.GetTotal() << " rays (" << rays.GetCount(Telemetry::RayType::Primary) << " primary, " << rays.GetCount(Telemetry::RayType::Shadow) << " shadow, " << rays.GetCount(Telemetry::RayType::Reflection) << " reflection) at " << record.GetMegaraysPerSecond() << " Mrays/s" << std::endl;
+	}
+
+	if (!didWrite) { std::cerr << "Could not write " << options.m_outputPath << std::endl; return 1; }
+	std::cout << "Wrote " << options.m_outputPath << " in " << writeTime << "ms" << std::endl;
+
+	// Write each cost map next to the output, in the same format.
+	if (costMap != nullptr)
+	{
+		size_t extension = options.m_outputPath.find_last_of('.');
+		size_t separator = options.m_outputPath.find_last_of("/\\");
+		if (extension == std::string::npos || (separator != std::string::npos && extension < separator)) { extension = options.m_outputPath.size(); }
+
+		for (size_t m = 0; m < (size_t)Telemetry::CostMetric::Count; m++)
+		{
+			Telemetry::CostMetric metric = (Telemetry::CostMetric)m;
+			std::string costPath = options.m_outputPath.substr(0, extension) + "_cost_" + Telemetry::GetName(metric) + options.m_outputPath.substr(extension);
+			Buffer& costImage = costMap->CreateImage(metric);
+			bool didWriteCost = Output::ImageWriter::Write(costImage, costPath, options.m_format);
+			delete &costImage;
+			if (!didWriteCost) { std::cerr << "Could not write " << costPath << std::endl; return 1; }
+
+			double pixelCount = (double)options.m_width * options.m_height;
+			std::cout << "Wrote " << costPath << " (mean " << costMap->GetTotal(metric) / pixelCount << ", max " << costMap->GetMaximum(metric) << ")" << std::endl;
+		}
+	}
+
+	// Write the trace last, so that writing the image is part of it.
+	if (!options.m_tracePath.empty())
+	{
+		if (!Telemetry::Timeline::Get().WriteFrame(options.m_tracePath)) { std::cerr << "Could not write " << options.m_tracePath << std::endl; return 1; }
+		std::cout << "Wrote trace to " << options.m_tracePath << std::endl;
+	}
+	return 0;
+}
\ No newline at end of file